@@ -0,0 +1,106 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+/*
+    GDS2 writer benchmark.
+
+    Writes the requested number of pad cells to a GDS2 file
+    as SREF records, spread over the four edges, and reports
+    the number of records and megabytes written per second.
+
+    usage: gds2bench [number of cells] [gds2 filename]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include "../src/logging.h"
+#include "../src/layout.h"
+#include "../src/gds2/gds2writer.h"
+
+int main(int argc, char *argv[])
+{
+    size_t cells = 1000000;
+    std::string filename = "gds2bench.gds";
+
+    if (argc > 1)
+    {
+        cells = strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2)
+    {
+        filename = argv[2];
+    }
+
+    setLogLevel(LOG_QUIET);
+
+    PRLEFReader::LEFCellInfo_t lefinfo;
+    lefinfo.m_name = "IOCELL";
+    lefinfo.m_sx = 80.0;
+    lefinfo.m_sy = 120.0;
+
+    LayoutItem item(LayoutItem::TYPE_CELL);
+    item.m_cellname = internSymbol("IOCELL");
+    item.m_lefinfo  = &lefinfo;
+    item.m_size     = toDBU(lefinfo.m_sx, 1000.0);
+
+    static const location_t locations[4] = {LOC_N, LOC_S, LOC_E, LOC_W};
+
+    printf("Writing %lu SREFs to %s\n", static_cast<unsigned long>(cells), filename.c_str());
+
+    typedef std::chrono::steady_clock clock;
+    auto start = clock::now();
+
+    GDS2Writer *writer = GDS2Writer::open(filename, "GDS2BENCH");
+    if (writer == nullptr)
+    {
+        printf("Cannot open %s\n", filename.c_str());
+        return 1;
+    }
+
+    for(size_t i=0; i<cells; i++)
+    {
+        item.m_location = locations[i % 4];
+        item.m_flipped  = ((i / 4) % 2) == 1;
+        item.m_x = static_cast<dbu_t>(i / 4) * toDBU(lefinfo.m_sx, 1000.0);
+        item.m_y = static_cast<dbu_t>(i % 4) * toDBU(lefinfo.m_sy, 1000.0);
+
+        PlacedCell cell;
+        PlacementStream::resolve(&item, 1000.0, cell);
+        writer->writeCell(cell);
+    }
+    delete writer;
+
+    std::chrono::duration<double> elapsed = clock::now() - start;
+
+    std::ifstream sizestream(filename, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+    size_t bytes = sizestream.tellg();
+
+    printf("%-8s : %8.3f s  %8.2f M records/s  %8.1f MB/s  (%lu bytes)\n", "sref", elapsed.count(),
+        static_cast<double>(cells) / 1.0e6 / elapsed.count(),
+        static_cast<double>(bytes) / (1024.0*1024.0) / elapsed.count(),
+        static_cast<unsigned long>(bytes));
+
+    remove(filename.c_str());
+    return 0;
+}
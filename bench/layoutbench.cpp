@@ -0,0 +1,135 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+/*
+    Layout engine benchmark.
+
+    Fills the four edges of a padring with the requested
+    number of pad cells per edge, every fourth pad followed
+    by a bond pad, and measures how long it takes to add
+    the items, to lay out the edges and to walk the placed
+    items the way the writers do.
+
+    usage: layoutbench [items per edge]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+
+#include "../src/logging.h"
+#include "../src/layout.h"
+
+int main(int argc, char *argv[])
+{
+    size_t itemsPerEdge = 1000000;
+
+    if (argc > 1)
+    {
+        itemsPerEdge = strtoul(argv[1], nullptr, 10);
+    }
+
+    setLogLevel(LOG_QUIET);
+
+    // sizes in nanometers
+    const dbu_t padWidth  = 80000;
+    const dbu_t padHeight = 120000;
+    const dbu_t dieSize   = static_cast<dbu_t>(itemsPerEdge) * padWidth * 3 / 2 + 2*padHeight;
+
+    printf("Laying out %lu items per edge\n", static_cast<unsigned long>(itemsPerEdge));
+
+    typedef std::chrono::steady_clock clock;
+
+    Layout edges[4] = 
+    {
+        Layout(Layout::DIR_HORIZONTAL, Layout::SIDE_NORTH),
+        Layout(Layout::DIR_HORIZONTAL, Layout::SIDE_SOUTH),
+        Layout(Layout::DIR_VERTICAL, Layout::SIDE_EAST),
+        Layout(Layout::DIR_VERTICAL, Layout::SIDE_WEST)
+    };
+
+    symbol_t padName  = internSymbol("IOCELL");
+    symbol_t bondName = internSymbol("BONDPAD");
+
+    auto start = clock::now();
+    for(auto &edge : edges)
+    {
+        edge.setDieSize(dieSize);
+        edge.setGrid(1);
+        edge.setEdgePos(0);
+
+        LayoutItem corner(LayoutItem::TYPE_CORNER);
+        corner.m_size = padHeight;
+        edge.setFirstCorner(corner);
+        edge.setLastCorner(corner);
+
+        for(size_t i=0; i<itemsPerEdge; i++)
+        {
+            LayoutItem pad(LayoutItem::TYPE_CELL);
+            pad.m_cellname = padName;
+            pad.m_size  = padWidth;
+            pad.m_osize = padHeight;
+            edge.addItem(pad);
+
+            if ((i % 4) == 0)
+            {
+                LayoutItem bond(LayoutItem::TYPE_BOND);
+                bond.m_cellname = bondName;
+                bond.m_size  = padWidth / 2;
+                bond.m_osize = padHeight / 2;
+                bond.m_flipped = true;
+                edge.addItem(bond);
+            }
+        }
+    }
+    std::chrono::duration<double> addTime = clock::now() - start;
+
+    start = clock::now();
+    for(auto &edge : edges)
+    {
+        if (!edge.doLayout())
+        {
+            printf("Layout failed\n");
+            return 1;
+        }
+    }
+    std::chrono::duration<double> layoutTime = clock::now() - start;
+
+    start = clock::now();
+    dbu_t checksum = 0;
+    size_t items = 0;
+    for(auto &edge : edges)
+    {
+        for(auto item : edge)
+        {
+            checksum += item->m_x + item->m_y + item->m_size;
+            items++;
+        }
+    }
+    std::chrono::duration<double> walkTime = clock::now() - start;
+
+    printf("%-8s : %8.3f s\n", "add", addTime.count());
+    printf("%-8s : %8.3f s  (%.1f ns/item)\n", "layout", layoutTime.count(), 
+        layoutTime.count() * 1e9 / static_cast<double>(items));
+    printf("%-8s : %8.3f s  (%lu items, checksum %lld)\n", "walk", walkTime.count(), 
+        static_cast<unsigned long>(items), static_cast<long long>(checksum));
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+/*
+    LEF reader throughput benchmark.
+
+    Generates a synthetic LEF library of the requested size
+    and measures how fast the memory-mapped and the
+    stream-based LEF readers can parse it, and how fast
+    the memory-mapped reader is when it skips all but a
+    handful of macros. The database run also builds and
+    frees the padring cell database.
+
+    usage: lefbench [size in MB] [lef filename]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include "../src/logging.h"
+#include "../src/lef/lefreader.h"
+#include "../src/prlefreader.h"
+
+/** LEF reader that only counts what it sees */
+class CountingLEFReader : public LEFReader
+{
+public:
+    CountingLEFReader() : m_macros(0), m_pins(0) {}
+
+    virtual void onMacro(const std::string &macroName) override
+    {
+        m_macros++;
+    }
+
+    virtual void onPin(const std::string &pinName) override
+    {
+        m_pins++;
+    }
+
+    /** only want IOCELL_0 .. IOCELL_9 */
+    virtual bool isMacroWanted(const std::string_view &macroName,
+        const std::string_view &className) override
+    {
+        return macroName.size() <= 8;
+    }
+
+    uint64_t m_macros;
+    uint64_t m_pins;
+};
+
+/** write one IO cell macro with a number of pins and obstructions */
+static size_t writeMacro(std::ofstream &os, uint32_t index)
+{
+    std::string name = "IOCELL_" + std::to_string(index);
+    std::string txt;
+
+    txt += "MACRO " + name + "\n";
+    txt += "  CLASS PAD INOUT ;\n";
+    txt += "  FOREIGN " + name + " 0 0 ;\n";
+    txt += "  ORIGIN 0 0 ;\n";
+    txt += "  SIZE 80.000 BY 120.000 ;\n";
+    txt += "  SYMMETRY X Y R90 ;\n";
+    txt += "  SITE IOSITE ;\n";
+    for(uint32_t pin=0; pin<16; pin++)
+    {
+        std::string pinName = "P" + std::to_string(pin);
+        txt += "  PIN " + pinName + "\n";
+        txt += "    DIRECTION INOUT ;\n";
+        txt += "    USE SIGNAL ;\n";
+        txt += "    PORT\n";
+        txt += "      LAYER METAL2 ;\n";
+        for(uint32_t r=0; r<8; r++)
+        {
+            txt += "        RECT " + std::to_string(pin*4) + ".125 " + std::to_string(r*10) 
+                + ".250 " + std::to_string(pin*4+2) + ".125 " + std::to_string(r*10+5) + ".250 ;\n";
+        }
+        txt += "      END\n";
+        txt += "    END " + pinName + "\n";
+    }
+    txt += "END " + name + "\n\n";
+
+    os << txt;
+    return txt.size();
+}
+
+static void generateLEF(const std::string &filename, size_t bytes)
+{
+    std::ofstream os(filename, std::ofstream::out | std::ofstream::binary);
+
+    std::string header = "VERSION 5.7 ;\nBUSBITCHARS \"[]\" ;\nDIVIDERCHAR \"/\" ;\n\n"
+        "UNITS\n  DATABASE MICRONS 1000 ;\nEND UNITS\n\n";
+
+    os << header;
+    size_t written = header.size();
+    uint32_t index = 0;
+    while(written < bytes)
+    {
+        written += writeMacro(os, index++);
+    }
+    os << "END LIBRARY\n";
+}
+
+static double report(const char *name, const CountingLEFReader &reader, double seconds, size_t bytes)
+{
+    double mbs = static_cast<double>(bytes) / (1024.0*1024.0) / seconds;
+    printf("%-8s : %8.3f s  %8.1f MB/s  (%lu macros, %lu pins)\n", name, seconds, mbs,
+        static_cast<unsigned long>(reader.m_macros),
+        static_cast<unsigned long>(reader.m_pins));
+    return mbs;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t megabytes = 256;
+    std::string filename = "lefbench.lef";
+
+    if (argc > 1)
+    {
+        megabytes = strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2)
+    {
+        filename = argv[2];
+    }
+
+    setLogLevel(LOG_QUIET);
+
+    printf("Generating %lu MB synthetic LEF file %s\n", static_cast<unsigned long>(megabytes), filename.c_str());
+    generateLEF(filename, megabytes*1024*1024);
+
+    std::ifstream sizestream(filename, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+    size_t bytes = sizestream.tellg();
+
+    typedef std::chrono::steady_clock clock;
+
+    {
+        CountingLEFReader reader;
+        auto start = clock::now();
+        reader.parseFile(filename);
+        std::chrono::duration<double> elapsed = clock::now() - start;
+        report("mmap", reader, elapsed.count(), bytes);
+    }
+
+    {
+        // full cell database, as used by padring
+        auto start = clock::now();
+        PRLEFReader *reader = new PRLEFReader();
+        reader->parseFile(filename);
+        size_t cells = reader->m_cells.size();
+        delete reader;
+        std::chrono::duration<double> elapsed = clock::now() - start;
+        double mbs = static_cast<double>(bytes) / (1024.0*1024.0) / elapsed.count();
+        printf("%-8s : %8.3f s  %8.1f MB/s  (%lu cells, including teardown)\n", "database",
+            elapsed.count(), mbs, static_cast<unsigned long>(cells));
+    }
+
+    {
+        CountingLEFReader reader;
+        reader.setMacroSkipping(true);
+        auto start = clock::now();
+        reader.parseFile(filename);
+        std::chrono::duration<double> elapsed = clock::now() - start;
+        report("skip", reader, elapsed.count(), bytes);
+    }
+
+    {
+        CountingLEFReader reader;
+        auto start = clock::now();
+        std::ifstream lefstream(filename, std::ifstream::in);
+        reader.parse(lefstream);
+        std::chrono::duration<double> elapsed = clock::now() - start;
+        report("istream", reader, elapsed.count(), bytes);
+    }
+
+    remove(filename.c_str());
+    return 0;
+}
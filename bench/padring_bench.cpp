@@ -0,0 +1,619 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+/*
+    Padring phase benchmark with regression thresholds.
+
+    Generates fixed synthetic workloads with the padgen
+    generator and runs each phase of padring on them a
+    number of times: LEF parsing, configuration parsing,
+    edge layout, filler expansion and each of the writers.
+    Reports the median and 95th percentile time and the
+    number of heap allocations of every phase.
+
+    With a baseline file, every phase is compared against
+    the baseline and the program exits with 1 when a phase
+    allocates more than the tolerance in the baseline allows.
+    Allocation counts do not depend on the machine or the
+    build type; times do, so they are only checked with
+    --check-time, against a baseline written on the same
+    machine with the same build type.
+
+    usage: padring_bench [--iterations n] [--baseline file] 
+                         [--check-time] [--write-baseline file]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <memory>
+#include <map>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+
+#include "../src/logging.h"
+#include "../src/prlefreader.h"
+#include "../src/padringdb.h"
+#include "../src/fillerhandler.h"
+#include "../src/edgeplacer.h"
+#include "../src/placement.h"
+#include "../src/svgwriter.h"
+#include "../src/defwriter.h"
+#include "../src/verilogwriter.h"
+#include "../src/csvwriter.h"
+#include "../src/gds2/gds2writer.h"
+#include "../src/padgen/padgenerator.h"
+
+// count the heap allocations of the whole program
+
+static std::atomic<uint64_t> gs_allocations(0);
+
+void* operator new(size_t size)
+{
+    gs_allocations.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+/** a synthetic workload */
+struct workload_t
+{
+    const char      *m_name;
+    padgenParams_t  m_params;
+};
+
+/** measurements of one phase */
+struct phaseResult_t
+{
+    double      m_median;       ///< in milliseconds
+    double      m_p95;          ///< in milliseconds
+    uint64_t    m_allocations;  ///< median allocations per run
+};
+
+/** default tolerances written to a new baseline */
+static const double gs_timeTolerance  = 0.5;
+static const double gs_allocTolerance = 0.05;
+
+/** time differences below this are noise, in milliseconds */
+static const double gs_minTimeSlack = 0.05;
+
+static const char *gs_phaseNames[] =
+{
+    "lef_parse", "config_parse", "layout", "fillers",
+    "write_gds2", "write_def", "write_svg", "write_verilog", "write_csv"
+};
+
+static const size_t gs_phaseCount = sizeof(gs_phaseNames) / sizeof(gs_phaseNames[0]);
+
+/** locations of the edges, in writing order */
+static const location_t gs_edgeLocations[4] = {LOC_N, LOC_S, LOC_W, LOC_E};
+
+static std::vector<workload_t> getWorkloads()
+{
+    std::vector<workload_t> workloads;
+
+    workload_t small;
+    small.m_name = "small";
+    small.m_params.m_seed = 1;
+    small.m_params.m_padsPerEdge = 200;
+    small.m_params.m_macros = 32;
+    small.m_params.m_fillerSwitches = 2;
+    workloads.push_back(small);
+
+    // over 100k placed pads
+    workload_t large;
+    large.m_name = "large";
+    large.m_params.m_seed = 2;
+    large.m_params.m_padsPerEdge = 25000;
+    large.m_params.m_macros = 2000;
+    large.m_params.m_pins = 16;
+    large.m_params.m_obsRects = 8;
+    large.m_params.m_fillerSwitches = 10;
+    workloads.push_back(large);
+
+    return workloads;
+}
+
+/** median and 95th percentile (nearest rank) of the samples */
+static void getPercentiles(std::vector<double> samples, double &median, double &p95)
+{
+    std::sort(samples.begin(), samples.end());
+    median = samples[samples.size() / 2];
+    size_t rank = (samples.size() * 95 + 99) / 100;
+    p95 = samples[std::max<size_t>(rank, 1) - 1];
+}
+
+/** everything the phases of one workload work on */
+class BenchWorkload
+{
+public:
+    explicit BenchWorkload(const workload_t &workload) : m_padring(m_library)
+    {
+        PadGenerator generator(workload.m_params);
+        std::ostringstream lef;
+        std::ostringstream config;
+        generator.writeLEF(lef);
+        generator.writeConfig(config);
+        m_lef = lef.str();
+        m_config = config.str();
+
+        // the reference database for the later phases
+        m_library.parse(m_lef.data(), m_lef.size());
+        m_databaseUnits = (m_library.m_lefDatabaseUnits > 1e-12) ? m_library.m_lefDatabaseUnits : 1000.0;
+        m_padring.setDatabaseUnits(m_databaseUnits);
+        m_padring.parse(m_config.data(), m_config.size());
+    }
+
+    /** run a phase, returns the time in milliseconds
+        and the number of allocations */
+    double run(size_t phase, uint64_t &allocations)
+    {
+        // untimed preparation
+        if (phase == 2)
+        {
+            createPlacers();
+        }
+
+        uint64_t startAllocations = gs_allocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+
+        switch(phase)
+        {
+        case 0:
+            {
+                PRLEFReader reader;
+                reader.parse(m_lef.data(), m_lef.size());
+            }
+            break;
+        case 1:
+            {
+                PadringDB padring(m_library);
+                padring.setDatabaseUnits(m_databaseUnits);
+                padring.parse(m_config.data(), m_config.size());
+            }
+            break;
+        case 2:
+            for(auto &placer : m_placers)
+            {
+                placer->layout();
+            }
+            break;
+        case 3:
+            fillSpaces();
+            break;
+        default:
+            writeOutput(phase);
+            break;
+        }
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        allocations = gs_allocations.load(std::memory_order_relaxed) - startAllocations;
+
+        if (phase == 3)
+        {
+            resolveCells();
+        }
+        return elapsed.count();
+    }
+
+protected:
+    /** fresh copies of the edges, with a placer for each */
+    void createPlacers()
+    {
+        dbu_t grid = m_padring.getGrid();
+        Layout *edges[4] = {&m_padring.m_north, &m_padring.m_south, &m_padring.m_west, &m_padring.m_east};
+        dbu_t edgePositions[4] = {m_padring.toDBU(m_padring.m_dieHeight), 0, 0, m_padring.toDBU(m_padring.m_dieWidth)};
+        for(size_t i=0; i<4; i++)
+        {
+            m_edges[i].reset(new Layout(*edges[i]));
+            m_placers[i].reset(new EdgePlacer(m_edges[i].get(), gs_edgeLocations[i], edgePositions[i], grid));
+        }
+    }
+
+    /** build the filler tables and fill the laid out edges,
+        as PadringSession::layout does */
+    void fillSpaces()
+    {
+        FillerHandler fillers(m_databaseUnits);
+        fillers.addFillers(&m_library, m_padring.m_fillers);
+        fillers.setGrid(m_padring.getGrid());
+        fillers.prepare(std::max(m_padring.toDBU(m_padring.m_dieWidth), m_padring.toDBU(m_padring.m_dieHeight)));
+
+        FillerHandler current(fillers);
+        for(auto &placer : m_placers)
+        {
+            placer->prepareFillers(current, &m_library);
+            placer->fillSpaces();
+        }
+    }
+
+    /** the placed cells in writing order, for the writers */
+    void resolveCells()
+    {
+        m_cells.clear();
+        auto add = [&](const LayoutItem *item)
+        {
+            PlacedCell cell;
+            if ((item != nullptr) && PlacementStream::resolve(item, m_databaseUnits, cell))
+            {
+                m_cells.push_back(cell);
+            }
+        };
+
+        add(m_placers[0]->getFirstCorner());
+        add(m_placers[0]->getLastCorner());
+        add(m_placers[1]->getFirstCorner());
+        add(m_placers[1]->getLastCorner());
+        for(auto &placer : m_placers)
+        {
+            for(auto const &item : placer->getItems())
+            {
+                add(&item);
+            }
+        }
+    }
+
+    void writeOutput(size_t phase)
+    {
+        OutputSink *sink = nullptr;
+        switch(phase)
+        {
+        case 4:
+            sink = GDS2Writer::open("padring_bench.gds", m_padring.m_designName);
+            break;
+        case 5:
+            {
+                DEFWriter *def = DEFWriter::open("padring_bench.def", 
+                    m_padring.toDBU(m_padring.m_dieWidth), m_padring.toDBU(m_padring.m_dieHeight));
+                def->setDatabaseUnits(m_library.m_lefDatabaseUnits);
+                def->setDesignName(m_padring.m_designName);
+                sink = def;
+            }
+            break;
+        case 6:
+            sink = SVGWriter::open("padring_bench.svg", m_padring.m_dieWidth, m_padring.m_dieHeight);
+            break;
+        case 7:
+            {
+                VerilogWriter *ver = VerilogWriter::open("padring_bench.v");
+                ver->setDesignName(m_padring.m_designName);
+                sink = ver;
+            }
+            break;
+        default:
+            sink = CSVWriter::open("padring_bench.csv", &m_padring);
+            break;
+        }
+
+        sink->onBegin(static_cast<uint32_t>(m_cells.size()), m_databaseUnits);
+        for(size_t i=0; i<m_cells.size(); i+=4096)
+        {
+            sink->onCells(&m_cells[i], std::min<size_t>(4096, m_cells.size() - i));
+        }
+        sink->onFinish([&](const OutputSink::cellVisitor_t &visit)
+        {
+            for(auto const &cell : m_cells)
+            {
+                visit(cell);
+            }
+        });
+        delete sink;
+    }
+
+    std::string     m_lef;
+    std::string     m_config;
+    double          m_databaseUnits;
+    PRLEFReader     m_library;
+    PadringDB       m_padring;
+
+    std::unique_ptr<Layout>     m_edges[4];
+    std::unique_ptr<EdgePlacer> m_placers[4];
+    std::vector<PlacedCell>     m_cells;
+};
+
+/** Reads the numbers of a JSON document into a map
+    from their dotted path, such as 'tolerance.time'.
+    Strings, booleans and nulls are skipped. */
+class JSONNumbers
+{
+public:
+    bool parse(const std::string &text, std::map<std::string, double> &values)
+    {
+        m_ptr = text.c_str();
+        m_values = &values;
+        return parseValue("") && (skipSpace(), *m_ptr == 0);
+    }
+
+protected:
+    void skipSpace()
+    {
+        while(isspace(static_cast<unsigned char>(*m_ptr))) m_ptr++;
+    }
+
+    bool parseString(std::string &str)
+    {
+        skipSpace();
+        if (*m_ptr != '"') return false;
+        m_ptr++;
+        str.clear();
+        while((*m_ptr != 0) && (*m_ptr != '"'))
+        {
+            if ((*m_ptr == '\\') && (m_ptr[1] != 0)) m_ptr++;
+            str += *m_ptr++;
+        }
+        if (*m_ptr != '"') return false;
+        m_ptr++;
+        return true;
+    }
+
+    bool parseValue(const std::string &path)
+    {
+        skipSpace();
+        std::string str;
+        switch(*m_ptr)
+        {
+        case '{':
+            m_ptr++;
+            skipSpace();
+            if (*m_ptr == '}') { m_ptr++; return true; }
+            while(true)
+            {
+                std::string key;
+                if (!parseString(key)) return false;
+                skipSpace();
+                if (*m_ptr++ != ':') return false;
+                if (!parseValue(path.empty() ? key : (path + "." + key))) return false;
+                skipSpace();
+                if (*m_ptr == ',') { m_ptr++; continue; }
+                if (*m_ptr++ == '}') return true;
+                return false;
+            }
+        case '[':
+            m_ptr++;
+            skipSpace();
+            if (*m_ptr == ']') { m_ptr++; return true; }
+            for(size_t index=0; ; index++)
+            {
+                if (!parseValue(path + "." + std::to_string(index))) return false;
+                skipSpace();
+                if (*m_ptr == ',') { m_ptr++; continue; }
+                if (*m_ptr++ == ']') return true;
+                return false;
+            }
+        case '"':
+            return parseString(str);
+        default:
+            if (isalpha(static_cast<unsigned char>(*m_ptr)))
+            {
+                while(isalpha(static_cast<unsigned char>(*m_ptr))) m_ptr++;
+                return true;
+            }
+            else
+            {
+                char *end;
+                double v = strtod(m_ptr, &end);
+                if (end == m_ptr) return false;
+                m_ptr = end;
+                (*m_values)[path] = v;
+                return true;
+            }
+        }
+    }
+
+    const char *m_ptr;
+    std::map<std::string, double> *m_values;
+};
+
+static void writeBaseline(const std::string &filename, 
+    const std::vector<workload_t> &workloads, 
+    const std::vector<std::vector<phaseResult_t> > &results)
+{
+    std::ofstream os(filename, std::ofstream::out);
+    os << "{\n";
+    os << "  \"tolerance\": { \"time\": " << gs_timeTolerance << ", \"allocations\": " << gs_allocTolerance << " },\n";
+    os << "  \"workloads\": {\n";
+    for(size_t w=0; w<workloads.size(); w++)
+    {
+        os << "    \"" << workloads[w].m_name << "\": {\n";
+        for(size_t p=0; p<gs_phaseCount; p++)
+        {
+            char line[256];
+            snprintf(line, sizeof(line), 
+                "      \"%s\": { \"median_ms\": %.3f, \"p95_ms\": %.3f, \"allocations\": %llu }%s\n",
+                gs_phaseNames[p], results[w][p].m_median, results[w][p].m_p95,
+                static_cast<unsigned long long>(results[w][p].m_allocations),
+                (p+1 < gs_phaseCount) ? "," : "");
+            os << line;
+        }
+        os << "    }" << ((w+1 < workloads.size()) ? ",\n" : "\n");
+    }
+    os << "  }\n}\n";
+}
+
+int main(int argc, char *argv[])
+{
+    size_t iterations = 11;
+    std::string baselineFile;
+    std::string writeBaselineFile;
+    bool checkTime = false;
+
+    for(int i=1; i<argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--iterations") && (i+1 < argc))
+        {
+            iterations = std::max<size_t>(strtoul(argv[++i], nullptr, 10), 1);
+        }
+        else if ((arg == "--baseline") && (i+1 < argc))
+        {
+            baselineFile = argv[++i];
+        }
+        else if (arg == "--check-time")
+        {
+            checkTime = true;
+        }
+        else if ((arg == "--write-baseline") && (i+1 < argc))
+        {
+            writeBaselineFile = argv[++i];
+        }
+        else
+        {
+            printf("usage: padring_bench [--iterations n] [--baseline file] [--check-time] [--write-baseline file]\n");
+            return 1;
+        }
+    }
+
+    setLogLevel(LOG_QUIET);
+
+    std::map<std::string, double> baseline;
+    if (!baselineFile.empty())
+    {
+        std::ifstream is(baselineFile, std::ifstream::in);
+        std::stringstream ss;
+        ss << is.rdbuf();
+        JSONNumbers reader;
+        if ((!is.is_open()) || (!reader.parse(ss.str(), baseline)))
+        {
+            printf("Cannot read baseline %s\n", baselineFile.c_str());
+            return 1;
+        }
+    }
+
+    double timeTolerance  = baseline.count("tolerance.time") ? baseline["tolerance.time"] : gs_timeTolerance;
+    double allocTolerance = baseline.count("tolerance.allocations") ? baseline["tolerance.allocations"] : gs_allocTolerance;
+
+    std::vector<workload_t> workloads = getWorkloads();
+    std::vector<std::vector<phaseResult_t> > results(workloads.size());
+
+    uint32_t regressions = 0;
+
+    printf("%-8s %-14s %10s %10s %10s  %s\n", "workload", "phase", "median ms", "p95 ms", "allocs", "baseline");
+    for(size_t w=0; w<workloads.size(); w++)
+    {
+        BenchWorkload bench(workloads[w]);
+
+        std::vector<std::vector<double> > times(gs_phaseCount);
+        std::vector<std::vector<double> > allocs(gs_phaseCount);
+
+        // the phases run in order, as they depend on each other
+        for(size_t i=0; i<iterations; i++)
+        {
+            for(size_t p=0; p<gs_phaseCount; p++)
+            {
+                uint64_t allocations = 0;
+                times[p].push_back(bench.run(p, allocations));
+                allocs[p].push_back(static_cast<double>(allocations));
+            }
+        }
+
+        for(size_t p=0; p<gs_phaseCount; p++)
+        {
+            phaseResult_t result;
+            double allocMedian;
+            double allocP95;
+            getPercentiles(times[p], result.m_median, result.m_p95);
+            getPercentiles(allocs[p], allocMedian, allocP95);
+            result.m_allocations = static_cast<uint64_t>(allocMedian);
+            results[w].push_back(result);
+
+            std::string key = std::string("workloads.") + workloads[w].m_name + "." + gs_phaseNames[p];
+            std::string status;
+            if (!baselineFile.empty())
+            {
+                if ((baseline.count(key + ".median_ms") == 0) || (baseline.count(key + ".allocations") == 0))
+                {
+                    status = "new";
+                }
+                else
+                {
+                    double baseTime  = baseline[key + ".median_ms"];
+                    double baseAlloc = baseline[key + ".allocations"];
+                    char text[128];
+                    snprintf(text, sizeof(text), "%.3f ms %.0f allocs", baseTime, baseAlloc);
+                    status = text;
+                    if (checkTime && (result.m_median > (baseTime * (1.0 + timeTolerance) + gs_minTimeSlack)))
+                    {
+                        status += "  SLOWER";
+                        regressions++;
+                    }
+                    if (static_cast<double>(result.m_allocations) > ceil(baseAlloc * (1.0 + allocTolerance)))
+                    {
+                        status += "  MORE ALLOCATIONS";
+                        regressions++;
+                    }
+                }
+            }
+
+            printf("%-8s %-14s %10.3f %10.3f %10llu  %s\n", workloads[w].m_name, gs_phaseNames[p],
+                result.m_median, result.m_p95, 
+                static_cast<unsigned long long>(result.m_allocations), status.c_str());
+        }
+    }
+
+    remove("padring_bench.gds");
+    remove("padring_bench.def");
+    remove("padring_bench.svg");
+    remove("padring_bench.v");
+    remove("padring_bench.csv");
+
+    if (!writeBaselineFile.empty())
+    {
+        writeBaseline(writeBaselineFile, workloads, results);
+        printf("Baseline written to %s\n", writeBaselineFile.c_str());
+    }
+
+    if (regressions > 0)
+    {
+        if (checkTime)
+        {
+            printf("%d regressions (tolerance: time %.0f%%, allocations %.0f%%)\n", 
+                regressions, timeTolerance*100.0, allocTolerance*100.0);
+        }
+        else
+        {
+            printf("%d regressions (tolerance: allocations %.0f%%)\n", 
+                regressions, allocTolerance*100.0);
+        }
+        return 1;
+    }
+    return 0;
+}
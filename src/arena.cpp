@@ -0,0 +1,88 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+Arena::Arena(size_t blockSize)
+    : m_ptr(nullptr), m_end(nullptr), m_blockSize(blockSize), m_reserved(0)
+{
+}
+
+Arena::~Arena()
+{
+    for(auto block : m_blocks)
+    {
+        free(block);
+    }
+}
+
+void Arena::addBlock(size_t bytes)
+{
+    char *block = static_cast<char*>(malloc(bytes));
+    if (block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    m_blocks.push_back(block);
+    m_ptr = block;
+    m_end = block + bytes;
+    m_reserved += bytes;
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment)
+{
+    uintptr_t addr = (reinterpret_cast<uintptr_t>(m_ptr) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    if ((m_ptr == nullptr) || (addr + bytes > reinterpret_cast<uintptr_t>(m_end)))
+    {
+        // start a new block. the remainder of
+        // the current block is wasted.
+        size_t needed = bytes + alignment;
+        addBlock((needed > m_blockSize) ? needed : m_blockSize);
+        addr = (reinterpret_cast<uintptr_t>(m_ptr) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    }
+
+    m_ptr = reinterpret_cast<char*>(addr + bytes);
+    return reinterpret_cast<void*>(addr);
+}
+
+std::string_view Arena::copyString(const std::string_view &str)
+{
+    char *dst = static_cast<char*>(allocate(str.size() + 1, 1));
+    if (!str.empty())
+    {
+        memcpy(dst, str.data(), str.size());
+    }
+    dst[str.size()] = 0;
+    return std::string_view(dst, str.size());
+}
+
+void Arena::adopt(Arena &other)
+{
+    // keep allocating from our own current block
+    m_blocks.insert(m_blocks.end(), other.m_blocks.begin(), other.m_blocks.end());
+    m_reserved += other.m_reserved;
+
+    other.m_blocks.clear();
+    other.m_ptr = nullptr;
+    other.m_end = nullptr;
+    other.m_reserved = 0;
+}
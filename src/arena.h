@@ -0,0 +1,121 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef arena_h
+#define arena_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <cstddef>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/** bump allocator.
+
+    Memory is handed out from large blocks and only released
+    when the arena is destroyed, so objects allocated in an
+    arena must not need their destructors to run.
+*/
+class Arena
+{
+public:
+    /** blockSize is the size of each block in bytes.
+        Larger allocations get a block of their own. */
+    explicit Arena(size_t blockSize = 64*1024);
+    virtual ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena& operator=(const Arena &) = delete;
+
+    /** allocate uninitialised memory */
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    /** allocate and default-construct an object */
+    template<class T> T* create()
+    {
+        static_assert(std::is_trivially_destructible<T>::value,
+            "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T();
+    }
+
+    /** allocate and default-construct an array of objects */
+    template<class T> T* createArray(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value,
+            "arena objects are never destroyed");
+        if (count == 0)
+        {
+            return nullptr;
+        }
+        T *items = static_cast<T*>(allocate(sizeof(T)*count, alignof(T)));
+        for(size_t i=0; i<count; i++)
+        {
+            new (items + i) T();
+        }
+        return items;
+    }
+
+    /** copy a string into the arena. The copy is zero terminated. */
+    std::string_view copyString(const std::string_view &str);
+
+    /** take over all the memory of another arena.
+        Pointers into the other arena remain valid.
+    */
+    void adopt(Arena &other);
+
+    /** number of bytes allocated from the system */
+    size_t getReservedBytes() const
+    {
+        return m_reserved;
+    }
+
+protected:
+    void addBlock(size_t bytes);
+
+    std::vector<char*>  m_blocks;       ///< all blocks owned by this arena
+    char                *m_ptr;         ///< next free byte in the current block
+    char                *m_end;         ///< end of the current block
+    size_t              m_blockSize;    ///< default block size
+    size_t              m_reserved;     ///< total size of all blocks
+};
+
+
+/** non-owning view of a contiguous array, typically in an arena */
+template<class T> class ArenaArray
+{
+public:
+    ArenaArray() : m_data(nullptr), m_size(0) {}
+    ArenaArray(T *data, uint32_t size) : m_data(data), m_size(size) {}
+
+    T* begin() const { return m_data; }
+    T* end() const { return m_data + m_size; }
+
+    uint32_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T& operator[](uint32_t index) const { return m_data[index]; }
+
+protected:
+    T        *m_data;
+    uint32_t m_size;
+};
+
+#endif
@@ -0,0 +1,259 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <exception>
+#include <new>
+#include "../logging.h"
+#include "../padringapi.h"
+#include "padring.h"
+
+static_assert(PADRING_OUTPUT_SVG == OUTPUT_SVG, "output masks differ");
+static_assert(PADRING_OUTPUT_DEF == OUTPUT_DEF, "output masks differ");
+static_assert(PADRING_OUTPUT_VERILOG == OUTPUT_VERILOG, "output masks differ");
+static_assert(PADRING_OUTPUT_CSV == OUTPUT_CSV, "output masks differ");
+static_assert(PADRING_OUTPUT_GDS2 == OUTPUT_GDS2, "output masks differ");
+static_assert(PADRING_CELL_PAD == LayoutItem::TYPE_CELL, "cell types differ");
+static_assert(PADRING_CELL_CORNER == LayoutItem::TYPE_CORNER, "cell types differ");
+static_assert(PADRING_CELL_FILLER == LayoutItem::TYPE_FILLER, "cell types differ");
+static_assert(PADRING_CELL_BOND == LayoutItem::TYPE_BOND, "cell types differ");
+
+struct padring_context
+{
+    PadringContext m_context;
+};
+
+struct padring_result
+{
+    bool            m_ok;
+    padringResult_t m_result;
+};
+
+/** exceptions must not cross the C interface,
+    so the entry points log them and fail instead. */
+static void logException(const char *function)
+{
+    try
+    {
+        throw;
+    }
+    catch(const std::exception &e)
+    {
+        doLog(LOG_ERROR, "%s: %s\n", function, e.what());
+    }
+    catch(...)
+    {
+        doLog(LOG_ERROR, "%s: unknown exception\n", function);
+    }
+}
+
+padring_context* padring_create(void)
+{
+    try
+    {
+        return new padring_context();
+    }
+    catch(...)
+    {
+        logException("padring_create");
+        return nullptr;
+    }
+}
+
+void padring_destroy(padring_context *ctx)
+{
+    delete ctx;
+}
+
+int padring_add_lef(padring_context *ctx, const char *data, size_t len)
+{
+    if ((ctx == nullptr) || (data == nullptr))
+    {
+        return 0;
+    }
+
+    try
+    {
+        ctx->m_context.addLEF(data, len);
+        return 1;
+    }
+    catch(...)
+    {
+        logException("padring_add_lef");
+        return 0;
+    }
+}
+
+size_t padring_cell_count(const padring_context *ctx)
+{
+    if (ctx == nullptr)
+    {
+        return 0;
+    }
+
+    try
+    {
+        return ctx->m_context.getCellCount();
+    }
+    catch(...)
+    {
+        logException("padring_cell_count");
+        return 0;
+    }
+}
+
+void padring_set_threads(padring_context *ctx, uint32_t threads)
+{
+    if (ctx == nullptr)
+    {
+        return;
+    }
+
+    try
+    {
+        ctx->m_context.setThreads(threads);
+    }
+    catch(...)
+    {
+        logException("padring_set_threads");
+    }
+}
+
+void padring_set_log_level(uint32_t level)
+{
+    try
+    {
+        setLogLevel(level);
+    }
+    catch(...)
+    {
+        logException("padring_set_log_level");
+    }
+}
+
+padring_result* padring_layout(padring_context *ctx, const char *config, size_t len, uint32_t outputs)
+{
+    padring_result *result = new (std::nothrow) padring_result();
+    if (result == nullptr)
+    {
+        return nullptr;
+    }
+
+    result->m_ok = false;
+    if ((ctx == nullptr) || (config == nullptr))
+    {
+        return result;
+    }
+
+    try
+    {
+        result->m_ok = ctx->m_context.layout(config, len, outputs, result->m_result);
+    }
+    catch(...)
+    {
+        logException("padring_layout");
+
+        // drop a partial result
+        result->m_result = padringResult_t();
+    }
+    return result;
+}
+
+void padring_result_free(padring_result *result)
+{
+    delete result;
+}
+
+int padring_result_ok(const padring_result *result)
+{
+    return ((result != nullptr) && result->m_ok) ? 1 : 0;
+}
+
+double padring_result_die_width(const padring_result *result)
+{
+    return (result != nullptr) ? result->m_result.m_dieWidth : 0.0;
+}
+
+double padring_result_die_height(const padring_result *result)
+{
+    return (result != nullptr) ? result->m_result.m_dieHeight : 0.0;
+}
+
+size_t padring_result_cell_count(const padring_result *result)
+{
+    return (result != nullptr) ? result->m_result.m_cells.size() : 0;
+}
+
+int padring_result_cell(const padring_result *result, size_t index, padring_cell *cell)
+{
+    if ((result == nullptr) || (cell == nullptr) || (index >= result->m_result.m_cells.size()))
+    {
+        return 0;
+    }
+
+    const padringCell_t &placed = result->m_result.m_cells[index];
+    cell->instance = placed.m_instance.c_str();
+    cell->cellname = placed.m_cellname.c_str();
+    cell->type     = static_cast<int>(placed.m_ltype);
+    cell->orient   = toString(placed.m_orient);
+    cell->x        = placed.m_x;
+    cell->y        = placed.m_y;
+    cell->width    = placed.m_width;
+    cell->height   = placed.m_height;
+    return 1;
+}
+
+const char* padring_result_output(const padring_result *result, uint32_t output, size_t *len)
+{
+    if ((result == nullptr) || (!result->m_ok))
+    {
+        return nullptr;
+    }
+
+    const std::string *data = nullptr;
+    switch(output)
+    {
+    case PADRING_OUTPUT_SVG:
+        data = &result->m_result.m_svg;
+        break;
+    case PADRING_OUTPUT_DEF:
+        data = &result->m_result.m_def;
+        break;
+    case PADRING_OUTPUT_VERILOG:
+        data = &result->m_result.m_verilog;
+        break;
+    case PADRING_OUTPUT_CSV:
+        data = &result->m_result.m_csv;
+        break;
+    case PADRING_OUTPUT_GDS2:
+        data = &result->m_result.m_gds2;
+        break;
+    default:
+        return nullptr;
+    }
+
+    if (data->empty())
+    {
+        return nullptr;
+    }
+    if (len != nullptr)
+    {
+        *len = data->size();
+    }
+    return data->c_str();
+}
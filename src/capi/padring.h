@@ -0,0 +1,123 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+/*
+    C interface of libpadring, for embedding padring in
+    programs and scripting languages. Configurations and LEF
+    files are passed as buffers, the placement and the outputs
+    are returned in memory.
+
+    Functions that return int return 1 on success, 0 on failure.
+*/
+
+#ifndef padring_c_h
+#define padring_c_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** outputs, combined into a mask for padring_layout */
+#define PADRING_OUTPUT_SVG      1
+#define PADRING_OUTPUT_DEF      2
+#define PADRING_OUTPUT_VERILOG  4
+#define PADRING_OUTPUT_CSV      8
+#define PADRING_OUTPUT_GDS2     16
+
+/** cell types */
+#define PADRING_CELL_PAD        0
+#define PADRING_CELL_CORNER     1
+#define PADRING_CELL_FILLER     4
+#define PADRING_CELL_BOND       5
+
+/** log levels, the messages below the level are not shown */
+#define PADRING_LOG_VERBOSE     1
+#define PADRING_LOG_INFO        3
+#define PADRING_LOG_WARN        4
+#define PADRING_LOG_ERROR       8
+#define PADRING_LOG_QUIET       255
+
+/** a LEF database and the settings for the layout */
+typedef struct padring_context padring_context;
+
+/** the placement and the outputs of a configuration */
+typedef struct padring_result padring_result;
+
+/** a placed cell. The strings belong to the result. */
+typedef struct padring_cell
+{
+    const char  *instance;  /**< instance name, empty for fillers */
+    const char  *cellname;  /**< cell name */
+    int         type;       /**< PADRING_CELL_... */
+    const char  *orient;    /**< DEF orientation: N, S, E, W, FN, FS, FE or FW */
+    double      x;          /**< x-position of the lower-left corner in microns */
+    double      y;          /**< y-position of the lower-left corner in microns */
+    double      width;      /**< width of the unrotated cell in microns */
+    double      height;     /**< height of the unrotated cell in microns */
+} padring_cell;
+
+/** create a context with an empty LEF database.
+    returns NULL if it cannot be created. */
+padring_context* padring_create(void);
+
+void padring_destroy(padring_context *ctx);
+
+/** add the cells of a LEF file held in memory */
+int padring_add_lef(padring_context *ctx, const char *data, size_t len);
+
+/** number of cells in the LEF database */
+size_t padring_cell_count(const padring_context *ctx);
+
+/** number of worker threads for the edge placement, 0 for one per core */
+void padring_set_threads(padring_context *ctx, uint32_t threads);
+
+/** set the log level of all contexts, PADRING_LOG_... */
+void padring_set_log_level(uint32_t level);
+
+/** lay out a configuration and produce the outputs in the
+    mask 'outputs'. Returns a result, which must be freed 
+    with padring_result_free, or NULL if out of memory. */
+padring_result* padring_layout(padring_context *ctx, const char *config, size_t len, uint32_t outputs);
+
+void padring_result_free(padring_result *result);
+
+/** 1 if the layout succeeded. A failed layout has no outputs,
+    but holds the cells placed before the failure. */
+int padring_result_ok(const padring_result *result);
+
+double padring_result_die_width(const padring_result *result);
+double padring_result_die_height(const padring_result *result);
+
+size_t padring_result_cell_count(const padring_result *result);
+
+/** get a placed cell, in writing order */
+int padring_result_cell(const padring_result *result, size_t index, padring_cell *cell);
+
+/** get an output, one of PADRING_OUTPUT_.... The data belongs
+    to the result. returns NULL if the output was not asked for. */
+const char* padring_result_output(const padring_result *result, uint32_t output, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
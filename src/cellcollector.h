@@ -0,0 +1,108 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef cellcollector_h
+#define cellcollector_h
+
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include "configreader.h"
+
+/** Collects the names of all the cells a configuration
+    file refers to, without building a padring database.
+    Used to decide which LEF macros need to be parsed.
+*/
+class CellCollector : public ConfigReader
+{
+public:
+    CellCollector() {}
+
+    virtual void onCorner(
+        const std::string_view &instance,
+        const std::string_view &location,
+        const std::string_view &cellname) override
+    {
+        addCell(cellname);
+    }
+
+    virtual void onPad(
+        const std::string_view &instance,
+        const std::string_view &location,
+        const std::string_view &cellname,
+        bool flipped) override
+    {
+        addCell(cellname);
+    }
+
+    virtual void onBond(
+        const std::string_view &instance,
+        const std::string_view &cellname,
+        bool flipped,
+        double gd) override
+    {
+        addCell(cellname);
+    }
+
+    virtual void onFiller(const std::vector<std::string_view> &fillers) override
+    {
+        for(auto const &filler : fillers)
+        {
+            addCell(filler);
+        }
+    }
+
+    virtual void onRepeat(uint32_t count, const std::vector<configStatement_t> &statements) override
+    {
+        for(auto const &statement : statements)
+        {
+            if (statement.m_type != configStatement_t::STMT_SPACE)
+            {
+                addCell(statement.m_cellname);
+            }
+        }
+    }
+
+    virtual void onArea(double x, double y) override {}
+    virtual void onGrid(double grid) override {}
+    virtual void onSpace(double space) override {}
+    virtual void onOffset(double offset) override {}
+    virtual void onLoc(const std::string_view &location) override {}
+    virtual void onDesignName(const std::string_view &designName) override {}
+
+    std::unordered_set<std::string> m_cellNames;  ///< all referenced cells
+
+protected:
+    /** add a cell name. Names seen before are found
+        without allocating a copy of the name. */
+    void addCell(const std::string_view &cellname)
+    {
+        if (m_seen.count(cellname) == 0)
+        {
+            auto result = m_cellNames.emplace(cellname);
+            m_seen.insert(*result.first);
+        }
+    }
+
+    /** views of the names in m_cellNames, which do not
+        move once they are inserted. */
+    std::unordered_set<std::string_view> m_seen;
+};
+
+#endif
@@ -20,8 +20,27 @@
 #include <sstream>
 #include <algorithm>
 #include "logging.h"
+#include "stats.h"
+#include "strutils.h"
+#include "mappedfile.h"
 #include "configreader.h"
 
+std::string_view nameRange_t::getName(uint32_t n, std::string &buffer) const
+{
+    if (!m_isRange)
+    {
+        return m_prefix;
+    }
+
+    char digits[24];
+    size_t length = int64ToString(getIndex(n), digits);
+
+    buffer.assign(m_prefix);
+    buffer.append(digits, length);
+    buffer.append(m_suffix);
+    return buffer;
+}
+
 bool ConfigReader::isWhitespace(char c) const
 {
     return ((c==' ') || (c == '\t'));
@@ -53,153 +72,155 @@ bool ConfigReader::isSpecialIdentChar(char c) const
     if ((c == '[') || (c == ']') ||
         (c == '<') || (c == '>') ||
         (c == '/') || (c == '\\') ||
-        (c == '.'))
+        (c == '.') || (c == ':'))
     {
         return true;
     }
     return false;
 }
 
-ConfigReader::token_t ConfigReader::tokenize(std::string &tokstr)
+ConfigReader::token_t ConfigReader::tokenize(std::string_view &tokstr)
 {
-    tokstr.clear();
-
-    while(isWhitespace(m_tokchar) && !m_is->eof())
-    {
-        m_tokchar = m_is->get();
-    }
-
-    if (m_is->eof())
-    {
-        return TOK_EOF;
-    }
+    // the tokenizer works directly on the input buffer:
+    // tokens are views into it, so nothing is copied.
 
-    if ((m_tokchar==10) || (m_tokchar==13))
-    {
-        m_tokchar = m_is->get();
-        m_lineNum++;
-        return TOK_EOL;
-    }
-
-    if (m_tokchar=='#')
-    {
-        m_tokchar = m_is->get();
-        return TOK_HASH; 
-    }
-
-    if (m_tokchar==';')
-    {
-        m_tokchar = m_is->get();
-        return TOK_SEMICOL; 
-    }
-
-    if (m_tokchar=='(')
-    {
-        m_tokchar = m_is->get();
-        return TOK_LPAREN;
-    }
+    const char *p = m_ptr;
+    tokstr = std::string_view();
 
-    if (m_tokchar==')')
+    while((p < m_end) && isWhitespace(*p))
     {
-        m_tokchar = m_is->get();
-        return TOK_RPAREN;
+        p++;
     }
 
-    if (m_tokchar=='[')
+    if (p >= m_end)
     {
-        m_tokchar = m_is->get();
-        return TOK_LBRACKET;
+        m_ptr = p;
+        return TOK_EOF;
     }
 
-    if (m_tokchar==']')
-    {
-        m_tokchar = m_is->get();
-        return TOK_RBRACKET;
-    }
+    const char *start = p;
+    const char c = *p++;
+    token_t tok = TOK_ERR;
 
-    if (m_tokchar=='-')
+    switch(c)
     {
+    case 10:
+    case 13:
+        m_lineNum++;
+        tok = TOK_EOL;
+        break;
+    case '#':
+        tok = TOK_HASH;
+        break;
+    case ';':
+        tok = TOK_SEMICOL;
+        break;
+    case '(':
+        tok = TOK_LPAREN;
+        break;
+    case ')':
+        tok = TOK_RPAREN;
+        break;
+    case '[':
+        tok = TOK_LBRACKET;
+        break;
+    case ']':
+        tok = TOK_RBRACKET;
+        break;
+    case '-':
         // could be the start of a number
-        tokstr = m_tokchar;
-        m_tokchar = m_is->get();
-        if (isDigit(m_tokchar))
+        tok = TOK_MINUS;
+        if ((p < m_end) && isDigit(*p))
         {
             // it is indeed a number!
-            while(isDigit(m_tokchar) || (m_tokchar == '.') || (m_tokchar == 'e'))
+            while((p < m_end) && (isDigit(*p) || (*p == '.') || (*p == 'e')))
             {
-                tokstr += m_tokchar;
-                m_tokchar = m_is->get();
+                p++;
             }
-            return TOK_NUMBER;            
+            tokstr = std::string_view(start, p - start);
+            tok = TOK_NUMBER;
         }
-        return TOK_MINUS;
-    }
-
-    if (isAlpha(m_tokchar))
-    {
-        tokstr = m_tokchar;
-        m_tokchar = m_is->get();
-        while(isAlphaNumeric(m_tokchar) || isSpecialIdentChar(m_tokchar))
-        {            
-            tokstr += m_tokchar;
-            m_tokchar = m_is->get();
-        }
-        return TOK_IDENT;
-    }
-
-    if (m_tokchar=='"')
-    {
-        m_tokchar = m_is->get();
-        while((m_tokchar != '"') && (m_tokchar != 10) && (m_tokchar != 13))
+        break;
+    case '"':
+        while((p < m_end) && (*p != '"') && (*p != 10) && (*p != 13))
         {
-            tokstr += m_tokchar;
-            m_tokchar = m_is->get();
+            p++;
         }
+        tokstr = std::string_view(start + 1, p - start - 1);
 
-        // skip closing quotes
-        if (m_tokchar == '"')
+        // skip closing quotes, a string ending at
+        // a newline is taken as it is.
+        if ((p < m_end) && (*p == '"'))
         {
-            m_tokchar = m_is->get();
+            p++;
         }
-
-        // error on newline
-        if ((m_tokchar == 10) || (m_tokchar == 13))
+        tok = TOK_STRING;
+        break;
+    default:
+        if (isAlpha(c))
         {
-            // TODO: error, string cannot continue after newline!
+            while((p < m_end) && (isAlphaNumeric(*p) || isSpecialIdentChar(*p)))
+            {
+                p++;
+            }
+            tokstr = std::string_view(start, p - start);
+            tok = TOK_IDENT;
         }
-        return TOK_STRING;
-    }
-
-    if (isDigit(m_tokchar))
-    {
-        tokstr = m_tokchar;
-        m_tokchar = m_is->get();
-        while(isDigit(m_tokchar) || (m_tokchar == '.') || (m_tokchar == 'e'))
+        else if (isDigit(c))
         {
-            tokstr += m_tokchar;
-            m_tokchar = m_is->get();
+            while((p < m_end) && (isDigit(*p) || (*p == '.') || (*p == 'e')))
+            {
+                p++;
+            }
+            tokstr = std::string_view(start, p - start);
+            tok = TOK_NUMBER;
         }
-        return TOK_NUMBER;
     }
 
-    m_tokchar = m_is->get();
-    return TOK_ERR;
+    m_ptr = p;
+    return tok;
 }
 
 bool ConfigReader::parse(std::istream &configstream)
 {
-    m_lineNum = 1;
-
     if (!configstream.good())
     {
         doLog(LOG_ERROR,"ConfigReader: input stream is not open\n");
         return false;
     }
 
-    m_is = &configstream;
-    std::string tokstr;
-    m_tokchar = m_is->get();
+    // fallback for non-file input: read the
+    // whole stream and parse it from memory.
+    std::string contents((std::istreambuf_iterator<char>(configstream)),
+        std::istreambuf_iterator<char>());
+
+    return parse(contents.data(), contents.size());
+}
+
+bool ConfigReader::parseFile(const std::string &filename)
+{
+    MappedFile configFile;
+    if (!configFile.open(filename))
+    {
+        doLog(LOG_ERROR,"ConfigReader: cannot open %s\n", filename.c_str());
+        return false;
+    }
+
+    return parse(configFile.data(), configFile.size());
+}
 
+bool ConfigReader::parse(const char *data, size_t len)
+{
+    ScopedTimer timer(STAT_CONFIG_PARSE);
+    m_lineNum = 1;
+
+    m_ptr = data;
+    m_end = data + len;
+
+    m_inRepeat = false;
+    m_repeatBody.clear();
+
+    std::string_view tokstr;
     bool m_inComment = false;
     
     ConfigReader::token_t tok = TOK_EOF;
@@ -217,6 +238,13 @@ bool ConfigReader::parse(std::istream &configstream)
                 m_inComment = true;
                 break;
             case TOK_IDENT:
+                if ((m_inRepeat) && (tokstr != "PAD") && (tokstr != "BOND") && 
+                    (tokstr != "SPACE") && (tokstr != "END") && (tokstr != "REPEAT"))
+                {
+                    error("Only PAD, BOND and SPACE are allowed in a REPEAT block\n");
+                    return false;
+                }
+
                 if (tokstr == "CORNER")
                 {
                     if (!parseCorner()) return false;
@@ -257,6 +285,14 @@ bool ConfigReader::parse(std::istream &configstream)
                 {
                     if (!parseLoc()) return false;
                 }               
+                else if (tokstr == "REPEAT")
+                {
+                    if (!parseRepeat()) return false;
+                }
+                else if (tokstr == "END")
+                {
+                    if (!parseEnd()) return false;
+                }
                 else
                 {
                     std::stringstream ss;
@@ -277,6 +313,13 @@ bool ConfigReader::parse(std::istream &configstream)
         }
     } while(tok != TOK_EOF);
 
+    if (m_inRepeat)
+    {
+        error("Expected END for the REPEAT block\n");
+        return false;
+    }
+
+    Stats::count(STAT_CONFIG_LINES, m_lineNum - 1);
     return true;
 }
 
@@ -291,10 +334,10 @@ void ConfigReader::error(const std::string &errstr)
 bool ConfigReader::parsePad()
 {
     // PAD: instance location cellname
-    std::string tokstr;
-    std::string instance;
-    std::string location;
-    std::string cellname;
+    std::string_view tokstr;
+    std::string_view instance;
+    std::string_view location;
+    std::string_view cellname;
     bool flipped = false;
 
     // instance name
@@ -314,7 +357,7 @@ bool ConfigReader::parsePad()
     }
 
     // PADs can only be on North, South, East or West
-    std::array<std::string, 4> items = {"N","E","S","W"};
+    std::array<std::string_view, 4> items = {"N","E","S","W"};
     if (!inArray(location, items))
     {
         error("Expected a pad location to be one of N/E/S/W\n");
@@ -344,6 +387,23 @@ bool ConfigReader::parsePad()
         return false;
     }
 
+    nameRange_t range;
+    if (!parseRange(instance, range))
+    {
+        return false;
+    }
+
+    if ((range.m_isRange) || (m_inRepeat))
+    {
+        configStatement_t statement;
+        statement.m_type     = configStatement_t::STMT_PAD;
+        statement.m_instance = range;
+        statement.m_location = location;
+        statement.m_cellname = cellname;
+        statement.m_flipped  = flipped;
+        return addStatement(statement);
+    }
+
     m_padCount++;
     onPad(instance,location,cellname,flipped);
 
@@ -353,10 +413,10 @@ bool ConfigReader::parsePad()
 bool ConfigReader::parseBond()
 {
     // PAD: instance location cellname
-    std::string tokstr;
-    std::string instance;
-    std::string cellname;
-    std::string g;
+    std::string_view tokstr;
+    std::string_view instance;
+    std::string_view cellname;
+    std::string_view g;
     double gd = 0.0;
     bool flipped = false;
 
@@ -386,13 +446,8 @@ bool ConfigReader::parseBond()
     // Optional offset
     tok = tokenize(g);
     if (tok == TOK_NUMBER) {
-        try
-        {
-            gd = std::stod(g);
-        }
-        catch(const std::invalid_argument& ia)
+        if (!toNumber(g, gd))
         {
-            error(ia.what());
             return false;
         }
         tok = tokenize(tokstr);
@@ -405,24 +460,51 @@ bool ConfigReader::parseBond()
         return false;
     }
 
+    nameRange_t range;
+    if (!parseRange(instance, range))
+    {
+        return false;
+    }
+
+    if ((range.m_isRange) || (m_inRepeat))
+    {
+        configStatement_t statement;
+        statement.m_type     = configStatement_t::STMT_BOND;
+        statement.m_instance = range;
+        statement.m_cellname = cellname;
+        statement.m_flipped  = flipped;
+        statement.m_value    = gd;
+        return addStatement(statement);
+    }
+
     m_padCount++;
     onBond(instance,cellname,flipped,gd);
 
     return true;
 }
 
-bool ConfigReader::inArray(const std::string &value, const std::array<std::string, 4> &array)
+bool ConfigReader::inArray(const std::string_view &value, const std::array<std::string_view, 4> &array)
 {
     return std::find(array.begin(), array.end(), value) != array.end();
 }
 
+bool ConfigReader::toNumber(const std::string_view &tokstr, double &value)
+{
+    if (!stringToDouble(tokstr, value))
+    {
+        error("Invalid number " + std::string(tokstr) + "\n");
+        return false;
+    }
+    return true;
+}
+
 bool ConfigReader::parseCorner()
 {
     // CORNER: instance location cellname
-    std::string tokstr;
-    std::string instance;
-    std::string location;
-    std::string cellname;
+    std::string_view tokstr;
+    std::string_view instance;
+    std::string_view location;
+    std::string_view cellname;
 
     // instance name
     ConfigReader::token_t tok = tokenize(instance);
@@ -441,7 +523,7 @@ bool ConfigReader::parseCorner()
     }
 
     // corners can only be on NorthWest, SouthWest, SouthEast or NorthEast
-    std::array<std::string, 4> items = {"NW","SW","SE","NE"};
+    std::array<std::string_view, 4> items = {"NW","SW","SE","NE"};
     if (!inArray(location, items))
     {
         error("Expected a corner location to be one of NW/SW/SE/NE\n");
@@ -471,8 +553,8 @@ bool ConfigReader::parseCorner()
 bool ConfigReader::parseArea()
 {
     // AREA: x y 
-    std::string tokstr;
-    std::string w,h;
+    std::string_view tokstr;
+    std::string_view w,h;
 
     // width
     ConfigReader::token_t tok = tokenize(w);
@@ -499,14 +581,8 @@ bool ConfigReader::parseArea()
     }
 
     double wd, hd;
-    try
-    {
-        wd = std::stod(w);
-        hd = std::stod(h);
-    }
-    catch(const std::invalid_argument& ia)
+    if ((!toNumber(w, wd)) || (!toNumber(h, hd)))
     {
-        error(ia.what());
         return false;
     }
 
@@ -517,8 +593,8 @@ bool ConfigReader::parseArea()
 bool ConfigReader::parseGrid()
 {
     // GRID: g 
-    std::string tokstr;
-    std::string g;
+    std::string_view tokstr;
+    std::string_view g;
 
     // grid
     ConfigReader::token_t tok = tokenize(g);
@@ -537,13 +613,9 @@ bool ConfigReader::parseGrid()
     }
 
     double gd;
-    try
-    {
-        gd = std::stod(g);
-    }
-    catch(const std::invalid_argument& ia)
+    if (!toNumber(g, gd))
     {
-        error(ia.what());
+        return false;
     }
 
     onGrid(gd);
@@ -553,8 +625,8 @@ bool ConfigReader::parseGrid()
 bool ConfigReader::parseSpace()
 {
     // SPACE: g 
-    std::string tokstr;
-    std::string g;
+    std::string_view tokstr;
+    std::string_view g;
 
     // space
     ConfigReader::token_t tok = tokenize(g);
@@ -573,13 +645,17 @@ bool ConfigReader::parseSpace()
     }
 
     double gd;
-    try
+    if (!toNumber(g, gd))
     {
-        gd = std::stod(g);
+        return false;
     }
-    catch(const std::invalid_argument& ia)
+
+    if (m_inRepeat)
     {
-        error(ia.what());
+        configStatement_t statement;
+        statement.m_type  = configStatement_t::STMT_SPACE;
+        statement.m_value = gd;
+        return addStatement(statement);
     }
 
     onSpace(gd);
@@ -590,8 +666,8 @@ bool ConfigReader::parseSpace()
 bool ConfigReader::parseOffset()
 {
     // OFFSET: g 
-    std::string tokstr;
-    std::string g;
+    std::string_view tokstr;
+    std::string_view g;
 
     // offset
     ConfigReader::token_t tok = tokenize(g);
@@ -610,13 +686,9 @@ bool ConfigReader::parseOffset()
     }
 
     double gd;
-    try
+    if (!toNumber(g, gd))
     {
-        gd = std::stod(g);
-    }
-    catch(const std::invalid_argument& ia)
-    {
-        error(ia.what());
+        return false;
     }
 
     onOffset(gd);
@@ -626,8 +698,8 @@ bool ConfigReader::parseOffset()
 bool ConfigReader::parseFiller()
 {
     // FILLER: fillername
-    std::string tokstr;
-    std::list<std::string> fillers;
+    std::string_view tokstr;
+    std::vector<std::string_view> fillers;
 
     // fillername
     ConfigReader::token_t tok = tokenize(tokstr);
@@ -635,6 +707,11 @@ bool ConfigReader::parseFiller()
     // expect semicol at the end
     while (tok != TOK_SEMICOL)
     {
+        if (tok == TOK_EOF)
+        {
+            error("Expected ;\n");
+            return false;
+        }
         fillers.push_back(tokstr);
         tok = tokenize(tokstr);
     }
@@ -646,8 +723,8 @@ bool ConfigReader::parseFiller()
 bool ConfigReader::parseLoc()
 {
     // FILLER: fillername
-    std::string tokstr;
-    std::string location;
+    std::string_view tokstr;
+    std::string_view location;
 
     // location name
     ConfigReader::token_t tok = tokenize(location);
@@ -658,7 +735,7 @@ bool ConfigReader::parseLoc()
     }
 
     // PADs can only be on North, South, East or West
-    std::array<std::string, 4> items = {"N","E","S","W"};
+    std::array<std::string_view, 4> items = {"N","E","S","W"};
     if (!inArray(location, items))
     {
         error("Expected a pad location to be one of N/E/S/W\n");
@@ -681,8 +758,8 @@ bool ConfigReader::parseLoc()
 bool ConfigReader::parseDesignName()
 {
     // DESIGN: designname
-    std::string tokstr;
-    std::string designName;
+    std::string_view tokstr;
+    std::string_view designName;
 
     // designname
     ConfigReader::token_t tok = tokenize(designName);
@@ -703,3 +780,189 @@ bool ConfigReader::parseDesignName()
     onDesignName(designName);
     return true;
 }
+
+bool ConfigReader::parseRange(const std::string_view &name, nameRange_t &range)
+{
+    // a range is a '[first:last]' part of the name,
+    // other names with brackets are taken as they are.
+    range = nameRange_t();
+    range.m_name   = name;
+    range.m_prefix = name;
+
+    size_t colon = name.find(':');
+    if (colon == std::string_view::npos)
+    {
+        return true;
+    }
+
+    size_t open  = name.rfind('[', colon);
+    size_t close = name.find(']', colon);
+    if ((open == std::string_view::npos) || (close == std::string_view::npos) ||
+        (name.find(':', colon+1) != std::string_view::npos))
+    {
+        error("Invalid bus range in " + std::string(name) + "\n");
+        return false;
+    }
+
+    int64_t first = 0;
+    int64_t last  = 0;
+    if (!stringToInt64(name.substr(open + 1, colon - open - 1), first) ||
+        !stringToInt64(name.substr(colon + 1, close - colon - 1), last) ||
+        (first < INT32_MIN) || (first > INT32_MAX) ||
+        (last < INT32_MIN) || (last > INT32_MAX))
+    {
+        error("Invalid bus range in " + std::string(name) + "\n");
+        return false;
+    }
+
+    int64_t span = (first <= last) ? (last - first) : (first - last);
+    if (span >= c_maxExpansion)
+    {
+        error("Bus range too large in " + std::string(name) + "\n");
+        return false;
+    }
+
+    range.m_first   = static_cast<int32_t>(first);
+    range.m_last    = static_cast<int32_t>(last);
+    range.m_prefix  = name.substr(0, open + 1);
+    range.m_suffix  = name.substr(close);
+    range.m_isRange = true;
+    return true;
+}
+
+bool ConfigReader::addStatement(const configStatement_t &statement)
+{
+    uint32_t names = statement.m_instance.size();
+    if (!m_inRepeat)
+    {
+        // a PAD or BOND with a bus range is
+        // a REPEAT block of one statement.
+        m_padCount += names;
+        m_repeatBody.assign(1, statement);
+        onRepeat(names, m_repeatBody);
+        m_repeatBody.clear();
+        return true;
+    }
+
+    // each repetition needs its own instance names
+    if ((statement.m_type != configStatement_t::STMT_SPACE) && (names != m_repeatCount))
+    {
+        std::stringstream ss;
+        ss << "Expected a bus range of " << m_repeatCount << " names for " << statement.m_instance.m_name << "\n";
+        error(ss.str());
+        return false;
+    }
+
+    // SPACE statements are repeated too, so the
+    // whole block counts towards the limit.
+    if (static_cast<uint64_t>(m_repeatBody.size() + 1) * m_repeatCount > c_maxExpansion)
+    {
+        std::stringstream ss;
+        ss << "REPEAT block too large, it expands to more than " << c_maxExpansion << " items\n";
+        error(ss.str());
+        return false;
+    }
+
+    m_repeatBody.push_back(statement);
+    return true;
+}
+
+bool ConfigReader::parseRepeat()
+{
+    // REPEAT: count
+    std::string_view tokstr;
+    std::string_view countstr;
+
+    if (m_inRepeat)
+    {
+        error("REPEAT blocks cannot be nested\n");
+        return false;
+    }
+
+    ConfigReader::token_t tok = tokenize(countstr);
+    int64_t count = 0;
+    if ((tok != TOK_NUMBER) || !stringToInt64(countstr, count) || (count <= 0))
+    {
+        error("Expected a positive whole number of repetitions\n");
+        return false;
+    }
+
+    if (count > c_maxExpansion)
+    {
+        std::stringstream ss;
+        ss << "REPEAT count too large, at most " << c_maxExpansion << " repetitions are allowed\n";
+        error(ss.str());
+        return false;
+    }
+
+    // expect semicol
+    tok = tokenize(tokstr);
+    if (tok != TOK_SEMICOL)
+    {
+        error("Expected ;\n");
+        return false;
+    }
+
+    m_inRepeat    = true;
+    m_repeatCount = static_cast<uint32_t>(count);
+    m_repeatBody.clear();
+    return true;
+}
+
+bool ConfigReader::parseEnd()
+{
+    // END: closes a REPEAT block
+    std::string_view tokstr;
+
+    if (!m_inRepeat)
+    {
+        error("END without REPEAT\n");
+        return false;
+    }
+
+    // expect semicol
+    ConfigReader::token_t tok = tokenize(tokstr);
+    if (tok != TOK_SEMICOL)
+    {
+        error("Expected ;\n");
+        return false;
+    }
+
+    for(auto const &statement : m_repeatBody)
+    {
+        if (statement.m_type != configStatement_t::STMT_SPACE)
+        {
+            m_padCount += m_repeatCount;
+        }
+    }
+
+    m_inRepeat = false;
+    onRepeat(m_repeatCount, m_repeatBody);
+    m_repeatBody.clear();
+    return true;
+}
+
+void ConfigReader::onRepeat(uint32_t count, const std::vector<configStatement_t> &statements)
+{
+    std::string name;
+    for(uint32_t i=0; i<count; i++)
+    {
+        for(auto const &statement : statements)
+        {
+            switch(statement.m_type)
+            {
+            case configStatement_t::STMT_PAD:
+                onPad(statement.m_instance.getName(i, name), statement.m_location,
+                    statement.m_cellname, statement.m_flipped);
+                break;
+            case configStatement_t::STMT_BOND:
+                onBond(statement.m_instance.getName(i, name), statement.m_cellname,
+                    statement.m_flipped, statement.m_value);
+                break;
+            case configStatement_t::STMT_SPACE:
+                onSpace(statement.m_value);
+                break;
+            }
+        }
+    }
+}
@@ -24,10 +24,65 @@
 #include<vector>
 #include<array>
 #include<string>
+#include<string_view>
 #include<iostream>
 
 #include "linereader.h"
 
+/** an instance name with an optional bus range, such as IO[0:127].
+    The range is expanded in the order written, so IO[3:0]
+    counts down. A name without a range has one element.
+*/
+struct nameRange_t
+{
+    std::string_view m_name;    ///< the name as written
+    std::string_view m_prefix;  ///< the name up to and including '[', or the whole name
+    std::string_view m_suffix;  ///< the name from ']' on, empty without a range
+    int32_t m_first = 0;        ///< first index of the range
+    int32_t m_last  = 0;        ///< last index of the range
+    bool    m_isRange = false;
+
+    /** number of names in the range */
+    uint32_t size() const
+    {
+        if (!m_isRange)
+        {
+            return 1;
+        }
+        // the span of e.g. [-2147483648:2147483647] does not fit an int32_t
+        int64_t span = static_cast<int64_t>(m_last) - static_cast<int64_t>(m_first);
+        return static_cast<uint32_t>(((span < 0) ? -span : span) + 1);
+    }
+
+    /** the index of the n-th name */
+    int64_t getIndex(uint32_t n) const
+    {
+        return (m_first <= m_last) ? (static_cast<int64_t>(m_first) + n) : (static_cast<int64_t>(m_first) - n);
+    }
+
+    /** the n-th name. It is built in 'buffer' if the name 
+        has a range, so it is valid until the buffer changes. */
+    std::string_view getName(uint32_t n, std::string &buffer) const;
+};
+
+/** a PAD, BOND or SPACE statement of a range or a REPEAT block */
+struct configStatement_t
+{
+    enum statementType_t
+    {
+        STMT_PAD,
+        STMT_BOND,
+        STMT_SPACE
+    };
+
+    statementType_t  m_type;
+    nameRange_t      m_instance;    ///< PAD and BOND instance names
+    std::string_view m_location;    ///< PAD location
+    std::string_view m_cellname;    ///< PAD and BOND cell name
+    bool             m_flipped = false;
+    double           m_value = 0.0; ///< SPACE in microns, or BOND offset
+};
+
 /** reads a IO configuration file
 
     Example file:
@@ -48,16 +103,28 @@
     PAD IO6 N BBC16F
     PAD IO7 N BBC16F 
     PAD IO8 N BBC16F
+    PAD DATA[0:7] N BBC16F ;    # DATA[0] .. DATA[7]
+    REPEAT 4 ;                  # pad, power pad and space, 4 times
+        PAD A[0:3] N BBC16F ;
+        PAD VDD[0:3] N PVDD ;
+        SPACE 10 ;
+    END ;
 
 */
 
 class ConfigReader
 {
 public:
-    ConfigReader() : m_padCount(0) {}
+    ConfigReader() : m_ptr(nullptr), m_end(nullptr), m_lineNum(0), m_padCount(0),
+        m_inRepeat(false), m_repeatCount(0) {}
     
     virtual ~ConfigReader() {}
 
+    /** the most names a bus range may have, and the most items
+        a REPEAT block may expand to (repetitions times statements).
+        Larger configurations are rejected rather than exhausting memory. */
+    static constexpr uint32_t c_maxExpansion = 1u << 20;
+
     enum token_t
     {
         TOK_EOF,
@@ -75,13 +142,27 @@ public:
         TOK_ERR
     };
 
+    /** parse a configuration stream. The stream is read into 
+        memory first, prefer parseFile when reading from disk. */
     bool parse(std::istream &configfile);
 
+    /** parse a configuration file by memory-mapping it.
+        returns false if the file cannot be opened or parsed. */
+    bool parseFile(const std::string &filename);
+
+    /** parse a configuration held in memory.
+
+        The names passed to the callbacks are views into the 
+        buffer: they are only valid during the callback, so 
+        copy or intern them to keep them.
+    */
+    bool parse(const char *data, size_t len);
+
     /** callback for a corner */
     virtual void onCorner(
-        const std::string &instance,
-        const std::string &location,
-        const std::string &cellname)
+        const std::string_view &instance,
+        const std::string_view &location,
+        const std::string_view &cellname)
     {
         std::cout << "CORNER " << instance << " " << location << " " << cellname << "\n";
     }
@@ -91,9 +172,9 @@ public:
      *  if flipped == true, the (unplaced/unrotated) cell is flipped along the y axis.
     */
     virtual void onPad(
-        const std::string &instance,
-        const std::string &location,
-        const std::string &cellname,
+        const std::string_view &instance,
+        const std::string_view &location,
+        const std::string_view &cellname,
         bool flipped)
     {
         std::cout << "PAD " << instance << " " << location << " " << cellname << "\n";
@@ -103,14 +184,22 @@ public:
      *  if flipped == true, the (unplaced/unrotated) cell is flipped along the y axis.
     */
     virtual void onBond(
-        const std::string &instance,
-        const std::string &cellname,
+        const std::string_view &instance,
+        const std::string_view &cellname,
         bool flipped,
         double gd)
     {
         std::cout << "BOND " << instance << " " << cellname << "\n";
     }
 
+    /** callback for a range of PAD, BOND and SPACE statements:
+        'count' repetitions of 'statements', from a REPEAT block 
+        or a single PAD or BOND with a bus range. Iteration n uses
+        the n-th name of each range. The default calls onPad,
+        onBond and onSpace for each element.
+    */
+    virtual void onRepeat(uint32_t count, const std::vector<configStatement_t> &statements);
+
     /** callback for die area in microns */
     virtual void onArea(double x, double y) 
     {
@@ -124,7 +213,7 @@ public:
     }
 
     /** callback for grid spacing in microns */
-    virtual void onFiller(const std::list<std::string> &fillers)
+    virtual void onFiller(const std::vector<std::string_view> &fillers)
     {
         std::cout << "Filler prefix:" << fillers.size() << "\n";
     }
@@ -142,13 +231,13 @@ public:
     }
 
     /** callback for offset in microns */
-    virtual void onLoc(const std::string& location)
+    virtual void onLoc(const std::string_view &location)
     {
         std::cout << "Loc " << location << "\n";
     }
 
     /** callback for design name */
-    virtual void onDesignName(const std::string &designName)
+    virtual void onDesignName(const std::string_view &designName)
     {
         std::cout << "Design name " << designName << "\n";
     }
@@ -166,7 +255,10 @@ protected:
     bool isAlphaNumeric(char c) const;
     bool isSpecialIdentChar(char c) const;
 
-    bool inArray(const std::string &value, const std::array<std::string, 4> &array);
+    bool inArray(const std::string_view &value, const std::array<std::string_view, 4> &array);
+
+    /** convert a number token, reports an error if it is not valid */
+    bool toNumber(const std::string_view &tokstr, double &value);
 
     bool parsePad();
     bool parseBond();
@@ -178,15 +270,29 @@ protected:
     bool parseFiller();
     bool parseDesignName();
     bool parseLoc();
+    bool parseRepeat();
+    bool parseEnd();
 
-    token_t      tokenize(std::string &tokstr);
-    char         m_tokchar;
+    /** split an instance name into a bus range, 
+        reports an error if the range is not valid. */
+    bool parseRange(const std::string_view &name, nameRange_t &range);
+
+    /** pass a PAD or BOND with a bus range on, or add a
+        statement to the open REPEAT block. */
+    bool addStatement(const configStatement_t &statement);
+
+    token_t      tokenize(std::string_view &tokstr);
 
     void error(const std::string &errstr);
 
-    std::istream *m_is;
+    const char   *m_ptr;    ///< current read position in the input buffer
+    const char   *m_end;    ///< end of the input buffer
     uint32_t      m_lineNum;
     uint32_t      m_padCount;   ///< number of pad cells excluding corners
+
+    bool          m_inRepeat;       ///< inside a REPEAT block
+    uint32_t      m_repeatCount;    ///< repetitions of the REPEAT block
+    std::vector<configStatement_t> m_repeatBody;    ///< statements of the REPEAT block
 };
 
 
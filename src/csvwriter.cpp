@@ -26,11 +26,24 @@
 #include "logging.h"
 #include "csvwriter.h"
 
-CSVWriter::CSVWriter(std::ostream &os)
-    : m_def(os), m_side(0)
+CSVWriter::CSVWriter(std::ostream &os, PadringDB *padring)
+    : m_def(os), m_side(0), m_padring(padring)
 {
 }
 
+CSVWriter* CSVWriter::open(const std::string &filename, PadringDB *padring)
+{
+    std::unique_ptr<std::ofstream> os = openFile(filename);
+    if (!os)
+    {
+        return nullptr;
+    }
+
+    CSVWriter *writer = new CSVWriter(*os, padring);
+    writer->m_ownedStream = std::move(os);
+    return writer;
+}
+
 CSVWriter::~CSVWriter()
 {
     m_def.flush();    
@@ -62,7 +75,7 @@ void CSVWriter::writePadring(PadringDB *padring)
         if (item->m_ltype == LayoutItem::TYPE_CELL)
         {
             m_side++;
-            m_ss << ",SOUTH," << m_side << ",I/O,NONE," << item->m_instance << ","<< item->m_cellname << ",,,,,,,,,,,,,,,,\n";
+            m_ss << ",SOUTH," << m_side << ",I/O,NONE," << item->getInstanceName() << ","<< item->getCellName() << ",,,,,,,,,,,,,,,,\n";
         }
     }
     for(auto item : padring->m_east)
@@ -70,7 +83,7 @@ void CSVWriter::writePadring(PadringDB *padring)
         if (item->m_ltype == LayoutItem::TYPE_CELL)
         {
             m_side++;
-            m_ss << ",EAST," << m_side << ",I/O,NONE," << item->m_instance << ","<< item->m_cellname << ",,,,,,,,,,,,,,,,\n";
+            m_ss << ",EAST," << m_side << ",I/O,NONE," << item->getInstanceName() << ","<< item->getCellName() << ",,,,,,,,,,,,,,,,\n";
         }
     }
     for (auto item = padring->m_north.rbegin(); item != padring->m_north.rend(); ++item)
@@ -78,7 +91,7 @@ void CSVWriter::writePadring(PadringDB *padring)
         if ((*item)->m_ltype == LayoutItem::TYPE_CELL)
         {
             m_side++;
-            m_ss << ",NORTH," << m_side << ",I/O,NONE," << (*item)->m_instance << ","<< (*item)->m_cellname << ",,,,,,,,,,,,,,,,\n";
+            m_ss << ",NORTH," << m_side << ",I/O,NONE," << (*item)->getInstanceName() << ","<< (*item)->getCellName() << ",,,,,,,,,,,,,,,,\n";
         }
     }
     for (auto item = padring->m_west.rbegin(); item != padring->m_west.rend(); ++item)
@@ -86,7 +99,7 @@ void CSVWriter::writePadring(PadringDB *padring)
         if ((*item)->m_ltype == LayoutItem::TYPE_CELL)
         {
             m_side++;
-            m_ss << ",WEST," << m_side << ",I/O,NONE," << (*item)->m_instance << ","<< (*item)->m_cellname << ",,,,,,,,,,,,,,,,\n";
+            m_ss << ",WEST," << m_side << ",I/O,NONE," << (*item)->getInstanceName() << ","<< (*item)->getCellName() << ",,,,,,,,,,,,,,,,\n";
         }
     }
 }
@@ -29,16 +29,31 @@
 
 #include "layout.h"
 #include "padringdb.h"
+#include "outputsink.h"
 
 /** a very minimal SVG writer */
-class CSVWriter
+class CSVWriter : public OutputSink
 {
 public:
-    CSVWriter(std::ostream &os);
+    /** create a writer for a stream. The pads of 'padring'
+        are written when the cells begin, if it is set. */
+    CSVWriter(std::ostream &os, PadringDB *padring = nullptr);
     virtual ~CSVWriter();
 
+    /** create a writer for a file that lists the pads of the padring.
+        returns nullptr if the file cannot be opened. */
+    static CSVWriter* open(const std::string &filename, PadringDB *padring);
+
     void writePadring(PadringDB *padring);
 
+    virtual void onBegin(uint32_t cellCount, double databaseUnits) override
+    {
+        if (m_padring != nullptr)
+        {
+            writePadring(m_padring);
+        }
+    }
+
 protected:
 
     void writeToFile();
@@ -46,6 +61,7 @@ protected:
     std::stringstream   m_ss;
     std::ostream        &m_def;
     int                 m_side;
+    PadringDB           *m_padring;     ///< padring to write in onBegin
 };
 
 #endif
@@ -26,174 +26,155 @@
 #include "logging.h"
 #include "defwriter.h"
 
-DEFWriter::DEFWriter(std::ostream &os, uint32_t width, uint32_t height)
+/** width of the component count when it is patched at the end */
+static const int gs_countWidth = 10;
+
+DEFWriter::DEFWriter(std::ostream &os, dbu_t width, dbu_t height)
     : m_def(os),
+      m_out(nullptr),
+      m_countPos(-1),
       m_width(width),
       m_height(height),
       m_cellCount(0),
-      m_databaseUnits(0.0)
+      m_expectedCount(0),
+      m_haveExpectedCount(false),
+      m_databaseUnits(0.0),
+      m_cellUnits(1000.0)
 {
-    // make sure the stringstream doesn't use
-    // exponential notation with doubles!
-    m_ss << std::setprecision(std::numeric_limits<double>::digits10);
 }
 
-DEFWriter::~DEFWriter()
+DEFWriter* DEFWriter::open(const std::string &filename, dbu_t width, dbu_t height)
 {
-    m_def.flush();    
-    writeToFile();
+    std::unique_ptr<std::ofstream> os = openFile(filename);
+    if (!os)
+    {
+        return nullptr;
+    }
+
+    DEFWriter *writer = new DEFWriter(*os, width, height);
+    writer->m_ownedStream = std::move(os);
+    return writer;
 }
 
-void DEFWriter::writeToFile()
+DEFWriter::~DEFWriter()
 {
-    assert(!m_designName.empty());
-
-    m_def << "DESIGN " << m_designName << " ;\n";
-    m_def << "UNITS DISTANCE MICRONS " << m_databaseUnits << " ; \n";
-    m_def << "COMPONENTS " << m_cellCount << " ;\n";
-
-    m_def << m_ss.str();
-
-    m_def << "END COMPONENTS\n";
-    m_def << "END DESIGN\n";
+    writeToFile();
 }
 
-
-void DEFWriter::toDEFCoordinates(double &x, double &y)
+void DEFWriter::checkDatabaseUnits()
 {
-    //return std::complex<double>(p.real(), m_height - p.imag());
-    //FIXME: use database units defined in LEF file!
-
     if (m_databaseUnits < 1e-12)
     {
         doLog(LOG_WARN, "DEF database units not set! does your imported LEF file specify it?\n");
         doLog(LOG_WARN, "  Assuming the value is 100.0\n");
         m_databaseUnits = 100.0;
     }
-
-    x *= m_databaseUnits;
-    y *= m_databaseUnits;
 }
 
-void DEFWriter::writeCell(const LayoutItem *item)
+void DEFWriter::writeHeader()
 {
-    if (item == nullptr)
-    {
-        return;
-    }
+    assert(!m_designName.empty());
 
-    double rot = 0.0;
-    double x = item->m_x;
-    double y = item->m_y;
+    checkDatabaseUnits();
 
-    m_cellCount++;
-    
-    if (item->m_ltype == LayoutItem::TYPE_FILLER)
+    m_def << "DESIGN " << m_designName << " ;\n";
+    m_def << "UNITS DISTANCE MICRONS " << m_databaseUnits << " ; \n";
+    if (m_haveExpectedCount)
     {
-        m_ss << "  - FILLER_" << m_cellCount << " " << item->m_cellname << "\n";
+        m_def << "COMPONENTS " << m_expectedCount << " ;\n";
+        m_out = &m_def;
     }
     else
     {
-        m_ss << "  - " << item->m_instance << " " << item->m_cellname << "\n";
+        m_def << "COMPONENTS ";
+        m_countPos = m_def.tellp();
+        if (m_countPos != std::streampos(-1))
+        {
+            // reserve room for the count
+            m_def << std::setw(gs_countWidth) << 0 << " ;\n";
+            m_out = &m_def;
+        }
+        else
+        {
+            // the COMPONENTS line is completed at the end
+            m_out = &m_ss;
+        }
     }
-    // do corners
-    if (item->m_location == "NW")
+}
+
+void DEFWriter::writeToFile()
+{
+    if (m_out == nullptr)
     {
-        y -= item->m_lefinfo->m_sx;
-        toDEFCoordinates(x,y);
-        m_ss << "    + PLACED ( " << x << " " << y << " ) ";
-        m_ss << "E";  // NOTE: In donn version, is W
-        if(item->m_ltype == LayoutItem::TYPE_BOND) m_ss << " + SOURCE DIST";
-        m_ss << " ;\n";
+        writeHeader();
     }
-    else if (item->m_location == "SE")
+
+    if (m_out == &m_ss)
     {
-        // South East orientation, rotation = 90 degrees
-        //x += item->m_lefinfo->m_sy;
-        toDEFCoordinates(x,y);
-        m_ss << "    + PLACED ( " << x << " " << y << " ) ";
-        m_ss << "W";  // NOTE: In donn version, is E
-        if(item->m_ltype == LayoutItem::TYPE_BOND) m_ss << " + SOURCE DIST";
-        m_ss << " ;\n";
+        // the output cannot seek: write the final
+        // count and the kept components.
+        m_def << m_cellCount << " ;\n";
+        m_def << m_ss.str();
     }
-    else if (item->m_location == "NE")
+
+    m_def << "END COMPONENTS\n";
+    m_def << "END DESIGN\n";
+
+    if (m_haveExpectedCount && (m_expectedCount != m_cellCount))
     {
-        y -= item->m_lefinfo->m_sy;
-        toDEFCoordinates(x,y);
-        m_ss << "    + PLACED ( " << x << " " << y << " ) ";
-        m_ss << "S";  // NOTE: In donn version, is N
-        if(item->m_ltype == LayoutItem::TYPE_BOND) m_ss << " + SOURCE DIST";
-        m_ss << " ;\n";
+        doLog(LOG_ERROR, "DEF header has %d components but %d were written\n", m_expectedCount, m_cellCount);
     }
-    else if (item->m_location == "SW")
+
+    if (m_countPos != std::streampos(-1))
     {
-        toDEFCoordinates(x,y);
-        m_ss << "    + PLACED ( " << x << " " << y << " ) ";
-        m_ss << "N";  // NOTE: In donn version, is S
-        if(item->m_ltype == LayoutItem::TYPE_BOND) m_ss << " + SOURCE DIST";
-        m_ss << " ;\n";
+        std::streampos endPos = m_def.tellp();
+        m_def.seekp(m_countPos);
+        m_def << std::setw(gs_countWidth) << m_cellCount;
+        m_def.seekp(endPos);
     }
-    else if (item->m_location == "E")
+
+    m_def.flush();
+}
+
+dbu_t DEFWriter::toDEFCoordinate(dbu_t v, double cellUnits) const
+{
+    if (m_databaseUnits == cellUnits)
     {
-        x -= item->m_lefinfo->m_sy;
-        toDEFCoordinates(x,y);
-        m_ss << "    + PLACED ( " << x << " " << y << " ) ";
-        if (!item->m_flipped) 
-        {
-            m_ss << " W";  // NOTE: In donn version, is E
-        }
-        else
-        {
-            m_ss << " FE";  // NOTE: In donn version, is W
-        }
-        if(item->m_ltype == LayoutItem::TYPE_BOND) m_ss << " + SOURCE DIST";
-        m_ss << " ;\n";
+        return v;
     }
-    else if (item->m_location == "N")
+    return llround(static_cast<double>(v) * m_databaseUnits / cellUnits);
+}
+
+/** prefix of the orientation: the DEF has always been
+    written with an extra space for edge cells */
+static const char* orientPrefix(LayoutItem::LayoutItemType ltype)
+{
+    return (ltype == LayoutItem::TYPE_CORNER) ? "" : " ";
+}
+
+void DEFWriter::writeCell(const PlacedCell &cell, double cellUnits)
+{
+    if (m_out == nullptr)
     {
-        y -= item->m_lefinfo->m_sy;
-        toDEFCoordinates(x,y);
-        m_ss << "    + PLACED ( " << x << " " << y << " ) ";
-        if (!item->m_flipped) 
-        {
-            m_ss << " S";  // NOTE: In donn version, is N
-        }
-        else
-        {
-            m_ss << " FS";  // NOTE: In donn version, is S
-        }
-        if(item->m_ltype == LayoutItem::TYPE_BOND) m_ss << " + SOURCE DIST";
-        m_ss << " ;\n";
-    }   
-    else if (item->m_location == "S")
+        writeHeader();
+    }
+
+    std::ostream &out = *m_out;
+
+    m_cellCount++;
+    
+    if (cell.m_ltype == LayoutItem::TYPE_FILLER)
     {
-        //y -= item->m_lefinfo->m_sy;
-        toDEFCoordinates(x,y);
-        m_ss << "    + PLACED ( " << x << " " << y << " ) ";
-        if (!item->m_flipped)
-        {
-            m_ss << " N";  // NOTE: In donn version, is S
-        }
-        else
-        {
-            m_ss << " FN";  // NOTE: In donn version, is N
-        }
-        if(item->m_ltype == LayoutItem::TYPE_BOND) m_ss << " + SOURCE DIST";
-        m_ss << " ;\n";
-    }        
+        out << "  - FILLER_" << m_cellCount << " " << cell.getCellName() << "\n";
+    }
     else
     {
-        toDEFCoordinates(x,y);
-        m_ss << "    + PLACED ( " << x << " " << y << " ) ";
-        if (!item->m_flipped) 
-        {
-            m_ss << " E";  // NOTE: In donn version, is W
-        }
-        else
-        {
-            m_ss << " W";  // NOTE: In donn version, is E
-        }
-        if(item->m_ltype == LayoutItem::TYPE_BOND) m_ss << " + SOURCE DIST";
-        m_ss << " ;\n";
+        out << "  - " << cell.getInstanceName() << " " << cell.getCellName() << "\n";
     }
+
+    out << "    + PLACED ( " << toDEFCoordinate(cell.m_x, cellUnits) << " ";
+    out << toDEFCoordinate(cell.m_y, cellUnits) << " ) ";
+    out << orientPrefix(cell.m_ltype) << toString(cell.m_orient);
+    if(cell.m_ltype == LayoutItem::TYPE_BOND) out << " + SOURCE DIST";
+    out << " ;\n";
 }
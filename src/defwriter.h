@@ -27,15 +27,38 @@
 #include <sstream>
 
 #include "layout.h"
+#include "outputsink.h"
 
 /** a very minimal SVG writer */
-class DEFWriter
+class DEFWriter : public OutputSink
 {
 public:
-    DEFWriter(std::ostream &os, uint32_t width, uint32_t height);
+    /** width and height are the die size in the database
+        units of the layout */
+    DEFWriter(std::ostream &os, dbu_t width, dbu_t height);
     virtual ~DEFWriter();
 
-    void writeCell(const LayoutItem *item);
+    /** create a writer for a file.
+        returns nullptr if the file cannot be opened. */
+    static DEFWriter* open(const std::string &filename, dbu_t width, dbu_t height);
+
+    /** write a component. cellUnits is the number of 
+        database units per micron of the cell coordinates. */
+    void writeCell(const PlacedCell &cell, double cellUnits);
+
+    virtual void onBegin(uint32_t cellCount, double databaseUnits) override
+    {
+        setComponentCount(cellCount);
+        m_cellUnits = databaseUnits;
+    }
+
+    virtual void onCells(const PlacedCell *cells, size_t count) override
+    {
+        for(size_t i=0; i<count; i++)
+        {
+            writeCell(cells[i], m_cellUnits);
+        }
+    }
 
     void setDatabaseUnits(double databaseUnits)
     {
@@ -47,25 +70,46 @@ public:
         m_designName = designName;
     }
 
+    /** set the number of components that will be written.
+        The header is then written before the first component and
+        the components are written to the output as they arrive.
+        Without a count, a fixed-width count is written and
+        patched at the end, or, if the output cannot seek, the
+        components are kept in memory until the end.
+    */
+    void setComponentCount(uint32_t count)
+    {
+        m_expectedCount = count;
+        m_haveExpectedCount = true;
+    }
+
 protected:
 
-    /** convert to DEF database units / coordinates.
-        this function will issue a warning when
-        m_databaseUnits has not been set and set it
-        to 1000.
-    */
-    void toDEFCoordinates(double &x, double &y);
+    /** write the DESIGN, UNITS and COMPONENTS lines */
+    void writeHeader();
+
+    /** warn and use a default if the database
+        units have not been set */
+    void checkDatabaseUnits();
+
+    /** convert cell coordinates to DEF database units */
+    dbu_t toDEFCoordinate(dbu_t v, double cellUnits) const;
 
     void writeToFile();
 
-    std::stringstream   m_ss;
+    std::stringstream   m_ss;           ///< components, if they cannot be streamed
     std::string         m_designName;
     std::ostream        &m_def;
+    std::ostream        *m_out;         ///< where the components go, nullptr before the header
+    std::streampos      m_countPos;     ///< position of the patched component count, or -1
     
-    uint32_t m_width;
-    uint32_t m_height;
+    dbu_t    m_width;           ///< die width in database units
+    dbu_t    m_height;          ///< die height in database units
     uint32_t m_cellCount;
+    uint32_t m_expectedCount;
+    bool     m_haveExpectedCount;
     double   m_databaseUnits;
+    double   m_cellUnits;       ///< database units per micron of the cells
 };
 
 #endif
\ No newline at end of file
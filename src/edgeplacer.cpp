@@ -0,0 +1,220 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include "logging.h"
+#include "stats.h"
+#include "edgeplacer.h"
+
+EdgePlacer::EdgePlacer(Layout *edge, location_t location, dbu_t edgePos, dbu_t grid) 
+    : m_edge(edge), 
+      m_location(location), 
+      m_edgePos(edgePos), 
+      m_grid(grid),
+      m_firstCorner(LayoutItem::TYPE_CORNER),
+      m_lastCorner(LayoutItem::TYPE_CORNER),
+      m_hasFirstCorner(false),
+      m_hasLastCorner(false),
+      m_complete(false),
+      m_unfilledWidth(0),
+      m_unfilledType(LayoutItem::TYPE_FLEXSPACE)
+{
+}
+
+void EdgePlacer::prepareFillers(FillerHandler &current, PRLEFReader *reader)
+{
+    ScopedTimer timer(STAT_FILLERS);
+
+    // the decomposition tables are computed here, once per
+    // set of filler cells, and shared by the copies.
+    current.setGrid(m_grid);
+    current.prepare(m_edge->getDieSize());
+
+    m_fillers.clear();
+    m_fillers.push_back(current);
+    for(auto item : *m_edge)
+    {
+        if (item->m_ltype == LayoutItem::TYPE_FILLERDECL)
+        {
+            current.addFillers(reader, item->m_fillers);
+            current.prepare(m_edge->getDieSize());
+            m_fillers.push_back(current);
+        }
+    }
+}
+
+void EdgePlacer::setEdge(Layout *edge)
+{
+    m_edge = edge;
+
+    // the names are the same, but the instance symbols
+    // belong to the configuration of the new edge.
+    if (m_hasFirstCorner && (m_edge->getFirstCorner() != nullptr))
+    {
+        m_firstCorner.m_instance = m_edge->getFirstCorner()->m_instance;
+    }
+    if (m_hasLastCorner && (m_edge->getLastCorner() != nullptr))
+    {
+        m_lastCorner.m_instance = m_edge->getLastCorner()->m_instance;
+    }
+
+    auto placed = m_items.begin();
+    for(auto item : *m_edge)
+    {
+        if ((item->m_ltype != LayoutItem::TYPE_CELL) && (item->m_ltype != LayoutItem::TYPE_BOND))
+        {
+            continue;
+        }
+        while ((placed != m_items.end()) && (placed->m_ltype == LayoutItem::TYPE_FILLER))
+        {
+            placed++;
+        }
+        if (placed == m_items.end())
+        {
+            break;
+        }
+        placed->m_instance = item->m_instance;
+        placed++;
+    }
+}
+
+bool EdgePlacer::place()
+{
+    layout();
+    return fillSpaces();
+}
+
+void EdgePlacer::layout()
+{
+    m_items.clear();
+    m_complete = false;
+
+    ScopedTimer timer(STAT_LAYOUT);
+    m_edge->setGrid(m_grid);
+    m_edge->doLayout();
+
+    // keep the positioned corners with the items
+    m_hasFirstCorner = (m_edge->getFirstCorner() != nullptr);
+    if (m_hasFirstCorner)
+    {
+        m_firstCorner = *m_edge->getFirstCorner();
+    }
+    m_hasLastCorner = (m_edge->getLastCorner() != nullptr);
+    if (m_hasLastCorner)
+    {
+        m_lastCorner = *m_edge->getLastCorner();
+    }
+}
+
+bool EdgePlacer::fillSpaces()
+{
+    ScopedTimer timer(STAT_FILLERS);
+
+    m_items.clear();
+    m_complete = false;
+
+    bool horizontal = (m_location == LOC_N) || (m_location == LOC_S);
+    size_t fillerIndex = 0;
+    size_t cells = 0;
+    for(auto item : *m_edge)
+    {
+        switch(item->m_ltype)
+        {
+        case LayoutItem::TYPE_CELL:
+        case LayoutItem::TYPE_BOND:
+            m_items.push_back(*item);
+            cells++;
+            break;
+        case LayoutItem::TYPE_FILLERDECL:
+            // switch to the fillers of this declaration
+            fillerIndex++;
+            break;
+        case LayoutItem::TYPE_FIXEDSPACE:
+        case LayoutItem::TYPE_FLEXSPACE:
+            if (!fill(m_fillers[fillerIndex], horizontal ? item->m_x : item->m_y, item->m_size, item->m_ltype))
+            {
+                return false;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    Stats::count(STAT_ITEMS_PLACED, cells);
+    Stats::count(STAT_FILLERS_EMITTED, m_items.size() - cells);
+
+    m_complete = true;
+    return true;
+}
+
+bool EdgePlacer::fill(FillerHandler &fillers, dbu_t pos, dbu_t space, LayoutItem::LayoutItemType spaceType)
+{
+    bool horizontal = (m_location == LOC_N) || (m_location == LOC_S);
+
+    if ((space <= 0) || (space < m_grid))
+    {
+        return true;
+    }
+
+    // fill with the fewest filler cells
+    const std::vector<uint32_t> *cells = fillers.getFillerCells(space);
+
+    if (cells != nullptr)
+    {
+        for(auto index : *cells)
+        {
+            LayoutItem filler(LayoutItem::TYPE_FILLER);
+            dbu_t width = fillers.getFillerByIndex(index, filler.m_cellname, filler.m_lefinfo);
+            filler.m_x = horizontal ? pos : m_edgePos;
+            filler.m_y = horizontal ? m_edgePos : pos;
+            filler.m_size = width;
+            filler.m_location = m_location;
+            m_items.push_back(filler);
+            pos += width;
+        }
+        return true;
+    }
+
+    // no exact decomposition: use the largest filler that fits
+    while((space > 0) && (space >= m_grid))
+    {
+        symbol_t cellName;
+        PRLEFReader::LEFCellInfo_t *cell;
+        dbu_t width = fillers.getFillerCell(space, cellName, cell);
+        if (width <= 0)
+        {
+            m_unfilledWidth = space;
+            m_unfilledType  = spaceType;
+            return false;
+        }
+
+        LayoutItem filler(LayoutItem::TYPE_FILLER);
+        filler.m_cellname = cellName;
+        filler.m_x = horizontal ? pos : m_edgePos;
+        filler.m_y = horizontal ? m_edgePos : pos;
+        filler.m_size = width;
+        filler.m_location = m_location;
+        filler.m_lefinfo = cell;
+        m_items.push_back(filler);
+
+        space -= width;
+        pos += width;
+    }
+    return true;
+}
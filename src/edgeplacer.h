@@ -0,0 +1,131 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef edgeplacer_h
+#define edgeplacer_h
+
+#include <vector>
+#include "layout.h"
+#include "fillerhandler.h"
+
+/** Lays out one edge of the padring and fills its spaces
+    with filler cells.
+
+    The placed cells, bonds and filler cells are collected in
+    a buffer, in the order in which they must be written, so
+    the four edges can be placed concurrently and written one
+    after the other.
+*/
+class EdgePlacer
+{
+public:
+    /** edgePos is the coordinate of the fixed axis of
+        the filler cells on this edge, in database units. */
+    EdgePlacer(Layout *edge, location_t location, dbu_t edgePos, dbu_t grid);
+
+    /** use another, identical edge. The placed items are kept,
+        so a placement can be reused for a new padring. */
+    void setEdge(Layout *edge);
+
+    /** collect the filler cells for this edge. 'current' holds
+        the filler cells in effect at the start of the edge and
+        is updated by the filler declarations on the edge, so
+        the edges must be prepared in the order they are written.
+    */
+    void prepareFillers(FillerHandler &current, PRLEFReader *reader);
+
+    /** lay out the edge and fill the spaces.
+        returns false if a space could not be filled, in
+        which case the items placed so far are kept.
+    */
+    bool place();
+
+    /** the two steps of place(): lay out the edge, */
+    void layout();
+
+    /** and fill the spaces of the laid out edge. */
+    bool fillSpaces();
+
+    /** placed items in writing order */
+    const std::vector<LayoutItem>& getItems() const
+    {
+        return m_items;
+    }
+
+    /** corners of the edge after placement, or nullptr */
+    const LayoutItem* getFirstCorner() const
+    {
+        return m_hasFirstCorner ? &m_firstCorner : nullptr;
+    }
+
+    const LayoutItem* getLastCorner() const
+    {
+        return m_hasLastCorner ? &m_lastCorner : nullptr;
+    }
+
+    /** true if all spaces have been filled */
+    bool isComplete() const
+    {
+        return m_complete;
+    }
+
+    /** width that could not be filled and the type of the
+        space it belongs to, valid if isComplete() is false. */
+    dbu_t getUnfilledWidth() const
+    {
+        return m_unfilledWidth;
+    }
+
+    LayoutItem::LayoutItemType getUnfilledType() const
+    {
+        return m_unfilledType;
+    }
+
+    location_t getLocation() const
+    {
+        return m_location;
+    }
+
+protected:
+    /** add filler cells that fill 'space' starting at 'pos'.
+        A remainder smaller than the grid is not filled.
+        returns false if no filler cell fits the remaining space.
+    */
+    bool fill(FillerHandler &fillers, dbu_t pos, dbu_t space, LayoutItem::LayoutItemType spaceType);
+
+    Layout      *m_edge;
+    location_t  m_location;
+    dbu_t       m_edgePos;
+    dbu_t       m_grid;
+
+    /** filler cells at the start of the edge, followed by
+        the filler cells of each filler declaration. */
+    std::vector<FillerHandler> m_fillers;
+
+    std::vector<LayoutItem> m_items;
+    LayoutItem  m_firstCorner;
+    LayoutItem  m_lastCorner;
+    bool        m_hasFirstCorner;
+    bool        m_hasLastCorner;
+    bool        m_complete;
+    dbu_t       m_unfilledWidth;
+    LayoutItem::LayoutItemType m_unfilledType;
+};
+
+#endif
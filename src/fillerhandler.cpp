@@ -0,0 +1,172 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <algorithm>
+#include "logging.h"
+#include "fillerhandler.h"
+
+/** largest decomposition table, in entries: 4 MB for the counts
+    and choices together. Spaces beyond the table are filled with
+    the largest filler that fits. */
+static const uint64_t gs_maxTableEntries = 1 << 19;
+
+void FillerHandler::sortCells()
+{
+    if (!m_sorted)
+    {
+        m_sorted = true;
+        std::stable_sort(m_fillerCells.begin(), m_fillerCells.end(), cellCompare);
+        m_table.reset();
+        m_cache.clear();
+    }
+}
+
+void FillerHandler::prepare(dbu_t maxWidth)
+{
+    if ((m_grid <= 0) || (m_fillerCells.empty()) || (maxWidth <= 0))
+    {
+        return;
+    }
+
+    sortCells();
+
+    uint64_t maxUnits = static_cast<uint64_t>(maxWidth / m_grid);
+    if (m_table)
+    {
+        if ((m_table->m_reducible) || (m_table->m_count.size() > maxUnits) ||
+            (m_table->m_count.size() == gs_maxTableEntries))
+        {
+            return;
+        }
+    }
+
+    auto table = std::make_shared<fillerTable_t>();
+
+    // filler widths in grid units
+    for(auto const &cell : m_fillerCells)
+    {
+        dbu_t units = cell.m_width / m_grid;
+        if ((units < 1) || ((cell.m_width % m_grid) != 0) || (units > 1000000000))
+        {
+            doLog(LOG_VERBOSE, "Filler %s is not a multiple of the grid - using the largest filler that fits\n", 
+                symbolName(cell.m_name).data());
+            return;
+        }
+        table->m_units.push_back(static_cast<uint32_t>(units));
+    }
+
+    // an optimal decomposition never needs more than largest-1 
+    // smaller fillers, so every space of at least largest^2 units
+    // has an optimal decomposition that starts with the largest filler.
+    // the table only has to go up to there.
+    uint64_t largest = table->m_units.front();
+    uint64_t limit = largest*largest;
+    uint64_t entries;
+    if (maxUnits >= limit)
+    {
+        entries = limit + 1;
+        table->m_reducible = true;
+    }
+    else
+    {
+        entries = maxUnits + 1;
+        table->m_reducible = false;
+    }
+
+    if (entries > gs_maxTableEntries)
+    {
+        entries = gs_maxTableEntries;
+        table->m_reducible = false;
+        doLog(LOG_INFO, "Spaces wider than %g microns are filled with the largest filler that fits\n",
+            toMicrons(static_cast<dbu_t>(entries - 1) * m_grid, m_databaseUnits));
+    }
+
+    table->m_count.resize(entries, NOFILL);
+    table->m_choice.resize(entries, 0);
+    table->m_count[0] = 0;
+
+    const size_t fillers = table->m_units.size();
+    for(uint64_t units=1; units<entries; units++)
+    {
+        // fillers are sorted largest first, so on a tie
+        // the largest filler is chosen, like the greedy fill.
+        uint32_t best = NOFILL;
+        for(size_t i=0; i<fillers; i++)
+        {
+            uint32_t w = table->m_units[i];
+            if ((w <= units) && (table->m_count[units-w] != NOFILL) && (table->m_count[units-w] + 1 < best))
+            {
+                best = table->m_count[units-w] + 1;
+                table->m_choice[units] = static_cast<uint32_t>(i);
+            }
+        }
+        table->m_count[units] = best;
+    }
+
+    m_table = table;
+    m_cache.clear();
+}
+
+const std::vector<uint32_t>* FillerHandler::getFillerCells(dbu_t width)
+{
+    if ((!m_table) || (width < 0))
+    {
+        return nullptr;
+    }
+
+    uint64_t units = static_cast<uint64_t>(width / m_grid);
+
+    auto iter = m_cache.find(units);
+    if (iter != m_cache.end())
+    {
+        return &iter->second;
+    }
+
+    // reduce large spaces with the largest filler
+    const fillerTable_t &table = *m_table;
+    uint64_t largestCount = 0;
+    uint64_t rest = units;
+    if (rest >= table.m_count.size())
+    {
+        if (!table.m_reducible)
+        {
+            return nullptr;
+        }
+        uint64_t largest = table.m_units.front();
+        largestCount = (rest - table.m_count.size() + largest) / largest;
+        rest -= largestCount * largest;
+    }
+
+    if (table.m_count[rest] == NOFILL)
+    {
+        return nullptr;
+    }
+
+    std::vector<uint32_t> &cells = m_cache[units];
+    cells.reserve(largestCount + table.m_count[rest]);
+    cells.assign(largestCount, 0);
+    while(rest > 0)
+    {
+        uint32_t choice = table.m_choice[rest];
+        cells.push_back(choice);
+        rest -= table.m_units[choice];
+    }
+
+    return &cells;
+}
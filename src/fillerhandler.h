@@ -22,82 +22,138 @@
 
 #include <string>
 #include <list>
+#include <vector>
+#include <memory>
+#include <unordered_map>
 #include "prlefreader.h"
+#include "symboltable.h"
+#include "layout.h"
 
+/** Keeps the set of available filler cells and decomposes
+    spaces into filler cells.
+
+    When a grid is set and all filler widths are a multiple
+    of it, spaces are filled with the minimum number of filler
+    cells, using a coin-change table that is computed once per
+    set of filler cells. Otherwise, or if a space cannot be
+    filled exactly, the largest filler that fits is used. 
+
+    Widths are in database units.
+*/
 class FillerHandler
 {
 public:
-    FillerHandler() : m_sorted(false) {}
+    /** databaseUnits is the number of database units per micron */
+    explicit FillerHandler(double databaseUnits) : m_sorted(false), m_grid(0),
+        m_databaseUnits(databaseUnits) {}
 
     /** Clear all the filler */
     void clearFillerCell() {
         m_fillerCells.clear();
+        m_table.reset();
+        m_cache.clear();
     }
     
     void addFillers(PRLEFReader* reader, const std::list<std::string>& m_fillers) {
         clearFillerCell();
         if (m_fillers.size() == 0)
         {
-            for(auto lefCell : reader->m_cells)
+            std::vector<PRLEFReader::LEFCellInfo_t*> fillerCells;
+            reader->getFillerCells(fillerCells);
+            for(auto lefCell : fillerCells)
             {
-                if (lefCell.second->m_isFiller) 
-                {
-                    addFillerCell(lefCell.first, lefCell.second->m_sx);
-                }
+                addFillerCell(lefCell);
             }
         }
         else
         {
-            // use the provided filler cell prefix to search for filler cells
-            for(auto namefill : m_fillers) 
+            // use the provided filler cell names
+            for(auto const &namefill : m_fillers) 
             {
-                // match any of the fillers
-                bool found = false;
-                for(auto lefCell : reader->m_cells)
+                PRLEFReader::LEFCellInfo_t *lefCell = reader->getCellByName(namefill);
+                if (lefCell != nullptr)
                 {
-                    if (lefCell.first.compare(namefill) == 0) 
-                    {
-                        found = true;
-                        addFillerCell(lefCell.first, lefCell.second->m_sx);
-                        break;
-                    }
+                    addFillerCell(lefCell);
                 }
-                if(!found) {
-                    doLog(LOG_ERROR, "Filler cell %s not found\n", namefill);
+                else
+                {
+                    doLog(LOG_ERROR, "Filler cell %s not found\n", namefill.c_str());
                 }
             }
         }
     }
 
     /** add a filler cell to the list of cells */
-    void addFillerCell(const std::string &cellName, double width)
+    void addFillerCell(PRLEFReader::LEFCellInfo_t *cell)
     {
         m_sorted = false;
-        m_fillerCells.push_back(std::make_pair(width, cellName));
+        m_table.reset();
+        m_cache.clear();
+
+        fillerInfo_t info;
+        info.m_width = toDBU(cell->m_sx, m_databaseUnits);
+        info.m_name  = internSymbol(cell->m_name);
+        info.m_cell  = cell;
+        m_fillerCells.push_back(info);
     }
-    
+
+    /** set the placement grid used to compute the filler decomposition */
+    void setGrid(dbu_t grid)
+    {
+        if (grid != m_grid)
+        {
+            m_grid = grid;
+            m_table.reset();
+            m_cache.clear();
+        }
+    }
+
+    /** compute the decomposition table for spaces up to maxWidth.
+        Copies of the handler share the table, so call this before
+        handing out copies. Does nothing if the table is large
+        enough already, or if the filler widths are not a multiple
+        of the grid.
+    */
+    void prepare(dbu_t maxWidth);
+
+    /** get the filler cells that fill the given width with the 
+        fewest cells, as indices into the filler cells, largest first.
+        A remainder smaller than the grid is not filled.
+        
+        returns nullptr if the width cannot be filled or there is
+        no decomposition table.
+    */
+    const std::vector<uint32_t>* getFillerCells(dbu_t width);
+
+    /** get the width, name and LEF info of a filler cell by index */
+    dbu_t getFillerByIndex(uint32_t index, symbol_t &outCellName, PRLEFReader::LEFCellInfo_t *&outCell) const
+    {
+        const fillerInfo_t &info = m_fillerCells[index];
+        outCellName = info.m_name;
+        outCell = info.m_cell;
+        return info.m_width;
+    }
+
     /** get largest filler cell the is smaller or equal to 
-     *  the given width and return it's width and name.
+     *  the given width and return it's width, name and LEF info.
      * 
      *  if no filler cell is found, -1 is returned.
      **/
-    double getFillerCell(double width, std::string &outCellName)
+    dbu_t getFillerCell(dbu_t width, symbol_t &outCellName, PRLEFReader::LEFCellInfo_t *&outCell)
     {
-        if (!m_sorted)
-        {
-            m_sorted = true;
-            m_fillerCells.sort(cellCompare);
-        }
-        
-        for(auto cell : m_fillerCells)
+        sortCells();
+
+
+        for(auto const &cell : m_fillerCells)
         {
-            if (cell.first <= width)
+            if (cell.m_width <= width)
             {
-                outCellName = cell.second;
-                return cell.first;
+                outCellName = cell.m_name;
+                outCell = cell.m_cell;
+                return cell.m_width;
             }
         }
-        return -1.0;    // not found
+        return -1;      // not found
     }
 
     /** return the number of filler cells available */
@@ -109,35 +165,56 @@ public:
     /** Get the smallest filler cell as a hint for the 
         actual grid spacing of IO cells.
 
-        returns -1.0 on error.
+        returns -1 on error.
     */
-    double getSmallestWidth()
+    dbu_t getSmallestWidth()
     {
-        if (!m_sorted)
-        {
-            m_sorted = true;
-            m_fillerCells.sort(cellCompare);
-        }
+        sortCells();
 
         if (!m_fillerCells.empty())
-            return m_fillerCells.back().first;        
+            return m_fillerCells.back().m_width;        
         
-        return -1.0;
+        return -1;
     }
 
 protected:
 
-    /** pair: filler cell width & filler cell name. */
-    typedef std::pair<double, std::string> fillerInfo_t;
+    /** filler cell width, name & LEF info. */
+    struct fillerInfo_t
+    {
+        dbu_t                       m_width;
+        symbol_t                    m_name;
+        PRLEFReader::LEFCellInfo_t  *m_cell;
+    };
+
+    /** minimum-count filler decomposition of every space 
+        up to m_count.size()-1 grid units. */
+    struct fillerTable_t
+    {
+        std::vector<uint32_t> m_units;  ///< filler widths in grid units, by filler index
+        std::vector<uint32_t> m_count;  ///< minimum number of fillers, NOFILL if unfillable
+        std::vector<uint32_t> m_choice; ///< index of the largest filler of the decomposition
+        bool m_reducible;               ///< larger spaces can be reduced with the largest filler
+    };
+
+    static constexpr uint32_t NOFILL = 0xFFFFFFFF;
 
     static bool cellCompare(const fillerInfo_t &c1, const fillerInfo_t c2)
     {
-        return c1.first > c2.first;
+        return c1.m_width > c2.m_width;
     }
 
+    /** sort the filler cells, largest first */
+    void sortCells();
+
     bool m_sorted;  ///< whether the filler cell list has been sorted (largest first).
+    dbu_t  m_grid;  ///< placement grid, 0 if unknown.
+    double m_databaseUnits;     ///< database units per micron
+
+    std::vector<fillerInfo_t> m_fillerCells;
 
-    std::list<fillerInfo_t> m_fillerCells;
+    std::shared_ptr<const fillerTable_t> m_table;   ///< shared, read-only after prepare
+    std::unordered_map<uint64_t, std::vector<uint32_t> > m_cache;  ///< decompositions by space in grid units
 };
 
 #endif
@@ -17,9 +17,14 @@
     
 */
 
+#include <string.h>
+#include <math.h>
 #include "../logging.h"
 #include "gds2writer.h"
 
+/** size of the output buffer, which is written in one go when full */
+static const size_t gs_bufferSize = 1024*1024;
+
 GDS2Writer* GDS2Writer::open(const std::string &filename, const std::string &designName)
 {
     FILE *f = fopen(filename.c_str(), "wb");
@@ -31,8 +36,32 @@ GDS2Writer* GDS2Writer::open(const std::string &filename, const std::string &des
     return new GDS2Writer(f, designName);
 }
 
+/** longest filler run in a single AREF; COLROW holds 16-bit values */
+static const uint32_t gs_maxRunLength = 32767;
+
 GDS2Writer::GDS2Writer(FILE *f, const std::string &designName) 
-    : m_fout(f), m_designName(designName)
+    : m_fout(f), m_os(nullptr), m_designName(designName), 
+      m_buffer(gs_bufferSize),
+      m_bufferUsed(0),
+      m_cellUnits(1000.0),
+      m_run(),
+      m_runCount(0),
+      m_runPitchX(0),
+      m_runPitchY(0)
+{   
+    doLog(LOG_VERBOSE,"GDS2Writer created\n");
+    writeHeader();
+}
+
+GDS2Writer::GDS2Writer(std::ostream &os, const std::string &designName) 
+    : m_fout(nullptr), m_os(&os), m_designName(designName), 
+      m_buffer(gs_bufferSize),
+      m_bufferUsed(0),
+      m_cellUnits(1000.0),
+      m_run(),
+      m_runCount(0),
+      m_runPitchX(0),
+      m_runPitchY(0)
 {   
     doLog(LOG_VERBOSE,"GDS2Writer created\n");
     writeHeader();
@@ -40,120 +69,133 @@ GDS2Writer::GDS2Writer(FILE *f, const std::string &designName)
 
 GDS2Writer::~GDS2Writer()
 {
+    flushRun();
     writeEpilog();
-    fclose(m_fout);
+    flushBuffer();
+    if (m_fout != nullptr)
+    {
+        fclose(m_fout);
+    }
+    else
+    {
+        m_os->flush();
+    }
     doLog(LOG_VERBOSE,"GDS2Writer destroyed\n");
 }
 
-inline void endian_swap(uint16_t &x)
-{
-    x = (x>>8) | 
-        (x<<8);
-}
-
-inline void endian_swap(int16_t &x)
+void GDS2Writer::flushBuffer()
 {
-    uint16_t y = static_cast<uint16_t>(x);
-    x = static_cast<uint16_t>((y>>8) | (y<<8));
-}
-
-inline void endian_swap(uint32_t &x)
-{
-    x = (x>>24) | 
-        ((x<<8) & 0x00FF0000) |
-        ((x>>8) & 0x0000FF00) |
-        (x<<24);
+    if (m_bufferUsed > 0)
+    {
+        if (m_fout != nullptr)
+        {
+            fwrite(&m_buffer[0], 1, m_bufferUsed, m_fout);
+        }
+        else
+        {
+            m_os->write(reinterpret_cast<const char*>(&m_buffer[0]), m_bufferUsed);
+        }
+        m_bufferUsed = 0;
+    }
 }
 
-inline void endian_swap(int32_t &x)
+void GDS2Writer::flush()
 {
-    uint32_t y = static_cast<uint16_t>(x);
-    x = static_cast<uint32_t>((y>>24) | 
-        ((y<<8) & 0x00FF0000) |
-        ((y>>8) & 0x0000FF00) |
-        (y<<24));
+    flushRun();
+    flushBuffer();
+    if (m_fout != nullptr)
+    {
+        fflush(m_fout);
+    }
+    else
+    {
+        m_os->flush();
+    }
 }
 
-inline void endian_swap(uint64_t &x)
+void GDS2Writer::writeRecordHeader(uint16_t length, uint16_t id)
 {
-    x = (x>>56) | 
-        ((x<<40) & 0x00FF000000000000) |
-        ((x<<24) & 0x0000FF0000000000) |
-        ((x<<8)  & 0x000000FF00000000) |
-        ((x>>8)  & 0x00000000FF000000) |
-        ((x>>24) & 0x0000000000FF0000) |
-        ((x>>40) & 0x000000000000FF00) |
-        (x<<56);
+    // keep whole records in the buffer
+    if (m_bufferUsed + length > m_buffer.size())
+    {
+        flushBuffer();
+    }
+    writeUint16(length);
+    writeUint16(id);
 }
 
 void GDS2Writer::writeUint32(uint32_t v)
 {
-    endian_swap(v);
-    fwrite(&v, sizeof(v), 1, m_fout);
+    uint8_t *ptr = reserve(4);
+    ptr[0] = static_cast<uint8_t>(v >> 24);
+    ptr[1] = static_cast<uint8_t>(v >> 16);
+    ptr[2] = static_cast<uint8_t>(v >> 8);
+    ptr[3] = static_cast<uint8_t>(v);
 }
 
 void GDS2Writer::writeUint16(uint16_t v)
 {
-    endian_swap(v);
-    fwrite(&v, sizeof(v), 1, m_fout);
+    uint8_t *ptr = reserve(2);
+    ptr[0] = static_cast<uint8_t>(v >> 8);
+    ptr[1] = static_cast<uint8_t>(v);
 }
 
 void GDS2Writer::writeUint8(uint8_t v)
 {
-    fwrite(&v, sizeof(v), 1, m_fout);
+    uint8_t *ptr = reserve(1);
+    ptr[0] = v;
 }
 
 void GDS2Writer::writeInt32(uint32_t v)
 {
-    endian_swap(v);
-    fwrite(&v, sizeof(v), 1, m_fout);
+    writeUint32(v);
 }
 
 void GDS2Writer::writeInt16(uint16_t v)
 {
-    endian_swap(v);
-    fwrite(&v, sizeof(v), 1, m_fout);
+    writeUint16(v);
 }
 
 void GDS2Writer::writeFloat32(float v)
 {
-    uint32_t *ptr = reinterpret_cast<uint32_t*>(&v);
-    endian_swap(*ptr);
-    fwrite(ptr, sizeof(v), 1, m_fout);
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    writeUint32(bits);
 }
 
 void GDS2Writer::writeFloat64(double v)
 {
-    uint64_t *ptr = reinterpret_cast<uint64_t*>(&v);
-    endian_swap(*ptr);
-    fwrite(ptr, sizeof(v), 1, m_fout);
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    writeUint32(static_cast<uint32_t>(bits >> 32));
+    writeUint32(static_cast<uint32_t>(bits));
 }
 
-uint32_t GDS2Writer::writeString(const std::string &str)
+uint32_t GDS2Writer::writeString(const std::string_view &str)
 {
     uint32_t bytes = str.size();
-    for(auto c : str)
-    {
-        fputc(c, m_fout);
-    }
     if ((str.size() % 2) == 1)
     {
-        fputc(0, m_fout);
         bytes++;
     }
+
+    uint8_t *ptr = reserve(bytes);
+    memcpy(ptr, str.data(), str.size());
+    if (bytes != str.size())
+    {
+        ptr[str.size()] = 0;
+    }
     return bytes;
 }
 
 void GDS2Writer::writeHeader()
 {
     // HEADER record
-    writeUint16(0x0006);    // Len = 6 bytes
-    writeUint16(0x0002);    // HEADER id
+    writeRecordHeader(0x0006, 0x0002);    // HEADER id
     writeUint16(0x0003);    // version 3?
 
     // BGNLIB
-    writeUint16(0x001C);    // Len
-    writeUint16(0x0102);    // BGNLIB id
+    writeRecordHeader(0x001C, 0x0102);    // BGNLIB id
     writeUint16(0x0000);    // year (last modified)
     writeUint16(0x0000);    // month
     writeUint16(0x0000);    // day
@@ -168,8 +210,7 @@ void GDS2Writer::writeHeader()
     writeUint16(0x0000);    // second    
 
     // LIBNAME
-    writeUint16(0x0012);    // Len 18
-    writeUint16(0x0206);    // LIBNAME id
+    writeRecordHeader(0x0012, 0x0206);    // LIBNAME id
     writeUint16(0x4141);
     writeUint16(0x4141);
     writeUint16(0x4141);
@@ -179,16 +220,14 @@ void GDS2Writer::writeHeader()
     writeUint16(0x4141);
 
     // UNITS
-    writeUint16(0x0014);     // two 8-byte real
-    writeUint16(0x0305);    // UNITS id
+    writeRecordHeader(0x0014, 0x0305);    // UNITS id
     writeUint32(0x3E418937);
     writeUint32(0x4BC6A7EF);    
     writeUint32(0x3944B82F);
     writeUint32(0xA09B5A54);    
     
     // BGNSTR
-    writeUint16(0x001C);    // Len
-    writeUint16(0x0502);    // BGNSTR id
+    writeRecordHeader(0x001C, 0x0502);    // BGNSTR id
     writeUint16(0x0000);    // year (last modified)
     writeUint16(0x0000);    // month
     writeUint16(0x0000);    // day
@@ -204,141 +243,152 @@ void GDS2Writer::writeHeader()
 
     // STRNAME 
     uint32_t bytes = m_designName.size() + (m_designName.size() % 2);
-    writeUint16(bytes+4);   // Len
-    writeUint16(0x0606);    // STRNAME id
+    writeRecordHeader(bytes+4, 0x0606);    // STRNAME id
     writeString(m_designName);
 }
 
 void GDS2Writer::writeEpilog()
 {
     // ENDSTR
-    writeUint16(0x0004);    // Len = 4
-    writeUint16(0x0700);    // ENDSTR id
+    writeRecordHeader(0x0004, 0x0700);    // ENDSTR id
 
     // ENDLIB
-    writeUint16(0x0004);    // Len = 4
-    writeUint16(0x0400);    // ENDLIB id
+    writeRecordHeader(0x0004, 0x0400);    // ENDLIB id
 }
 
 
-void GDS2Writer::writeCell(const LayoutItem *item)
+/** database units per micron, as written in the UNITS record */
+static const double gs_databaseUnits = 1000.0;
+
+/** GDS2 rotation and flip of an orientation */
+struct orientation_t
+{
+    uint16_t m_rot;
+    bool     m_flip;
+};
+
+/** GDS2 transforms by orientation */
+static const orientation_t gs_orientations[ORIENT_COUNT] =
+{
+    /* N  */ {0,   false},
+    /* S  */ {180, false},
+    /* E  */ {270, false},
+    /* W  */ {90,  false},
+    /* FN */ {180, true },
+    /* FS */ {0,   true },
+    /* FE */ {270, true },
+    /* FW */ {90,  true }
+};
+
+int32_t GDS2Writer::toGDS2Coordinate(dbu_t v) const
 {
-    if (item == nullptr)
+    if (m_cellUnits == gs_databaseUnits)
     {
-        return;
+        return static_cast<int32_t>(v);
     }
+    return static_cast<int32_t>(llround(static_cast<double>(v) * gs_databaseUnits / m_cellUnits));
+}
+
+void GDS2Writer::getPlacement(const PlacedCell &cell, placement_t &placement) const
+{
+    const orientation_t &orient = gs_orientations[cell.m_orient];
+    placement.m_rot  = orient.m_rot;   // rotation in degrees
+    placement.m_flip = orient.m_flip;  // true if cell is to be flipped (GDS2 flipping style!)
+
+    // the cell origin
+    dbu_t dx, dy;
+    cell.getOriginOffset(dx, dy);
+    placement.m_x = toGDS2Coordinate(cell.m_x + dx);
+    placement.m_y = toGDS2Coordinate(cell.m_y + dy);
+}
 
-    double px = item->m_x;      // x-position in microns
-    double py = item->m_y;      // y-position in microns
-    uint32_t rot = 0;           // rotation in degrees
-    bool     flip = false;      // true if cell is to be flipped (GDS2 flipping style!)
+void GDS2Writer::writeCell(const PlacedCell &cell)
+{
+    placement_t placement;
+    getPlacement(cell, placement);
 
-    // process regular cells that have N,S,E,W
-    // locations
-    if (item->m_location == "N")
+    if (cell.m_ltype == LayoutItem::TYPE_FILLER)
     {
-        // North orientation, rotation = 180 degrees
-        if (item->m_flipped)
-        {
-            flip = true;
-            rot = 0;
-        }
-        else
+        // try to extend the current run of filler cells
+        if (extendRun(cell, placement))
         {
-            px += item->m_lefinfo->m_sx;
-            rot = 180;
+            return;
         }
+        flushRun();
+        m_run = cell;
+        m_runPlacement = placement;
+        m_runCount = 1;
+        return;
     }
-    else if (item->m_location == "S")
+
+    flushRun();
+    writeSREF(cell.getCellName(), placement);
+}
+
+bool GDS2Writer::extendRun(const PlacedCell &cell, const placement_t &placement)
+{
+    if ((m_runCount == 0) || (m_runCount >= gs_maxRunLength) ||
+        (cell.m_cellname != m_run.m_cellname) ||
+        (cell.m_orient   != m_run.m_orient))
     {
-        // South orientation, rotation = 0 degrees
-        if (item->m_flipped)
-        {
-            flip = true;
-            rot = 180;
-            px += item->m_lefinfo->m_sx;
-        }
-        else
-        {
-            // nothing
-        }
+        return false;
     }
-    else if (item->m_location == "E")
+
+    int32_t dx = placement.m_x - m_runPlacement.m_x;
+    int32_t dy = placement.m_y - m_runPlacement.m_y;
+    if (m_runCount == 1)
     {
-        if (item->m_flipped)
-        {
-            flip = true;
-            rot = 270;
-            py += item->m_lefinfo->m_sx;
-        }
-        else
+        // the second cell sets the pitch, which must
+        // be along the x or the y axis.
+        if ((dx == 0) == (dy == 0))
         {
-            rot = 90;
+            return false;
         }
+        m_runPitchX = dx;
+        m_runPitchY = dy;
     }
-    else if (item->m_location == "W")
-    {        
-        if (item->m_flipped)
-        {
-            flip = true;
-            rot = 90;
-        }
-        else
-        {
-            py += item->m_lefinfo->m_sx;
-            rot = 270;
-        }
-    } 
-    // process corner cells that have NE,NW,SE,SW locations
-    else if (item->m_location == "NW")
-    {
-        rot = 270;
-    }
-    else if (item->m_location == "SE")
+    else if ((dx != m_runPitchX*static_cast<int32_t>(m_runCount)) || 
+        (dy != m_runPitchY*static_cast<int32_t>(m_runCount)))
     {
-        px += item->m_lefinfo->m_sy;
-        rot = 90;
+        return false;
     }
-    else if (item->m_location == "NE")
+
+    m_runCount++;
+    return true;
+}
+
+void GDS2Writer::flushRun()
+{
+    if (m_runCount == 1)
     {
-        px += item->m_lefinfo->m_sx;
-        rot = 180;
+        writeSREF(m_run.getCellName(), m_runPlacement);
     }
-    else if (item->m_location == "SW")
+    else if (m_runCount > 1)
     {
-        // nothing.
+        writeAREF(m_run.getCellName(), m_runPlacement);
     }
+    m_runCount = 0;
+}
 
-    // SREF
-    writeUint16(0x0004);    // Len
-    writeUint16(0x0A00);    // SREF id
-
-    // SNAME
-    uint32_t bytes = item->m_cellname.size() + (item->m_cellname.size() % 2);
-    writeUint16(bytes+4);   // Len
-    writeUint16(0x1206);    // SNAME
-    writeString(item->m_cellname);
-
+void GDS2Writer::writeTransform(const placement_t &placement)
+{
     // check for FLIP
-    if (flip)
+    if (placement.m_flip)
     {
-        writeUint16(0x0006);
-        writeUint16(0x1A01);    // write STRANS
+        writeRecordHeader(0x0006, 0x1A01);    // write STRANS
         writeUint16(0x8000);     
     }
     else
     {
-        writeUint16(0x0006);
-        writeUint16(0x1A01);    // write STRANS
+        writeRecordHeader(0x0006, 0x1A01);    // write STRANS
         writeUint16(0x0000);
     }
 
     // ANGLE
-    if (rot != 0)
+    if (placement.m_rot != 0)
     {
-        writeUint16(4+8);
-        writeUint16(0x1C05);    // ANGLE id
-        switch(rot)
+        writeRecordHeader(4+8, 0x1C05);    // ANGLE id
+        switch(placement.m_rot)
         {
         case 90:
             writeUint8(2+64);       // exponent
@@ -369,17 +419,85 @@ void GDS2Writer::writeCell(const LayoutItem *item)
             writeUint8(0);          
         }
     }
+}
+
+void GDS2Writer::writeSREF(const std::string_view &cellname, const placement_t &placement)
+{
+    // SREF
+    writeRecordHeader(0x0004, 0x0A00);    // SREF id
+
+    // SNAME
+    uint32_t bytes = cellname.size() + (cellname.size() % 2);
+    writeRecordHeader(bytes+4, 0x1206);    // SNAME
+    writeString(cellname);
+
+    writeTransform(placement);
 
     // XY
-    writeUint16(4+8);
-    writeUint16(0x1003);    // XY id
-    writeInt32(px*1000.0);
-    writeInt32(py*1000.0);
+    writeRecordHeader(4+8, 0x1003);    // XY id
+    writeInt32(placement.m_x);
+    writeInt32(placement.m_y);
 
     // ENDEL
-    writeUint16(4);         // Len
-    writeUint16(0x1100);    // ENDEL id
+    writeRecordHeader(4, 0x1100);    // ENDEL id
+}
 
+void GDS2Writer::writeAREF(const std::string_view &cellname, const placement_t &placement)
+{
+    // the run is a single row (pitch along x) or a single
+    // column (pitch along y). The unused lattice vector gets 
+    // the cell height, as some readers reject zero vectors.
+    int32_t otherPitch = toGDS2Coordinate(m_run.m_height);
+    if (otherPitch == 0)
+    {
+        otherPitch = 1;
+    }
+
+    uint16_t columns = 1;
+    uint16_t rows = 1;
+    int32_t colX = placement.m_x;
+    int32_t colY = placement.m_y;
+    int32_t rowX = placement.m_x;
+    int32_t rowY = placement.m_y;
+    if (m_runPitchY == 0)
+    {
+        columns = static_cast<uint16_t>(m_runCount);
+        colX += m_runPitchX*static_cast<int32_t>(m_runCount);
+        rowY += otherPitch;
+    }
+    else
+    {
+        rows = static_cast<uint16_t>(m_runCount);
+        colX += otherPitch;
+        rowY += m_runPitchY*static_cast<int32_t>(m_runCount);
+    }
+
+    // AREF
+    writeRecordHeader(0x0004, 0x0B00);    // AREF id
+
+    // SNAME
+    uint32_t bytes = cellname.size() + (cellname.size() % 2);
+    writeRecordHeader(bytes+4, 0x1206);    // SNAME
+    writeString(cellname);
+
+    writeTransform(placement);
+
+    // COLROW
+    writeRecordHeader(4+4, 0x1302);    // COLROW id
+    writeInt16(columns);
+    writeInt16(rows);
+
+    // XY: reference point, column and row displacement
+    writeRecordHeader(4+24, 0x1003);    // XY id
+    writeInt32(placement.m_x);
+    writeInt32(placement.m_y);
+    writeInt32(colX);
+    writeInt32(colY);
+    writeInt32(rowX);
+    writeInt32(rowY);
+
+    // ENDEL
+    writeRecordHeader(4, 0x1100);    // ENDEL id
 }
 
 
@@ -23,27 +23,87 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "../layout.h"
+#include "../outputsink.h"
 
-class GDS2Writer
+class GDS2Writer : public OutputSink
 {
 public:
     static GDS2Writer* open(
         const std::string &filename,
         const std::string &designName);
 
+    /** create a writer for a stream, which must stay
+        valid until the writer is deleted. */
+    GDS2Writer(std::ostream &os, const std::string &designName);
+
     virtual ~GDS2Writer();
 
     /** Write a structural reference (SREF) to the GDS2
-        that places a cell.
+        that places a cell. Consecutive filler cells of the
+        same type and pitch are collected and written as
+        a single array reference (AREF).
     */
-    void writeCell(const LayoutItem *item);
+    void writeCell(const PlacedCell &cell);
+
+    /** write all pending records to the file,
+        without ending the GDS2 library. */
+    void flush();
+
+    virtual void onBegin(uint32_t cellCount, double databaseUnits) override
+    {
+        m_cellUnits = databaseUnits;
+    }
+
+    virtual void onCells(const PlacedCell *cells, size_t count) override
+    {
+        for(size_t i=0; i<count; i++)
+        {
+            writeCell(cells[i]);
+        }
+    }
+
+    virtual void onAbort() override
+    {
+        flush();
+    }
 
 protected:
+    /** position and orientation of a cell in the GDS2 */
+    struct placement_t
+    {
+        int32_t  m_x;       ///< x-position in database units
+        int32_t  m_y;       ///< y-position in database units
+        uint32_t m_rot;     ///< rotation in degrees
+        bool     m_flip;    ///< GDS2 style flip (around x axis)
+    };
+
+    void getPlacement(const PlacedCell &cell, placement_t &placement) const;
+
+    /** convert cell coordinates to GDS2 database units */
+    int32_t toGDS2Coordinate(dbu_t v) const;
+
+    /** add a filler cell to the current run.
+        returns false if it does not continue the run. */
+    bool extendRun(const PlacedCell &cell, const placement_t &placement);
+
+    /** write the current run of filler cells, if any */
+    void flushRun();
+
+    void writeSREF(const std::string_view &cellname, const placement_t &placement);
+    void writeAREF(const std::string_view &cellname, const placement_t &placement);
+    void writeTransform(const placement_t &placement);
+
     void writeHeader();
     void writeEpilog();
     
+    /** write the length and id of a record. The record
+        is kept in one piece in the output buffer. */
+    void writeRecordHeader(uint16_t length, uint16_t id);
+
     void writeUint32(uint32_t v);
     void writeUint16(uint16_t v);
     void writeUint8(uint8_t v);
@@ -55,13 +115,45 @@ protected:
 
 
     // returns the number of bytes written
-    uint32_t writeString(const std::string &str);
+    uint32_t writeString(const std::string_view &str);
+
+    /** get space for 'bytes' bytes in the output buffer,
+        writing the buffer to disk if it is full. */
+    uint8_t* reserve(size_t bytes)
+    {
+        if (m_bufferUsed + bytes > m_buffer.size())
+        {
+            flushBuffer();
+            if (bytes > m_buffer.size())
+            {
+                m_buffer.resize(bytes);
+            }
+        }
+        uint8_t *ptr = &m_buffer[m_bufferUsed];
+        m_bufferUsed += bytes;
+        return ptr;
+    }
+
+    /** write the output buffer to disk */
+    void flushBuffer();
 
     GDS2Writer(FILE *f, const std::string &designName);
     
-    FILE        *m_fout;        ///< GDS2 file handle
+    FILE        *m_fout;        ///< GDS2 file handle, or nullptr
+    std::ostream *m_os;         ///< GDS2 stream if m_fout is nullptr
     uint32_t    m_words;        ///< words written
     std::string m_designName;   ///< set the design name
+
+    std::vector<uint8_t> m_buffer;  ///< output buffer
+    size_t      m_bufferUsed;   ///< bytes used in the output buffer
+
+    double      m_cellUnits;    ///< database units per micron of the cells
+
+    PlacedCell  m_run;          ///< first filler cell of the current run
+    placement_t m_runPlacement; ///< placement of the first filler cell
+    uint32_t    m_runCount;     ///< number of filler cells in the run
+    int32_t     m_runPitchX;    ///< distance between the filler cells
+    int32_t     m_runPitchY;
 };
 
 #endif
\ No newline at end of file
@@ -23,41 +23,148 @@
 #include "layout.h"
 
 
-Layout::Layout(direction_t dir, side_t side) : m_dir(dir), m_side(side), m_edgePos(0.0), m_insertFlexSpacer(true)
+static const char* gs_locationNames[LOC_COUNT] =
+{
+    "N", "S", "E", "W", "NE", "NW", "SE", "SW", ""
+};
+
+location_t toLocation(const std::string_view &name)
+{
+    for(uint32_t i=0; i<LOC_NONE; i++)
+    {
+        if (name == gs_locationNames[i])
+        {
+            return static_cast<location_t>(i);
+        }
+    }
+    return LOC_NONE;
+}
+
+const char* toString(location_t location)
+{
+    if (location >= LOC_COUNT)
+    {
+        return "";
+    }
+    return gs_locationNames[location];
+}
+
+Layout::Layout(direction_t dir, side_t side) : m_insertFlexSpacer(true), m_dieSize(0),
+    m_dir(dir), m_side(side), m_edgePos(0), m_grid(1),
+    m_firstCorner(LayoutItem::TYPE_CORNER),
+    m_lastCorner(LayoutItem::TYPE_CORNER),
+    m_hasFirstCorner(false),
+    m_hasLastCorner(false)
 {
-    m_firstCorner = nullptr;
-    m_lastCorner  = nullptr;
 }
 
 Layout::~Layout()
 {
-    for(auto c : m_items)
+}
+
+void Layout::pushItem(const LayoutItem &item)
+{
+    m_items.push_back(item);
+    m_types.push_back(item.m_ltype);
+    m_sizes.push_back(item.m_size);
+    m_offsets.push_back(item.m_offset);
+    if (m_dir == DIR_HORIZONTAL)
+    {
+        m_positions.push_back(item.m_x);
+        m_edgePositions.push_back(item.m_y);
+    }
+    else
     {
-        delete c;
+        m_positions.push_back(item.m_y);
+        m_edgePositions.push_back(item.m_x);
     }
 }
 
-double Layout::getMinSize() const
+void Layout::syncItem(size_t index)
 {
-    double total = 0.0;
-    for(auto item : m_items)
+    LayoutItem &item = m_items[index];
+    item.m_size = m_sizes[index];
+    if (m_dir == DIR_HORIZONTAL)
+    {
+        item.m_x = m_positions[index];
+        item.m_y = m_edgePositions[index];
+    }
+    else
+    {
+        item.m_y = m_positions[index];
+        item.m_x = m_edgePositions[index];
+    }
+}
+
+void Layout::addItem(const LayoutItem &item)
+{
+    if ((m_insertFlexSpacer) &&
+            (item.m_ltype == LayoutItem::TYPE_CELL))
+    {
+        LayoutItem flex(LayoutItem::TYPE_FLEXSPACE);
+        flex.m_size = -1;
+        setItemEdgePos(&flex);
+        pushItem(flex);
+    }
+
+    pushItem(item);
+    
+    if (item.m_ltype == LayoutItem::TYPE_CELL || item.m_ltype == LayoutItem::TYPE_BOND)
     {
-        if (item->m_size >= 0 && 
-            item->m_ltype != LayoutItem::TYPE_BOND && 
-            item->m_ltype != LayoutItem::TYPE_FILLERDECL) // do not take in consideration the bonds
+        // auto-insert a flex space the next time
+        // a regular CELL is inserted.
+        //
+        // this way, there will always be a flex
+        // space between regular cells unless
+        // we insert a fixed spacer or offset.
+        m_insertFlexSpacer = true;
+    }
+    else if(item.m_ltype != LayoutItem::TYPE_FILLERDECL) // Excempt the FILLERDECL of changing the insertFlexSpacer state
+    {
+        m_insertFlexSpacer = false;
+    }
+}
+
+void Layout::setEdgePos(dbu_t edgePos)
+{
+    m_edgePos = edgePos;
+    for(size_t i=0; i<m_items.size(); i++)
+    {
+        m_edgePositions[i] = edgePos;
+        syncItem(i);
+    }
+    if (m_hasFirstCorner)
+    {
+        setItemEdgePos(&m_firstCorner);
+    }
+    if (m_hasLastCorner)
+    {
+        setItemEdgePos(&m_lastCorner);
+    }
+}
+
+dbu_t Layout::getMinSize() const
+{
+    dbu_t total = 0;
+    const size_t count = m_items.size();
+    for(size_t i=0; i<count; i++)
+    {
+        if (m_sizes[i] >= 0 && 
+            m_types[i] != LayoutItem::TYPE_BOND && 
+            m_types[i] != LayoutItem::TYPE_FILLERDECL) // do not take in consideration the bonds
         {
-            total += item->m_size;
+            total += m_sizes[i];
         }
     }
 
-    if (m_firstCorner != nullptr)
+    if (m_hasFirstCorner)
     {
-        total += m_firstCorner->m_size;
+        total += m_firstCorner.m_size;
     }
 
-    if (m_lastCorner != nullptr)
+    if (m_hasLastCorner)
     {
-        total += m_lastCorner->m_size;
+        total += m_lastCorner.m_size;
     }
 
     return total;
@@ -67,33 +174,32 @@ void Layout::prepareForLayout()
 {
     // if there are no items on this edge,
     // add filler cells.
-    if (m_items.size() == 0 || (m_items.size() == 1 && m_items.front()->m_ltype == LayoutItem::TYPE_FILLERDECL))
+    if (m_items.size() == 0 || (m_items.size() == 1 && m_types.front() == LayoutItem::TYPE_FILLERDECL))
     {
-        auto filler = new LayoutItem(LayoutItem::LayoutItemType::TYPE_FLEXSPACE);
-        m_items.push_back(filler);
+        pushItem(LayoutItem(LayoutItem::LayoutItemType::TYPE_FLEXSPACE));
         return;
     }
 
     m_insertFlexSpacer = false;
-    for(auto item : m_items)
+    for(size_t i=0; i<m_items.size(); i++)
     {
-        setItemPos(item, -1);
-        setItemEdgePos(item);
+        m_positions[i] = -1;
+        m_edgePositions[i] = m_edgePos;
     }
 
     // check if last item is a CELL
     // if so, insert a FLEXSPACER
-    if (m_items.back()->m_ltype == LayoutItem::TYPE_CELL || m_items.back()->m_ltype == LayoutItem::TYPE_BOND)
+    if (m_types.back() == LayoutItem::TYPE_CELL || m_types.back() == LayoutItem::TYPE_BOND)
     {
-        LayoutItem *item = new LayoutItem(LayoutItem::TYPE_FLEXSPACE);
-        item->m_size = -1;
-        setItemPos(item, -1);
-        setItemEdgePos(item);
-        m_items.push_back(item);
+        LayoutItem item(LayoutItem::TYPE_FLEXSPACE);
+        item.m_size = -1;
+        setItemPos(&item, -1);
+        setItemEdgePos(&item);
+        pushItem(item);
     }
 }
 
-void Layout::setGrid(double grid) {
+void Layout::setGrid(dbu_t grid) {
     m_grid = grid;
 }
 
@@ -102,96 +208,133 @@ bool Layout::doLayout()
     prepareForLayout();
 
     // get the minimum width of cells
-    double minx = getMinSize();
+    dbu_t minx = getMinSize();
 
     if (minx > m_dieSize)
     {
         doLog(LOG_ERROR,"Layout items are larger than the available die size\n");
-        doLog(LOG_ERROR,"  size = %f  items = %f\n", m_dieSize, minx);
+        doLog(LOG_ERROR,"  size = %lld  items = %lld database units\n", 
+            static_cast<long long>(m_dieSize), static_cast<long long>(minx));
         return false;
     }
 
+    const size_t count = m_items.size();
+
     // count the number of FLEXSPACE items
-    uint32_t flexSpaceItems = 0;
-    for(auto item : m_items)
+    dbu_t flexSpaceItems = 0;
+    for(size_t i=0; i<count; i++)
     {
-        if (item->m_ltype == LayoutItem::TYPE_FLEXSPACE)
+        if (m_types[i] == LayoutItem::TYPE_FLEXSPACE)
         {
             flexSpaceItems++;
         }
     }
 
-    double meanFlexSpaceSize = (m_dieSize - minx) / static_cast<double>(flexSpaceItems);
-    double pos = 0;
+    // the free space is spread evenly over the FLEXSPACE
+    // items: the end of the k-th one is at k/n of the free
+    // space after the fixed items before it, rounded down
+    // to the grid.
+    const dbu_t freeSpace = m_dieSize - minx;
+    dbu_t pos = 0;
 
     // position the first corner
-    if (m_firstCorner != nullptr)
+    if (m_hasFirstCorner)
     {
-        pos += m_firstCorner->m_size;
-        setItemPos(m_firstCorner, 0.0);
-        setItemEdgePos(m_firstCorner);
+        pos += m_firstCorner.m_size;
+        setItemPos(&m_firstCorner, 0);
+        setItemEdgePos(&m_firstCorner);
+    }
+
+    // the items are reported in a pass of their own,
+    // so the placement loop does no formatting.
+    if (isLogEnabled(LOG_INFO))
+    {
+        for(size_t i=0; i<count; i++)
+        {
+            doLog(LOG_INFO,"Processing cell %s inst %s (%d)\n", m_items[i].getInstanceName().data(), m_items[i].getCellName().data(), m_types[i]);
+        }
     }
 
-    double grid = m_grid;
-    double newPos;
-    double error = 0.0;
-    LayoutItem* last_cell = nullptr;
-    double last_bond = 0.0;
-    for(auto item : m_items)
+    // single pass over the layout fields: the position
+    // of each item is the sum of the sizes before it.
+    const LayoutItem::LayoutItemType *types = m_types.data();
+    dbu_t *sizes     = m_sizes.data();
+    dbu_t *positions = m_positions.data();
+    dbu_t *edges     = m_edgePositions.data();
+    const dbu_t *offsets = m_offsets.data();
+
+    const dbu_t grid = (m_grid > 0) ? m_grid : 1;
+    dbu_t  newPos;
+    dbu_t  flexSpace = 0;   // sum of the FLEXSPACE sizes so far
+    dbu_t  flexIndex = 0;
+    bool   haveCell = false;
+    size_t lastCell = 0;
+    dbu_t  last_bond = 0;
+    for(size_t i=0; i<count; i++)
     {
-        setItemPos(item, pos);
-        doLog(LOG_INFO,"Processing cell %s inst %s (%d)\n", item->m_instance.c_str(), item->m_cellname.c_str(), item->m_ltype);
+        positions[i] = pos;
 
         // advance the position depending on the type of
         // item
-        switch(item->m_ltype)
+        switch(types[i])
         {
         case LayoutItem::TYPE_FLEXSPACE:
-            newPos = pos + meanFlexSpaceSize + error;
-            newPos = std::floor(newPos / grid) * grid;  // round new position to grid
-            item->m_size = newPos - pos;                // set size of FLEXSPACE
+            flexIndex++;
+            newPos = pos - flexSpace + (freeSpace * flexIndex) / flexSpaceItems;
+            newPos -= newPos % grid;                    // round new position to grid
+            if (newPos < pos)
+            {
+                newPos = pos;
+            }
+            sizes[i] = newPos - pos;                    // set size of FLEXSPACE
+            flexSpace += sizes[i];
             pos = newPos;
-            error += (meanFlexSpaceSize - item->m_size);
             break;
         case LayoutItem::TYPE_CELL:
-            last_cell = item;
-            pos += item->m_size;
-            last_bond = 0.0;
+            haveCell = true;
+            lastCell = i;
+            pos += sizes[i];
+            last_bond = 0;
             break;
         case LayoutItem::TYPE_BOND:
             // Only in this special case, assign the last item's position
-            if(last_cell != nullptr) {
-                item->m_x = last_cell->m_x + ( m_dir == DIR_HORIZONTAL ? (last_bond + item->m_offset) : 0.0 ) ;
-                item->m_y = last_cell->m_y + ( m_dir == DIR_HORIZONTAL ? 0.0 : (last_bond + item->m_offset) ) ;
-                if(item->m_flipped) {
+            if (haveCell) {
+                const LayoutItem &bond = m_items[i];
+                positions[i] = positions[lastCell] + (last_bond + offsets[i]);
+                edges[i] = edges[lastCell];
+                if (bond.m_flipped) {
                   switch(m_side) {
-                    case Layout::SIDE_NORTH: item->m_y += item->m_osize; break;
-                    case Layout::SIDE_SOUTH: item->m_y -= item->m_osize; break;
-                    case Layout::SIDE_EAST:  item->m_x += item->m_osize; break;
-                    default:        /*WEST*/ item->m_x -= item->m_osize; break;
+                    case Layout::SIDE_NORTH: edges[i] += bond.m_osize; break;
+                    case Layout::SIDE_SOUTH: edges[i] -= bond.m_osize; break;
+                    case Layout::SIDE_EAST:  edges[i] += bond.m_osize; break;
+                    default:        /*WEST*/ edges[i] -= bond.m_osize; break;
                   }
                 }
-                last_bond += item->m_size + item->m_offset;
+                last_bond += sizes[i] + offsets[i];
             }
             break;
         case LayoutItem::TYPE_CORNER:
-            pos += item->m_size;
+            pos += sizes[i];
             break;
         case LayoutItem::TYPE_FIXEDSPACE:
-            pos += item->m_size;
+            pos += sizes[i];
+            break;
+        default:
             break;
         }
-        if(item->m_size > 0.0 && item->m_size < grid) {
-          doLog(LOG_ERROR, "Error problem: size = %g (grid = %g)\n", item->m_size, grid);
-          item->m_size = 0; // To avoid imprecision
-        }
+    }
+
+    // update the items for the writers
+    for(size_t i=0; i<count; i++)
+    {
+        syncItem(i);
     }
 
     // position the last corner
-    if (m_lastCorner != nullptr)
+    if (m_hasLastCorner)
     {
-        setItemPos(m_lastCorner, m_dieSize - m_lastCorner->m_size);
-        setItemEdgePos(m_lastCorner);
+        setItemPos(&m_lastCorner, m_dieSize - m_lastCorner.m_size);
+        setItemEdgePos(&m_lastCorner);
     }
 
     return true;
@@ -199,24 +342,24 @@ bool Layout::doLayout()
 
 void Layout::dump()
 {
-    if (m_firstCorner != nullptr)
+    if (m_hasFirstCorner)
     {
-        auto c = m_firstCorner;
-        std::cout << c->m_instance << " : " << c->m_cellname << " " << getItemPos(c) << "\n";
+        auto c = &m_firstCorner;
+        std::cout << c->getInstanceName() << " : " << c->getCellName() << " " << getItemPos(c) << "\n";
     }
 
-    for(auto c : m_items)
+    for(auto c : *this)
     {
         if ((c->m_ltype == LayoutItem::TYPE_CELL) || (c->m_ltype == LayoutItem::TYPE_CORNER))
         {
-            std::cout << c->m_instance << " : " << c->m_cellname << " " << getItemPos(c) << "\n";
+            std::cout << c->getInstanceName() << " : " << c->getCellName() << " " << getItemPos(c) << "\n";
         }
     }
 
-    if (m_lastCorner != nullptr)
+    if (m_hasLastCorner)
     {
-        auto c = m_lastCorner;
-        std::cout << c->m_instance << " : " << c->m_cellname << " " << getItemPos(c) << "\n";
+        auto c = &m_lastCorner;
+        std::cout << c->getInstanceName() << " : " << c->getCellName() << " " << getItemPos(c) << "\n";
     }
 
 }
@@ -21,9 +21,55 @@
 #define layout_h
 
 #include "prlefreader.h"
+#include "symboltable.h"
 
+#include <stdint.h>
+#include <math.h>
 #include <string>
+#include <string_view>
 #include <list>
+#include <vector>
+#include <iterator>
+
+/** coordinates and sizes in integer database units.
+    Microns are converted when the configuration is read
+    and when the outputs are written. */
+typedef int64_t dbu_t;
+
+/** convert microns to database units */
+inline dbu_t toDBU(double microns, double databaseUnits)
+{
+    return llround(microns * databaseUnits);
+}
+
+/** convert database units to microns */
+inline double toMicrons(dbu_t v, double databaseUnits)
+{
+    return static_cast<double>(v) / databaseUnits;
+}
+
+/** location of a cell on the padring. Regular cells
+    are on an edge (N,S,E,W), corner cells in a corner. */
+enum location_t
+{
+    LOC_N,
+    LOC_S,
+    LOC_E,
+    LOC_W,
+    LOC_NE,
+    LOC_NW,
+    LOC_SE,
+    LOC_SW,
+    LOC_NONE,
+    LOC_COUNT   ///< number of locations, for lookup tables
+};
+
+/** convert a location name (N, NE, ...) to a location.
+    returns LOC_NONE if the name is not a location. */
+location_t toLocation(const std::string_view &name);
+
+/** name of a location, empty for LOC_NONE */
+const char* toString(location_t location);
 
 class LayoutItem
 {
@@ -40,25 +86,39 @@ public:
     };
 
     LayoutItem(LayoutItemType ltype) : m_lefinfo(nullptr),
-        m_ltype(ltype),
+        m_instance(SymbolTable::SYMBOL_EMPTY),
+        m_cellname(SymbolTable::SYMBOL_EMPTY),
+        m_location(LOC_NONE),
         m_size(-1), m_osize(-1),
-        m_x(-1.0), m_y(-1.0),
-        m_flipped(false),m_offset(0.0)
+        m_offset(0),
+        m_x(-1), m_y(-1),
+        m_flipped(false),
+        m_ltype(ltype)
     {        
     }
 
-    virtual ~LayoutItem() {}
-
     PRLEFReader::LEFCellInfo_t *m_lefinfo;  ///< for CELLs and CORNERs, LEF info.
 
-    std::string m_instance; ///< instance name
-    std::string m_cellname; ///< cell name
-    std::string m_location; ///< location of cell
-    double      m_size;     ///< size of the item (-1 if unknown)
-    double      m_osize;    ///< size of the item in the other coordinate (-1 if unknown)
-    double      m_offset;   ///< offset of the item (0 by default)
-    double      m_x;        ///< x-position of item (-1 if unknown)
-    double      m_y;        ///< y-position of item (-1 if unknown)
+    /** instance name, zero-terminated */
+    std::string_view getInstanceName() const
+    {
+        return symbolName(m_instance);
+    }
+
+    /** cell name, zero-terminated */
+    std::string_view getCellName() const
+    {
+        return symbolName(m_cellname);
+    }
+
+    symbol_t    m_instance; ///< instance name
+    symbol_t    m_cellname; ///< cell name
+    location_t  m_location; ///< location of cell
+    dbu_t       m_size;     ///< size of the item (-1 if unknown)
+    dbu_t       m_osize;    ///< size of the item in the other coordinate (-1 if unknown)
+    dbu_t       m_offset;   ///< offset of the item (0 by default)
+    dbu_t       m_x;        ///< x-position of item (-1 if unknown)
+    dbu_t       m_y;        ///< y-position of item (-1 if unknown)
     bool        m_flipped;  ///< when true, unplaced/unrotated cell is filled along y axis.
     std::list<std::string> m_fillers;
     LayoutItemType m_ltype;
@@ -66,6 +126,16 @@ public:
 
 
 
+/** Layout of the items on one edge of the padring.
+
+    The items are stored by value in a vector. The fields used
+    during placement (type, size, offset and positions) are kept
+    in separate, parallel vectors, so doLayout is a linear pass
+    over contiguous arrays. The LayoutItem objects are updated
+    from these vectors when the layout changes.
+
+    All positions and sizes are in database units.
+*/
 class Layout
 {
 public:
@@ -87,85 +157,54 @@ public:
     virtual ~Layout();
 
     /** Set the die size in the layout direction */
-    void setDieSize(double dieSize) { m_dieSize = dieSize; }
+    void setDieSize(dbu_t dieSize) { m_dieSize = dieSize; }
+
+    /** Get the die size in the layout direction */
+    dbu_t getDieSize() const { return m_dieSize; }
 
-    /** Add a layout item.
+    /** Add a layout item. The item is copied.
         Inserts a FLEXSPACE item if the previously
         inserted item was a cell.
     */
-    void addItem(LayoutItem *item)
-    {
-        if ((m_insertFlexSpacer) &&
-             (item->m_ltype == LayoutItem::TYPE_CELL))
-        {
-            LayoutItem *flex = new LayoutItem(LayoutItem::TYPE_FLEXSPACE);
-            flex->m_size = -1;
-            setItemEdgePos(flex);
-            m_items.push_back(flex);
-        }
-
-        m_items.push_back(item);
-        
-        if (item->m_ltype == LayoutItem::TYPE_CELL || item->m_ltype == LayoutItem::TYPE_BOND)
-        {
-            // auto-insert a flex space the next time
-            // a regular CELL is inserted.
-            //
-            // this way, there will always be a flex
-            // space between regular cells unless
-            // we insert a fixed spacer or offset.
-            m_insertFlexSpacer = true;
-        }
-        else if(item->m_ltype != LayoutItem::TYPE_FILLERDECL) // Excempt the FILLERDECL of changing the insertFlexSpacer state
-        {
-            m_insertFlexSpacer = false;
-        }
-    }
+    void addItem(const LayoutItem &item);
 
     /** set the left-most corner for north and south,
         or bottom most corner for east and west edges.
     */
-    void setFirstCorner(LayoutItem *corner)
+    void setFirstCorner(const LayoutItem &corner)
     {
         m_firstCorner = corner;
-        setItemEdgePos(m_firstCorner);
+        m_hasFirstCorner = true;
+        setItemEdgePos(&m_firstCorner);
     }
 
     /** set the right-most corner for north and south,
         or top most corner for east and west edges.
     */
-    void setLastCorner(LayoutItem *corner)
+    void setLastCorner(const LayoutItem &corner)
     {        
         m_lastCorner = corner;
-        setItemEdgePos(m_lastCorner);
+        m_hasLastCorner = true;
+        setItemEdgePos(&m_lastCorner);
     }
 
-    LayoutItem* getFirstCorner() const
+    LayoutItem* getFirstCorner()
     {
-        return m_firstCorner;
+        return m_hasFirstCorner ? &m_firstCorner : nullptr;
     }
 
-    LayoutItem* getLastCorner() const
+    LayoutItem* getLastCorner()
     {
-        return m_lastCorner;
+        return m_hasLastCorner ? &m_lastCorner : nullptr;
     }
 
-    void setEdgePos(double edgePos)
-    {
-        m_edgePos = edgePos;
-        for(auto c : m_items)
-        {
-            setItemEdgePos(c);
-        }
-        setItemEdgePos(m_firstCorner);
-        setItemEdgePos(m_lastCorner);
-    }
+    void setEdgePos(dbu_t edgePos);
 
     /** get the minimum size of all the items */
-    double getMinSize() const;
+    dbu_t getMinSize() const;
 
     /** set grid */
-    void setGrid(double grid);
+    void setGrid(dbu_t grid);
 
     /** perform the layout */
     bool doLayout();
@@ -173,24 +212,63 @@ public:
     /** dump layout */
     void dump();
 
-    typedef std::list<LayoutItem*>::iterator item_iterator;
+    /** number of items, excluding the corners */
+    size_t size() const
+    {
+        return m_items.size();
+    }
+
+    /** iterator over the items, yielding LayoutItem pointers */
+    class item_iterator
+    {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef LayoutItem*     value_type;
+        typedef ptrdiff_t       difference_type;
+        typedef LayoutItem**    pointer;
+        typedef LayoutItem*     reference;
+
+        item_iterator() : m_ptr(nullptr) {}
+        explicit item_iterator(LayoutItem *ptr) : m_ptr(ptr) {}
+
+        LayoutItem* operator*() const { return m_ptr; }
+        LayoutItem* operator[](difference_type n) const { return m_ptr + n; }
+
+        item_iterator& operator++() { ++m_ptr; return *this; }
+        item_iterator& operator--() { --m_ptr; return *this; }
+        item_iterator operator++(int) { item_iterator tmp(*this); ++m_ptr; return tmp; }
+        item_iterator operator--(int) { item_iterator tmp(*this); --m_ptr; return tmp; }
+
+        item_iterator& operator+=(difference_type n) { m_ptr += n; return *this; }
+        item_iterator& operator-=(difference_type n) { m_ptr -= n; return *this; }
+        item_iterator operator+(difference_type n) const { return item_iterator(m_ptr + n); }
+        item_iterator operator-(difference_type n) const { return item_iterator(m_ptr - n); }
+        difference_type operator-(const item_iterator &other) const { return m_ptr - other.m_ptr; }
+
+        bool operator==(const item_iterator &other) const { return m_ptr == other.m_ptr; }
+        bool operator!=(const item_iterator &other) const { return m_ptr != other.m_ptr; }
+        bool operator<(const item_iterator &other) const { return m_ptr < other.m_ptr; }
+
+    protected:
+        LayoutItem *m_ptr;
+    };
 
     /** begin iterator for LayoutItems */
-    item_iterator begin() { return m_items.begin(); }
+    item_iterator begin() { return item_iterator(m_items.data()); }
 
     /** end iterator for LayoutItems */
-    item_iterator end() { return m_items.end(); }
+    item_iterator end() { return item_iterator(m_items.data() + m_items.size()); }
 
-    typedef std::list<LayoutItem*>::reverse_iterator item_riterator;
+    typedef std::reverse_iterator<item_iterator> item_riterator;
 
     /** begin iterator for LayoutItems */
-    item_riterator rbegin() { return m_items.rbegin(); }
+    item_riterator rbegin() { return item_riterator(end()); }
 
     /** end iterator for LayoutItems */
-    item_riterator rend() { return m_items.rend(); }
+    item_riterator rend() { return item_riterator(begin()); }
 
 protected: 
-    double getItemPos(const LayoutItem *item) const
+    dbu_t getItemPos(const LayoutItem *item) const
     {
         if (m_dir == DIR_HORIZONTAL)
         {
@@ -199,7 +277,7 @@ protected:
         return item->m_y;
     }
 
-    void setItemPos(LayoutItem *item, double pos)
+    void setItemPos(LayoutItem *item, dbu_t pos)
     {
         if (item == nullptr)
         {
@@ -233,18 +311,35 @@ protected:
         }        
     }
 
+    /** append an item and its layout fields */
+    void pushItem(const LayoutItem &item);
+
+    /** copy the layout fields of an item back into the LayoutItem */
+    void syncItem(size_t index);
+
     void prepareForLayout();
 
     bool   m_insertFlexSpacer;
-    double m_dieSize;   ///< die size in the direction of layout
+    dbu_t  m_dieSize;   ///< die size in the direction of layout
 
     direction_t             m_dir;      ///< direction of layout
     side_t                  m_side;      ///< direction of layout
-    double                  m_edgePos;  ///< position of fixed axis of layout
-    double                  m_grid;     ///< the grid
-    std::list<LayoutItem*>  m_items;    ///< all the cells in the padring
-    LayoutItem *m_firstCorner;
-    LayoutItem *m_lastCorner;
+    dbu_t                   m_edgePos;  ///< position of fixed axis of layout
+    dbu_t                   m_grid;     ///< the grid
+
+    std::vector<LayoutItem> m_items;    ///< all the cells in the padring
+
+    // layout fields of m_items, by index
+    std::vector<LayoutItem::LayoutItemType> m_types;
+    std::vector<dbu_t>      m_sizes;        ///< item sizes
+    std::vector<dbu_t>      m_offsets;      ///< item offsets
+    std::vector<dbu_t>      m_positions;    ///< positions along the edge
+    std::vector<dbu_t>      m_edgePositions;///< positions of the fixed axis
+
+    LayoutItem  m_firstCorner;
+    LayoutItem  m_lastCorner;
+    bool        m_hasFirstCorner;
+    bool        m_hasLastCorner;
 };
 
 #endif
@@ -17,6 +17,11 @@
     
 */
 
+#include <iterator>
+#include <cstring>
+#include "../mappedfile.h"
+#include "../strutils.h"
+#include "../stats.h"
 #include "lefreader.h"
 
 bool LEFReader::isWhitespace(char c) const
@@ -46,145 +51,180 @@ bool LEFReader::isAlphaNumeric(char c) const
 }
 
 
-LEFReader::token_t LEFReader::tokenize(std::string &tokstr)
+LEFReader::token_t LEFReader::tokenize(std::string_view &tokstr)
 {
-    tokstr.clear();
+    // the tokenizer works directly on the input buffer:
+    // tokens are views into it, so nothing is copied or allocated.
 
-    while(isWhitespace(m_tokchar) && !m_is->eof())
+    const char *p = m_ptr;
+    tokstr = std::string_view();
+
+    while((p < m_end) && isWhitespace(*p))
     {
-        m_tokchar = m_is->get();
+        p++;
     }
 
-    if (m_is->eof())
+    if (p >= m_end)
     {
+        m_ptr = p;
         return TOK_EOF;
     }
 
-    if ((m_tokchar==10) || (m_tokchar==13))
+    const char *start = p;
+    const char c = *p++;
+
+    if ((c==10) || (c==13))
     {
-        m_tokchar = m_is->get();
+        m_ptr = p;
         m_lineNum++;
         return TOK_EOL;
     }
 
-    if (m_tokchar=='#')
+    if (c=='#')
     {
-        m_tokchar = m_is->get();
+        m_ptr = p;
         return TOK_HASH; 
     }
 
-    if (m_tokchar==';')
+    if (c==';')
     {
-        m_tokchar = m_is->get();
+        m_ptr = p;
         return TOK_SEMICOL; 
     }
 
-    if (m_tokchar=='(')
+    if (c=='(')
     {
-        m_tokchar = m_is->get();
+        m_ptr = p;
         return TOK_LPAREN;
     }
 
-    if (m_tokchar==')')
+    if (c==')')
     {
-        m_tokchar = m_is->get();
+        m_ptr = p;
         return TOK_RPAREN;
     }
 
-    if (m_tokchar=='[')
+    if (c=='[')
     {
-        m_tokchar = m_is->get();
+        m_ptr = p;
         return TOK_LBRACKET;
     }
 
-    if (m_tokchar==']')
+    if (c==']')
     {
-        m_tokchar = m_is->get();
+        m_ptr = p;
         return TOK_RBRACKET;
     }
 
-    if (m_tokchar=='-')
+    if (c=='-')
     {
         // could be the start of a number
-        tokstr = m_tokchar;
-        m_tokchar = m_is->get();
-        if (isDigit(m_tokchar))
+        if ((p < m_end) && isDigit(*p))
         {
             // it is indeed a number!
-            while(isDigit(m_tokchar) || (m_tokchar == '.') || (m_tokchar == 'e'))
+            while((p < m_end) && (isDigit(*p) || (*p == '.') || (*p == 'e')))
             {
-                tokstr += m_tokchar;
-                m_tokchar = m_is->get();
+                p++;
             }
+            tokstr = std::string_view(start, p - start);
+            m_ptr = p;
             return TOK_NUMBER;            
         }
+        tokstr = std::string_view(start, 1);
+        m_ptr = p;
         return TOK_MINUS;
     }
 
-    if (isAlpha(m_tokchar))
+    if (isAlpha(c))
     {
-        tokstr = m_tokchar;
-        m_tokchar = m_is->get();
-        while(isAlphaNumeric(m_tokchar))
+        while((p < m_end) && isAlphaNumeric(*p))
         {            
-            tokstr += m_tokchar;
-            m_tokchar = m_is->get();
+            p++;
         }
+        tokstr = std::string_view(start, p - start);
+        m_ptr = p;
         return TOK_IDENT;
     }
 
-    if (m_tokchar=='"')
+    if (c=='"')
     {
-        m_tokchar = m_is->get();
-        while((m_tokchar != '"') && (m_tokchar != 10) && (m_tokchar != 13))
+        start = p;
+        while((p < m_end) && (*p != '"') && (*p != 10) && (*p != 13))
         {
-            tokstr += m_tokchar;
-            m_tokchar = m_is->get();
+            p++;
         }
+        tokstr = std::string_view(start, p - start);
 
         // skip closing quotes
-        if (m_tokchar == '"')
+        if ((p < m_end) && (*p == '"'))
         {
-            m_tokchar = m_is->get();
+            p++;
         }
 
         // error on newline
-        if ((m_tokchar == 10) || (m_tokchar == 13))
+        if ((p < m_end) && ((*p == 10) || (*p == 13)))
         {
             // TODO: error, string cannot continue after newline!
         }
+        m_ptr = p;
         return TOK_STRING;
     }
 
-    if (isDigit(m_tokchar))
+    if (isDigit(c))
     {
-        tokstr = m_tokchar;
-        m_tokchar = m_is->get();
-        while(isDigit(m_tokchar) || (m_tokchar == '.') || (m_tokchar == 'e'))
+        while((p < m_end) && (isDigit(*p) || (*p == '.') || (*p == 'e')))
         {
-            tokstr += m_tokchar;
-            m_tokchar = m_is->get();
+            p++;
         }
+        tokstr = std::string_view(start, p - start);
+        m_ptr = p;
         return TOK_NUMBER;
     }
 
-    m_tokchar = m_is->get();
+    m_ptr = p;
     return TOK_ERR;
 }
 
 void LEFReader::parse(std::istream &lefstream)
 {
-    m_lineNum = 1;
-
     if (!lefstream.good())
     {
+        m_lineNum = 1;
         error("LEFReader: input stream is faulty\n");
         return;
     }
 
-    m_is = &lefstream;
-    
-    m_tokchar = m_is->get();
+    // fallback for non-file input: read the
+    // whole stream and parse it from memory.
+    std::string contents((std::istreambuf_iterator<char>(lefstream)),
+        std::istreambuf_iterator<char>());
+
+    parse(contents.data(), contents.size());
+}
+
+bool LEFReader::parseFile(const std::string &filename)
+{
+    MappedFile lefFile;
+    if (!lefFile.open(filename))
+    {
+        m_lineNum = 1;
+        error("LEFReader: cannot open " + filename + "\n");
+        return false;
+    }
+
+    parse(lefFile.data(), lefFile.size());
+    return true;
+}
+
+void LEFReader::parse(const char *data, size_t len)
+{
+    ScopedTimer timer(STAT_LEF_PARSE);
+    Stats::count(STAT_LEF_BYTES, len);
+
+    m_lineNum = 1;
+
+    m_ptr = data;
+    m_end = data + len;
 
     bool m_inComment = false;
     
@@ -251,7 +291,7 @@ void LEFReader::error(const std::string &errstr)
 
 bool LEFReader::parseMacro()
 {
-    std::string name;
+    std::string_view name;
     
 
     // macro name
@@ -272,7 +312,22 @@ bool LEFReader::parseMacro()
         return false;
     }
 
-    onMacro(name);
+    if (m_skipMacros)
+    {
+        std::string className;
+        const char *next = nullptr;
+        uint32_t lineCount = 0;
+        if (scanMacro(name, className, next, lineCount) &&
+            !isMacroWanted(name, className))
+        {
+            m_ptr = next;
+            m_lineNum += lineCount;
+            m_skippedMacros++;
+            return true;
+        }
+    }
+
+    onMacro(std::string(name));
 
     // wait for 'END macroname'
     bool endFound = false;
@@ -333,7 +388,7 @@ bool LEFReader::parseMacro()
             endFound = false;
         }
 
-        if (m_is->eof())
+        if (atEOF())
         {
             error("Unexpected end of file\n");
             return false;
@@ -341,9 +396,110 @@ bool LEFReader::parseMacro()
     }
 }
 
+/** remove and return the first word of a line.
+    words are separated by whitespace or semicolons. */
+static std::string_view nextWord(std::string_view &line)
+{
+    size_t start = 0;
+    while((start < line.size()) &&
+        ((line[start] == ' ') || (line[start] == '\t') || (line[start] == '\r') || (line[start] == ';')))
+    {
+        start++;
+    }
+
+    size_t stop = start;
+    while((stop < line.size()) &&
+        (line[stop] != ' ') && (line[stop] != '\t') && (line[stop] != '\r') && (line[stop] != ';'))
+    {
+        stop++;
+    }
+
+    std::string_view word = line.substr(start, stop - start);
+    line.remove_prefix(stop);
+    return word;
+}
+
+bool LEFReader::scanMacro(const std::string_view &name, std::string &className,
+    const char *&next, uint32_t &lineCount) const
+{
+    // skipped macros are scanned line by line: a PIN block
+    // ends with 'END pinname', the macro with 'END name'.
+    const char *p = m_ptr;
+    std::string_view pinName;
+    bool inPin = false;
+    lineCount = 0;
+
+    while(p < m_end)
+    {
+        const char *eol = static_cast<const char*>(memchr(p, 10, m_end - p));
+        if (eol == nullptr)
+        {
+            eol = m_end;
+        }
+
+        std::string_view line(p, eol - p);
+        p = (eol < m_end) ? eol + 1 : m_end;
+
+        // the tokenizer counts CR and LF as line ends
+        if (!line.empty() && (line.back() == 13))
+        {
+            lineCount++;
+        }
+        if (eol < m_end)
+        {
+            lineCount++;
+        }
+
+        // only END, PIN and CLASS lines are of interest
+        const char *first = line.data();
+        const char *last  = line.data() + line.size();
+        while((first < last) && isWhitespace(*first))
+        {
+            first++;
+        }
+        if ((first == last) || ((*first != 'E') && (*first != 'P') && (*first != 'C')))
+        {
+            continue;
+        }
+
+        std::string_view word = nextWord(line);
+        if (word == "END")
+        {
+            word = nextWord(line);
+            if (inPin && (word == pinName))
+            {
+                inPin = false;
+            }
+            else if (word == name)
+            {
+                next = p;
+                return true;
+            }
+        }
+        else if (word == "PIN")
+        {
+            pinName = nextWord(line);
+            inPin = true;
+        }
+        else if ((word == "CLASS") && !inPin && className.empty())
+        {
+            line = line.substr(0, line.find(';'));
+            word = nextWord(line);
+            while(!word.empty())
+            {
+                className += word;
+                className += " ";
+                word = nextWord(line);
+            }
+        }
+    }
+
+    return false;
+}
+
 bool LEFReader::parsePin()
 {
-    std::string name;
+    std::string_view name;
     
 
     // pin name
@@ -364,7 +520,7 @@ bool LEFReader::parsePin()
         return false;
     }
 
-    onPin(name);
+    onPin(std::string(name));
 
     // wait for 'END macroname'
     bool endFound = false;
@@ -405,7 +561,7 @@ bool LEFReader::parsePin()
             endFound = false;
         }
 
-        if (m_is->eof())
+        if (atEOF())
         {
             error("Unexpected end of file\n");
             return false;
@@ -453,8 +609,8 @@ bool LEFReader::parseOrigin()
     // ORIGIN <number> <number> ; 
 
     
-    std::string xnum;
-    std::string ynum;
+    std::string_view xnum;
+    std::string_view ynum;
 
     m_curtok = tokenize(xnum);
     if (m_curtok != TOK_NUMBER)
@@ -478,14 +634,10 @@ bool LEFReader::parseOrigin()
     }
 
     double xnumd, ynumd;
-    try
+    if (!stringToDouble(xnum, xnumd) || !stringToDouble(ynum, ynumd))
     {
-        xnumd = std::stod(xnum);
-        ynumd = std::stod(ynum);
-    }
-    catch(const std::invalid_argument& ia)
-    {
-        error(ia.what());
+        error("Invalid number\n");
+        return false;
     }
 
     onOrigin(xnumd, ynumd);
@@ -499,7 +651,7 @@ bool LEFReader::parseSite()
 {
     // SITE name ';' 
 
-    std::string siteName;
+    std::string_view siteName;
     
 
     m_curtok = tokenize(siteName);
@@ -516,7 +668,7 @@ bool LEFReader::parseSite()
         return false;
     }
 
-    onSite(siteName);
+    onSite(std::string(siteName));
 
     //std::cout << "  SITE " << siteName << "\n";
 
@@ -528,8 +680,8 @@ bool LEFReader::parseSize()
     // SIZE <number> BY <number> ';' 
 
     
-    std::string xnum;
-    std::string ynum;
+    std::string_view xnum;
+    std::string_view ynum;
 
     m_curtok = tokenize(xnum);
     if (m_curtok != TOK_NUMBER)
@@ -560,14 +712,10 @@ bool LEFReader::parseSize()
     }
 
     double xnumd, ynumd;
-    try
+    if (!stringToDouble(xnum, xnumd) || !stringToDouble(ynum, ynumd))
     {
-        xnumd = std::stod(xnum);
-        ynumd = std::stod(ynum);
-    }
-    catch(const std::invalid_argument& ia)
-    {
-        error(ia.what());
+        error("Invalid number\n");
+        return false;
     }
 
     onSize(xnumd, ynumd);
@@ -602,9 +750,9 @@ bool LEFReader::parseForeign()
 {
     // FOREIGN <cellname> <number> <number> ; 
 
-    std::string cellname;
-    std::string xnum;
-    std::string ynum;
+    std::string_view cellname;
+    std::string_view xnum;
+    std::string_view ynum;
 
     m_curtok = tokenize(cellname);
     if (m_curtok != TOK_IDENT)
@@ -635,17 +783,13 @@ bool LEFReader::parseForeign()
     }
 
     double xnumd, ynumd;
-    try
+    if (!stringToDouble(xnum, xnumd) || !stringToDouble(ynum, ynumd))
     {
-        xnumd = std::stod(xnum);
-        ynumd = std::stod(ynum);
-    }
-    catch(const std::invalid_argument& ia)
-    {
-        error(ia.what());
+        error("Invalid number\n");
+        return false;
     }
 
-    onForeign(cellname, xnumd, ynumd);
+    onForeign(std::string(cellname), xnumd, ynumd);
 
     return true;
 };
@@ -654,16 +798,18 @@ bool LEFReader::parseForeign()
 bool LEFReader::parseDirection()
 {
     // DIRECTION OUTPUT/INPUT/INOUT etc.
-    std::string direction;
+    std::string_view dirtok;
 
     // read options until we get to the semicolon.
-    m_curtok = tokenize(direction);
+    m_curtok = tokenize(dirtok);
     if (m_curtok != TOK_IDENT)
     {
         error("Expected direction\n");
         return false;
     }
 
+    std::string direction(dirtok);
+
     m_curtok = tokenize(m_tokstr);
     if ((direction == "OUTPUT") && (m_tokstr == "TRISTATE"))
     {
@@ -688,7 +834,7 @@ bool LEFReader::parseUse()
 {
     // USE OUTPUT/INPUT/INOUT etc.
 
-    std::string use;
+    std::string_view use;
 
     m_curtok = tokenize(use);
     if (m_curtok != TOK_IDENT)
@@ -704,14 +850,14 @@ bool LEFReader::parseUse()
         return false;
     }    
 
-    onPinUse(use);
+    onPinUse(std::string(use));
 
     return true;
 };
 
 bool LEFReader::parsePort()
 {
-    std::string name;
+    std::string_view name;
     
 
     m_curtok = tokenize(m_tokstr);
@@ -754,7 +900,7 @@ bool LEFReader::parsePort()
             }
         }
 
-        if (m_is->eof())
+        if (atEOF())
         {
             error("Unexpected end of file\n");
             return false;
@@ -766,7 +912,7 @@ bool LEFReader::parsePort()
 bool LEFReader::parsePortLayer()
 {
     // LAYER <name> ';'
-    std::string name;
+    std::string_view name;
 
     m_curtok = tokenize(name);
     if (m_curtok != TOK_IDENT)
@@ -805,7 +951,7 @@ bool LEFReader::parsePortLayer()
 bool LEFReader::parseClassLayer()
 {
     // CLASS <name> ';'
-    std::string name;
+    std::string_view name;
 
     m_curtok = tokenize(name);
     if (m_curtok != TOK_IDENT)
@@ -828,7 +974,7 @@ bool LEFReader::parseClassLayer()
         return false;
     }
     
-    onPinLayerClass(name);
+    onPinLayerClass(std::string(name));
     
     return true;
 }
@@ -858,9 +1004,6 @@ bool LEFReader::parsePortLayerItem()
 
 bool LEFReader::parseRect()
 {
-    
-    std::string coords;
-
     for(uint32_t i=0; i<4; i++)
     {
         m_curtok = tokenize(m_tokstr);
@@ -869,8 +1012,6 @@ bool LEFReader::parseRect()
             error("Expected number in RECT\n");
             return false;
         }
-        coords += m_tokstr;
-        coords += " ";
     }
 
     // expect ; 
@@ -889,15 +1030,13 @@ bool LEFReader::parseRect()
         return false;
     }    
 
-    //std::cout << "      RECT " << coords << "\n";
-
     return true;
 }
 
 bool LEFReader::parseLayer()
 {
     m_curtok = tokenize(m_tokstr);
-    std::string layerName = m_tokstr;
+    std::string_view layerName = m_tokstr;
 
     if (m_curtok != TOK_IDENT)
     {
@@ -913,7 +1052,7 @@ bool LEFReader::parseLayer()
         return false;
     }
 
-    onLayer(layerName);
+    onLayer(std::string(layerName));
 
     // parse all the layer items
     do
@@ -1002,7 +1141,7 @@ bool LEFReader::parseLayerItem()
 
 bool LEFReader::parseLayerPitch()
 {
-    std::string pitch;
+    std::string_view pitch;
     m_curtok = tokenize(m_tokstr);
     if (m_curtok != TOK_NUMBER)
     {
@@ -1029,13 +1168,10 @@ bool LEFReader::parseLayerPitch()
     }
 
     double pitchd;
-    try
-    {
-        pitchd = std::stod(pitch);
-    }
-    catch(const std::invalid_argument& ia)
+    if (!stringToDouble(pitch, pitchd))
     {
-        error(ia.what());
+        error("Invalid number\n");
+        return false;
     }
 
     onLayerPitch(pitchd);
@@ -1045,7 +1181,7 @@ bool LEFReader::parseLayerPitch()
 
 bool LEFReader::parseLayerOffset()
 {
-    std::string offset;
+    std::string_view offset;
     m_curtok = tokenize(m_tokstr);
     if (m_curtok != TOK_NUMBER)
     {
@@ -1072,13 +1208,10 @@ bool LEFReader::parseLayerOffset()
     }
 
     double offsetd;
-    try
-    {
-        offsetd = std::stod(offset);
-    }
-    catch(const std::invalid_argument& ia)
+    if (!stringToDouble(offset, offsetd))
     {
-        error(ia.what());
+        error("Invalid number\n");
+        return false;
     }
 
     onLayerOffset(offsetd);
@@ -1088,7 +1221,7 @@ bool LEFReader::parseLayerOffset()
 
 bool LEFReader::parseLayerType()
 {
-    std::string layerType;
+    std::string_view layerType;
     m_curtok = tokenize(m_tokstr);
     if (m_curtok != TOK_IDENT)
     {
@@ -1114,14 +1247,14 @@ bool LEFReader::parseLayerType()
         return false;
     }
 
-    onLayerType(layerType);
+    onLayerType(std::string(layerType));
 
     return true;    
 }
 
 bool LEFReader::parseLayerWidth()
 {
-    std::string width;
+    std::string_view width;
     m_curtok = tokenize(m_tokstr);
     if (m_curtok != TOK_NUMBER)
     {
@@ -1148,13 +1281,10 @@ bool LEFReader::parseLayerWidth()
     }
 
     double widthd;
-    try
-    {
-        widthd = std::stod(width);
-    }
-    catch(const std::invalid_argument& ia)
+    if (!stringToDouble(width, widthd))
     {
-        error(ia.what());
+        error("Invalid number\n");
+        return false;
     }
 
     onLayerWidth(widthd);
@@ -1164,7 +1294,7 @@ bool LEFReader::parseLayerWidth()
 
 bool LEFReader::parseLayerMaxWidth()
 {
-    std::string maxwidth;
+    std::string_view maxwidth;
     m_curtok = tokenize(m_tokstr);
     if (m_curtok != TOK_NUMBER)
     {
@@ -1191,13 +1321,10 @@ bool LEFReader::parseLayerMaxWidth()
     }
 
     double maxwidthd;
-    try
-    {
-        maxwidthd = std::stod(maxwidth);
-    }
-    catch(const std::invalid_argument& ia)
+    if (!stringToDouble(maxwidth, maxwidthd))
     {
-        error(ia.what());
+        error("Invalid number\n");
+        return false;
     }
 
     onLayerMaxWidth(maxwidthd);
@@ -1207,7 +1334,7 @@ bool LEFReader::parseLayerMaxWidth()
 
 bool LEFReader::parseLayerDirection()
 {
-    std::string direction;
+    std::string_view direction;
     m_curtok = tokenize(m_tokstr);
     if (m_curtok != TOK_IDENT)
     {
@@ -1233,7 +1360,7 @@ bool LEFReader::parseLayerDirection()
         return false;
     }
 
-    onLayerDirection(direction);
+    onLayerDirection(std::string(direction));
 
     return true;  
 }
@@ -1245,7 +1372,7 @@ bool LEFReader::parseVia()
     // find END <vianame>
 
     m_curtok = tokenize(m_tokstr);
-    std::string viaName;
+    std::string_view viaName;
 
     if (m_curtok != TOK_IDENT)
     {
@@ -1290,7 +1417,7 @@ bool LEFReader::parseViaRule()
     // find END <vianame>
 
     m_curtok = tokenize(m_tokstr);
-    std::string viaRuleName;
+    std::string_view viaRuleName;
 
     if (m_curtok != TOK_IDENT)
     {
@@ -1363,13 +1490,9 @@ bool LEFReader::parseUnits()
                 if (m_curtok == TOK_NUMBER)
                 {
                     double micronsd;
-                    try
-                    {
-                        micronsd = std::stod(m_tokstr);
-                    }
-                    catch(const std::invalid_argument& ia)
+                    if (!stringToDouble(m_tokstr, micronsd))
                     {
-                        error(ia.what());
+                        error("Invalid number after DATABASE MICRONS\n");
                         return false;
                     }
 
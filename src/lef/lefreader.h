@@ -23,6 +23,7 @@
 #include<list>
 #include<vector>
 #include<string>
+#include<string_view>
 #include<iostream>
 #include<regex>
 
@@ -34,7 +35,8 @@
 class LEFReader
 {
 public:
-    LEFReader() {}
+    LEFReader() : m_ptr(nullptr), m_end(nullptr), m_lineNum(0),
+        m_skipMacros(false), m_skippedMacros(0) {}
     
     virtual ~LEFReader() {}
 
@@ -55,8 +57,18 @@ public:
         TOK_ERR
     };
 
+    /** parse a LEF stream. The stream is read into memory first,
+        prefer parseFile when reading from disk. */
     void parse(std::istream &leffile);
 
+    /** parse a LEF file by memory-mapping it.
+        returns false if the file cannot be opened. */
+    bool parseFile(const std::string &filename);
+
+    /** parse a LEF file held in memory. The buffer must
+        remain valid until parsing has finished. */
+    void parse(const char *data, size_t len);
+
     /** callback for each LEF macro */
     virtual void onMacro(const std::string &macroName) {}
 
@@ -117,6 +129,25 @@ public:
     /** callback for units database microns */
     virtual void onDatabaseUnitsMicrons(double unitsPerMicron) {}
 
+    /** called before a macro is parsed when macro skipping is enabled.
+        className holds the CLASS of the macro, e.g. "PAD SPACER ".
+        Return false to skip the macro body without any callbacks.
+    */
+    virtual bool isMacroWanted(const std::string_view &macroName,
+        const std::string_view &className) { return true; }
+
+    /** enable or disable skipping of macros using isMacroWanted */
+    void setMacroSkipping(bool enable)
+    {
+        m_skipMacros = enable;
+    }
+
+    /** number of macros skipped during parsing */
+    uint32_t getSkippedMacroCount() const
+    {
+        return m_skippedMacros;
+    }
+
 protected:
     bool isWhitespace(char c) const;
     bool isAlpha(char c) const;
@@ -124,6 +155,14 @@ protected:
     bool isAlphaNumeric(char c) const;
 
     bool parseMacro();
+
+    /** fast-scan a macro body up to its 'END name' line, without
+        tokenizing it. Returns the macro CLASS, the position after the
+        END line and the number of lines scanned.
+        returns false if the end of the macro cannot be found.
+    */
+    bool scanMacro(const std::string_view &name, std::string &className,
+        const char *&next, uint32_t &lineCount) const;
     bool parseClass();
     bool parseOrigin();
     bool parseForeign();
@@ -156,16 +195,26 @@ protected:
 
     bool parsePropertyDefintions();
 
-    token_t tokenize(std::string &tokstr);
-    char         m_tokchar;
+    /** get the next token. tokstr is a view into the input buffer. */
+    token_t tokenize(std::string_view &tokstr);
+
+    /** true if the whole input buffer has been consumed */
+    bool atEOF() const
+    {
+        return m_ptr >= m_end;
+    }
 
     LEFReader::token_t m_curtok;
-    std::string        m_tokstr;
+    std::string_view   m_tokstr;
 
     void error(const std::string &errstr);
 
-    std::istream *m_is;
+    const char   *m_ptr;    ///< current read position in the input buffer
+    const char   *m_end;    ///< end of the input buffer
     uint32_t      m_lineNum;
+
+    bool          m_skipMacros;     ///< call isMacroWanted and skip unwanted macros
+    uint32_t      m_skippedMacros;  ///< number of skipped macros
 };
 
 
@@ -0,0 +1,495 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "logging.h"
+#include "stats.h"
+#include "lefcache.h"
+
+static const char     gs_magic[8]  = {'P','R','L','E','F','C','\0','\0'};
+static const uint32_t gs_version   = 2;
+static const uint32_t gs_byteOrder = 0x01020304;
+
+static const uint32_t FLAG_FILLER  = 1;
+
+struct LEFCache::Header
+{
+    char     m_magic[8];        ///< "PRLEFC"
+    uint32_t m_version;         ///< cache format version
+    uint32_t m_byteOrder;       ///< 0x01020304 in the writer's byte order
+    uint64_t m_fileSize;        ///< size of the LEF file
+    int64_t  m_mtime;           ///< modification time of the LEF file
+    uint64_t m_contentHash;     ///< hash of the LEF file contents
+    double   m_databaseUnits;   ///< LEF database units, 0 if not specified
+    uint32_t m_cellCount;       ///< number of cells
+    uint32_t m_pinCount;        ///< total number of pins
+    uint64_t m_indexOffset;     ///< file offset of the IndexEntry array
+    uint64_t m_cellOffset;      ///< file offset of the CellRecord array
+    uint64_t m_pinOffset;       ///< file offset of the PinRecord array
+    uint64_t m_stringOffset;    ///< file offset of the string table
+    uint64_t m_stringSize;      ///< size of the string table in bytes
+    uint32_t m_pathOffset;      ///< LEF file path in the string table
+    uint32_t m_pathLength;
+};
+
+/** index entries are sorted by name */
+struct LEFCache::IndexEntry
+{
+    uint32_t m_nameOffset;
+    uint32_t m_nameLength;
+    uint32_t m_cellIndex;       ///< index into the CellRecord array
+    uint32_t m_flags;           ///< FLAG_xxx
+};
+
+struct LEFCache::CellRecord
+{
+    uint32_t m_nameOffset;
+    uint32_t m_nameLength;
+    uint32_t m_foreignOffset;
+    uint32_t m_foreignLength;
+    uint32_t m_symmetryOffset;
+    uint32_t m_symmetryLength;
+    uint32_t m_firstPin;        ///< index of first pin in the PinRecord array
+    uint32_t m_pinCount;
+    uint32_t m_flags;           ///< FLAG_xxx
+    uint32_t m_reserved;
+    double   m_sx;
+    double   m_sy;
+};
+
+struct LEFCache::PinRecord
+{
+    uint32_t m_nameOffset;
+    uint32_t m_nameLength;
+    int32_t  m_dir;
+    int32_t  m_class;
+    int32_t  m_use;
+    uint32_t m_reserved;
+};
+
+/** 64-bit hash, consuming eight bytes per step */
+static uint64_t hashBytes(const char *data, size_t len)
+{
+    const uint64_t prime = 0x9E3779B97F4A7C15ULL;
+    uint64_t h = 0xCBF29CE484222325ULL ^ len;
+
+    size_t i = 0;
+    for(; (i+8) <= len; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        h ^= word;
+        h *= prime;
+        h ^= h >> 29;
+    }
+
+    for(; i < len; i++)
+    {
+        h ^= static_cast<uint8_t>(data[i]);
+        h *= prime;
+    }
+
+    h ^= h >> 32;
+    return h;
+}
+
+bool LEFCache::computeKey(const std::string &lefFilename, Key &key)
+{
+    struct stat st;
+    if (stat(lefFilename.c_str(), &st) != 0)
+    {
+        return false;
+    }
+
+#ifdef _WIN32
+    char fullpath[_MAX_PATH];
+    if (_fullpath(fullpath, lefFilename.c_str(), _MAX_PATH) == nullptr)
+    {
+        return false;
+    }
+    key.m_path = fullpath;
+#else
+    char *fullpath = realpath(lefFilename.c_str(), nullptr);
+    if (fullpath == nullptr)
+    {
+        return false;
+    }
+    key.m_path = fullpath;
+    free(fullpath);
+#endif
+
+    key.m_fileSize = st.st_size;
+#if defined(__linux__)
+    key.m_mtime = static_cast<int64_t>(st.st_mtim.tv_sec)*1000000000LL + st.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+    key.m_mtime = static_cast<int64_t>(st.st_mtimespec.tv_sec)*1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    key.m_mtime = static_cast<int64_t>(st.st_mtime)*1000000000LL;
+#endif
+
+    MappedFile lefFile;
+    if (!lefFile.open(lefFilename))
+    {
+        return false;
+    }
+    key.m_contentHash = hashBytes(lefFile.data(), lefFile.size());
+    return true;
+}
+
+std::string LEFCache::getCacheFilename(const std::string &cacheDir, const Key &key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.lefc",
+        static_cast<unsigned long long>(hashBytes(key.m_path.data(), key.m_path.size())));
+
+    if (cacheDir.empty())
+    {
+        return name;
+    }
+
+    char last = cacheDir.back();
+    if ((last == '/') || (last == '\\'))
+    {
+        return cacheDir + name;
+    }
+    return cacheDir + "/" + name;
+}
+
+/** append a string to the string table and return its offset */
+static uint32_t addString(std::vector<char> &strings, const std::string_view &str)
+{
+    uint32_t offset = static_cast<uint32_t>(strings.size());
+    strings.insert(strings.end(), str.begin(), str.end());
+    return offset;
+}
+
+/** append a POD array to the output buffer, aligned to 8 bytes */
+template<class T> static uint64_t appendArray(std::vector<char> &buffer, const std::vector<T> &items)
+{
+    while((buffer.size() % 8) != 0)
+    {
+        buffer.push_back(0);
+    }
+
+    uint64_t offset = buffer.size();
+    const char *ptr = reinterpret_cast<const char*>(items.data());
+    buffer.insert(buffer.end(), ptr, ptr + items.size()*sizeof(T));
+    return offset;
+}
+
+bool LEFCache::write(const std::string &cacheFilename, const Key &key,
+    const PRLEFReader &reader)
+{
+    // sort the cells by name so lookups can use a binary search
+    std::vector<const PRLEFReader::LEFCellInfo_t*> cells;
+    cells.reserve(reader.m_cells.size());
+    for(auto const &cell : reader.m_cells)
+    {
+        cells.push_back(cell.second);
+    }
+    std::sort(cells.begin(), cells.end(),
+        [](const PRLEFReader::LEFCellInfo_t *a, const PRLEFReader::LEFCellInfo_t *b)
+        {
+            return a->m_name < b->m_name;
+        });
+
+    std::vector<char>       strings;
+    std::vector<IndexEntry> index;
+    std::vector<CellRecord> cellRecords;
+    std::vector<PinRecord>  pinRecords;
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, gs_magic, sizeof(gs_magic));
+    header.m_version        = gs_version;
+    header.m_byteOrder      = gs_byteOrder;
+    header.m_fileSize       = key.m_fileSize;
+    header.m_mtime          = key.m_mtime;
+    header.m_contentHash    = key.m_contentHash;
+    header.m_databaseUnits  = reader.m_lefDatabaseUnits;
+    header.m_pathOffset     = addString(strings, key.m_path);
+    header.m_pathLength     = key.m_path.size();
+
+    for(auto info : cells)
+    {
+        CellRecord record;
+        memset(&record, 0, sizeof(record));
+        record.m_nameOffset     = addString(strings, info->m_name);
+        record.m_nameLength     = info->m_name.size();
+        record.m_foreignOffset  = addString(strings, info->m_foreign);
+        record.m_foreignLength  = info->m_foreign.size();
+        record.m_symmetryOffset = addString(strings, info->m_symmetry);
+        record.m_symmetryLength = info->m_symmetry.size();
+        record.m_firstPin       = pinRecords.size();
+        record.m_pinCount       = info->m_pins.size();
+        record.m_flags          = info->m_isFiller ? FLAG_FILLER : 0;
+        record.m_sx             = info->m_sx;
+        record.m_sy             = info->m_sy;
+
+        for(auto const &pin : info->m_pins)
+        {
+            PinRecord pinRecord;
+            memset(&pinRecord, 0, sizeof(pinRecord));
+            pinRecord.m_nameOffset = addString(strings, pin.m_name);
+            pinRecord.m_nameLength = pin.m_name.size();
+            pinRecord.m_dir        = pin.m_dir;
+            pinRecord.m_class      = pin.m_class;
+            pinRecord.m_use        = pin.m_use;
+            pinRecords.push_back(pinRecord);
+        }
+
+        IndexEntry entry;
+        entry.m_nameOffset = record.m_nameOffset;
+        entry.m_nameLength = record.m_nameLength;
+        entry.m_cellIndex  = cellRecords.size();
+        entry.m_flags      = record.m_flags;
+        index.push_back(entry);
+
+        cellRecords.push_back(record);
+    }
+
+    header.m_cellCount = cellRecords.size();
+    header.m_pinCount  = pinRecords.size();
+
+    std::vector<char> buffer(sizeof(Header), 0);
+    header.m_indexOffset  = appendArray(buffer, index);
+    header.m_cellOffset   = appendArray(buffer, cellRecords);
+    header.m_pinOffset    = appendArray(buffer, pinRecords);
+    header.m_stringOffset = appendArray(buffer, strings);
+    header.m_stringSize   = strings.size();
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    // write to a temporary file first and rename it, so
+    // other processes never map a partially written cache.
+    std::string tmpFilename = cacheFilename + ".tmp" + std::to_string(getpid());
+    FILE *fout = fopen(tmpFilename.c_str(), "wb");
+    if (fout == nullptr)
+    {
+        doLog(LOG_WARN, "Cannot create LEF cache file %s\n", tmpFilename.c_str());
+        return false;
+    }
+
+    bool ok = (fwrite(buffer.data(), 1, buffer.size(), fout) == buffer.size());
+    ok = (fclose(fout) == 0) && ok;
+
+#ifdef _WIN32
+    remove(cacheFilename.c_str());
+#endif
+    if (!ok || (rename(tmpFilename.c_str(), cacheFilename.c_str()) != 0))
+    {
+        doLog(LOG_WARN, "Cannot write LEF cache file %s\n", cacheFilename.c_str());
+        remove(tmpFilename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool LEFCache::open(const std::string &cacheFilename, const Key &key)
+{
+    m_header = nullptr;
+
+    if (!m_file.open(cacheFilename))
+    {
+        return false;
+    }
+
+    const size_t size = m_file.size();
+    if (size < sizeof(Header))
+    {
+        return false;
+    }
+
+    const Header *header = reinterpret_cast<const Header*>(m_file.data());
+    if ((memcmp(header->m_magic, gs_magic, sizeof(gs_magic)) != 0) ||
+        (header->m_version != gs_version) ||
+        (header->m_byteOrder != gs_byteOrder))
+    {
+        return false;
+    }
+
+    // check that all the tables are within the file and aligned.
+    // the offsets are checked first, so the sums cannot overflow.
+    if ((header->m_indexOffset > size) || (header->m_cellOffset > size) ||
+        (header->m_pinOffset > size) || (header->m_stringOffset > size) ||
+        ((header->m_indexOffset | header->m_cellOffset | header->m_pinOffset) % 8 != 0) ||
+        (header->m_indexOffset + static_cast<uint64_t>(header->m_cellCount)*sizeof(IndexEntry) > size) ||
+        (header->m_cellOffset  + static_cast<uint64_t>(header->m_cellCount)*sizeof(CellRecord) > size) ||
+        (header->m_pinOffset   + static_cast<uint64_t>(header->m_pinCount)*sizeof(PinRecord) > size) ||
+        (header->m_stringOffset + header->m_stringSize > size) ||
+        (static_cast<uint64_t>(header->m_pathOffset) + header->m_pathLength > header->m_stringSize))
+    {
+        return false;
+    }
+
+    m_header      = header;
+    m_index       = reinterpret_cast<const IndexEntry*>(m_file.data() + header->m_indexOffset);
+    m_cellRecords = reinterpret_cast<const CellRecord*>(m_file.data() + header->m_cellOffset);
+    m_pinRecords  = reinterpret_cast<const PinRecord*>(m_file.data() + header->m_pinOffset);
+    m_strings     = m_file.data() + header->m_stringOffset;
+
+    // a damaged record would make loadCell read outside
+    // the file, so the cache is rebuilt instead.
+    if (!checkRecords())
+    {
+        m_header = nullptr;
+        return false;
+    }
+
+    // finally, check the cache belongs to this exact LEF file
+    if ((header->m_fileSize != key.m_fileSize) ||
+        (header->m_mtime != key.m_mtime) ||
+        (header->m_contentHash != key.m_contentHash) ||
+        (getString(header->m_pathOffset, header->m_pathLength) != key.m_path))
+    {
+        m_header = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+std::string_view LEFCache::getString(uint32_t offset, uint32_t length) const
+{
+    return std::string_view(m_strings + offset, length);
+}
+
+bool LEFCache::checkRecords() const
+{
+    const uint64_t stringSize = m_header->m_stringSize;
+    auto isString = [stringSize](uint32_t offset, uint32_t length)
+    {
+        return static_cast<uint64_t>(offset) + length <= stringSize;
+    };
+
+    for(uint32_t i=0; i<m_header->m_cellCount; i++)
+    {
+        const IndexEntry &entry = m_index[i];
+        if (!isString(entry.m_nameOffset, entry.m_nameLength) ||
+            (entry.m_cellIndex >= m_header->m_cellCount))
+        {
+            return false;
+        }
+
+        const CellRecord &record = m_cellRecords[i];
+        if (!isString(record.m_nameOffset, record.m_nameLength) ||
+            !isString(record.m_foreignOffset, record.m_foreignLength) ||
+            !isString(record.m_symmetryOffset, record.m_symmetryLength) ||
+            (static_cast<uint64_t>(record.m_firstPin) + record.m_pinCount > m_header->m_pinCount))
+        {
+            return false;
+        }
+    }
+
+    for(uint32_t i=0; i<m_header->m_pinCount; i++)
+    {
+        const PinRecord &pin = m_pinRecords[i];
+        if (!isString(pin.m_nameOffset, pin.m_nameLength))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t LEFCache::getCellCount() const
+{
+    return (m_header != nullptr) ? m_header->m_cellCount : 0;
+}
+
+double LEFCache::getDatabaseUnits() const
+{
+    return (m_header != nullptr) ? m_header->m_databaseUnits : 0.0;
+}
+
+int32_t LEFCache::findCell(const std::string_view &name) const
+{
+    uint32_t lo = 0;
+    uint32_t hi = getCellCount();
+    while(lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = getString(m_index[mid].m_nameOffset, m_index[mid].m_nameLength).compare(name);
+        if (cmp == 0)
+        {
+            return m_index[mid].m_cellIndex;
+        }
+        else if (cmp < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return -1;
+}
+
+std::string_view LEFCache::getCellName(uint32_t cellIndex) const
+{
+    const CellRecord &record = m_cellRecords[cellIndex];
+    return getString(record.m_nameOffset, record.m_nameLength);
+}
+
+bool LEFCache::isFiller(uint32_t cellIndex) const
+{
+    return (m_cellRecords[cellIndex].m_flags & FLAG_FILLER) != 0;
+}
+
+PRLEFReader::LEFCellInfo_t* LEFCache::loadCell(uint32_t cellIndex, PRLEFReader &reader) const
+{
+    Stats::count(STAT_LEF_CACHED_CELLS);
+
+    const CellRecord &record = m_cellRecords[cellIndex];
+
+    PRLEFReader::LEFCellInfo_t *cell = reader.createCell(getString(record.m_nameOffset, record.m_nameLength));
+    cell->m_foreign  = reader.intern(getString(record.m_foreignOffset, record.m_foreignLength));
+    cell->m_symmetry = reader.intern(getString(record.m_symmetryOffset, record.m_symmetryLength));
+    cell->m_sx       = record.m_sx;
+    cell->m_sy       = record.m_sy;
+    cell->m_isFiller = (record.m_flags & FLAG_FILLER) != 0;
+
+    std::vector<PRLEFReader::LEFPinInfo_t> pins(record.m_pinCount);
+    for(uint32_t i=0; i<record.m_pinCount; i++)
+    {
+        const PinRecord &pinRecord = m_pinRecords[record.m_firstPin + i];
+        pins[i].m_name  = reader.intern(getString(pinRecord.m_nameOffset, pinRecord.m_nameLength));
+        pins[i].m_dir   = pinRecord.m_dir;
+        pins[i].m_class = pinRecord.m_class;
+        pins[i].m_use   = pinRecord.m_use;
+    }
+    reader.setCellPins(cell, pins);
+
+    return cell;
+}
@@ -0,0 +1,118 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef lefcache_h
+#define lefcache_h
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+#include "mappedfile.h"
+#include "prlefreader.h"
+
+/** Precompiled, memory-mapped LEF cell database.
+
+    A cache file holds the cells of one LEF file in a flat
+    binary format: a header, a name-sorted index, the cell
+    and pin records and a string table. Cells are only turned
+    into LEFCellInfo_t objects when they are looked up.
+
+    A cache is only used when the path, size, modification time
+    and content hash of its LEF file match the ones stored in
+    the header.
+*/
+class LEFCache
+{
+public:
+    /** identifies the exact LEF file a cache was built from */
+    struct Key
+    {
+        Key() : m_fileSize(0), m_mtime(0), m_contentHash(0) {}
+
+        std::string m_path;         ///< absolute path of the LEF file
+        uint64_t    m_fileSize;     ///< size of the LEF file in bytes
+        int64_t     m_mtime;        ///< modification time in nanoseconds
+        uint64_t    m_contentHash;  ///< hash of the LEF file contents
+    };
+
+    LEFCache() : m_header(nullptr) {}
+    virtual ~LEFCache() {}
+
+    /** determine the cache key of a LEF file.
+        returns false if the file cannot be read.
+    */
+    static bool computeKey(const std::string &lefFilename, Key &key);
+
+    /** name of the cache file for a key in a cache directory */
+    static std::string getCacheFilename(const std::string &cacheDir, const Key &key);
+
+    /** write all cells of a reader to a cache file.
+        The file is written under a temporary name and renamed
+        when complete, so concurrent runs never see partial files.
+    */
+    static bool write(const std::string &cacheFilename, const Key &key,
+        const PRLEFReader &reader);
+
+    /** open a cache file. returns false if it does not exist,
+        is damaged or does not belong to the given key.
+    */
+    bool open(const std::string &cacheFilename, const Key &key);
+
+    /** number of cells in the cache */
+    uint32_t getCellCount() const;
+
+    /** find a cell by name. returns -1 if it is not in the cache. */
+    int32_t findCell(const std::string_view &name) const;
+
+    /** name of a cell */
+    std::string_view getCellName(uint32_t cellIndex) const;
+
+    /** true if the cell is a filler cell */
+    bool isFiller(uint32_t cellIndex) const;
+
+    /** create a LEFCellInfo_t for a cell in the reader's arena.
+        The cell is not added to the reader's database.
+    */
+    PRLEFReader::LEFCellInfo_t* loadCell(uint32_t cellIndex, PRLEFReader &reader) const;
+
+    /** database units of the LEF file, 0 if not specified */
+    double getDatabaseUnits() const;
+
+    struct Header;
+    struct IndexEntry;
+    struct CellRecord;
+    struct PinRecord;
+
+protected:
+    std::string_view getString(uint32_t offset, uint32_t length) const;
+
+    /** true if all the strings and pins of the records
+        are within their tables */
+    bool checkRecords() const;
+
+    MappedFile      m_file;
+    const Header    *m_header;
+    const IndexEntry*m_index;
+    const CellRecord*m_cellRecords;
+    const PinRecord *m_pinRecords;
+    const char      *m_strings;
+};
+
+#endif
@@ -17,58 +17,498 @@
     
 */
 
-#include <iostream>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <algorithm>
 #include "logging.h"
 
-static uint32_t gs_loglevel = LOG_INFO;
+static std::atomic<uint32_t> gs_loglevel(LOG_INFO);
 
-void setLogLevel(uint32_t level)
+/** one slot of a log buffer. Messages that do not fit
+    in one slot take several consecutive slots. */
+struct LogRecord
+{
+    uint64_t    m_seq;      ///< order in which the message was logged
+    uint32_t    m_level;
+    uint16_t    m_length;   ///< number of characters in m_text
+    uint16_t    m_slots;    ///< slots of the message, set in the first one
+    char        m_text[496];
+};
+
+/** single-producer, single-consumer ring of log records.
+    The owning thread appends, the writer thread removes. */
+struct LogRing
+{
+    static const uint32_t c_size = 256;   ///< slots, a power of two
+
+    LogRing() : m_head(0), m_tail(0), m_owned(true) {}
+
+    bool isEmpty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    LogRecord               m_records[c_size];
+    std::atomic<uint32_t>   m_head;     ///< next slot to write out
+    std::atomic<uint32_t>   m_tail;     ///< next slot to fill
+    std::atomic<bool>       m_owned;    ///< a thread is using the ring
+};
+
+/** Owns the log rings and the background writer thread */
+class AsyncLogger
+{
+public:
+    AsyncLogger() : m_ringCount(0), m_seq(0), m_written(0), m_nextSeq(0), m_state(STATE_IDLE), m_idle(false) 
+    {
+        for(uint32_t i=0; i<c_maxRings; i++)
+        {
+            m_rings[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    /** log a formatted message */
+    void write(uint32_t level, const char *text, size_t length);
+
+    /** wait until everything logged so far is written */
+    void flush();
+
+    /** write everything and stop the writer thread.
+        Later messages are written directly. */
+    void stop();
+
+    static AsyncLogger& get()
+    {
+        // never destroyed: threads may log during exit
+        static AsyncLogger *logger = new AsyncLogger();
+        return *logger;
+    }
+
+protected:
+    enum state_t
+    {
+        STATE_IDLE,     ///< writer not started yet
+        STATE_RUNNING,
+        STATE_STOPPED
+    };
+
+    /** find or create the ring of the calling thread */
+    LogRing* getThreadRing();
+
+    /** start the writer thread on the first message */
+    void start();
+
+    /** the writer thread */
+    void run();
+
+    /** write out all the complete messages in the rings,
+        oldest first. returns the number of messages. */
+    size_t drain();
+
+    /** write a message to stdout or stderr */
+    void output(FILE *&lastStream, uint32_t level, const char *text, size_t length);
+
+    static const uint32_t c_maxRings = 256;
+
+    std::atomic<LogRing*>   m_rings[c_maxRings];
+    std::atomic<uint32_t>   m_ringCount;
+    std::mutex              m_ringMutex;    ///< protects adding rings
+
+    std::atomic<uint64_t>   m_seq;          ///< messages logged
+    std::atomic<uint64_t>   m_written;      ///< messages written
+    uint64_t                m_nextSeq;      ///< sequence number the writer thread writes next
+    std::atomic<uint32_t>   m_state;
+    std::once_flag          m_startFlag;
+    std::thread             m_writer;
+
+    std::mutex              m_mutex;        ///< for the condition variables
+    std::condition_variable m_wake;         ///< wakes the writer
+    std::condition_variable m_flushed;      ///< signals written messages
+    std::atomic<bool>       m_idle;         ///< the writer is waiting for messages
+
+    std::mutex              m_directMutex;  ///< for writing without the writer thread
+};
+
+/** releases the ring of a thread when the thread ends */
+struct ThreadRing
+{
+    ThreadRing() : m_ring(nullptr) {}
+    ~ThreadRing()
+    {
+        if (m_ring != nullptr)
+        {
+            m_ring->m_owned.store(false, std::memory_order_release);
+        }
+    }
+
+    LogRing *m_ring;
+};
+
+static thread_local ThreadRing gs_threadRing;
+static thread_local std::string gs_threadFields;    ///< rendered LogFields of the thread
+
+static void stopLogger()
+{
+    AsyncLogger::get().stop();
+}
+
+void AsyncLogger::start()
 {
-    gs_loglevel = level;
+    std::call_once(m_startFlag, [this]()
+    {
+        m_writer = std::thread(&AsyncLogger::run, this);
+        m_state.store(STATE_RUNNING, std::memory_order_release);
+        atexit(stopLogger);
+    });
 }
 
-void doLog(uint32_t t, const std::string &txt)
+LogRing* AsyncLogger::getThreadRing()
 {
-    doLog(t, txt.c_str());
+    if (gs_threadRing.m_ring != nullptr)
+    {
+        return gs_threadRing.m_ring;
+    }
+
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+
+    // reuse the ring of a thread that has ended,
+    // once its messages have been written.
+    uint32_t count = m_ringCount.load(std::memory_order_relaxed);
+    for(uint32_t i=0; i<count; i++)
+    {
+        LogRing *ring = m_rings[i].load(std::memory_order_relaxed);
+        if ((!ring->m_owned.load(std::memory_order_acquire)) && ring->isEmpty())
+        {
+            ring->m_owned.store(true, std::memory_order_relaxed);
+            gs_threadRing.m_ring = ring;
+            return ring;
+        }
+    }
+
+    if (count == c_maxRings)
+    {
+        return nullptr;
+    }
+
+    LogRing *ring = new LogRing();
+    m_rings[count].store(ring, std::memory_order_release);
+    m_ringCount.store(count + 1, std::memory_order_release);
+    gs_threadRing.m_ring = ring;
+    return ring;
 }
 
-void doLog(uint32_t t, const char *format, ...)
-{   
-    if (t < gs_loglevel)
+void AsyncLogger::write(uint32_t level, const char *text, size_t length)
+{
+    if (m_state.load(std::memory_order_acquire) == STATE_IDLE)
+    {
+        start();
+    }
+
+    LogRing *ring = nullptr;
+    if (m_state.load(std::memory_order_acquire) == STATE_RUNNING)
+    {
+        ring = getThreadRing();
+    }
+
+    if (ring == nullptr)
     {
+        // stopped, or too many threads: write directly
+        std::lock_guard<std::mutex> lock(m_directMutex);
+        FILE *lastStream = nullptr;
+        output(lastStream, level, text, length);
+        fflush(lastStream);
         return;
     }
 
-    FILE *sout = stdout;
+    const size_t slotText = sizeof(LogRecord::m_text);
+    uint32_t slots = static_cast<uint32_t>((length + slotText - 1) / slotText);
+    if (slots == 0)
+    {
+        slots = 1;
+    }
+    if (slots > LogRing::c_size)
+    {
+        slots  = LogRing::c_size;
+        length = slots * slotText;
+    }
+
+    // wait for room; only the writer thread frees slots.
+    uint32_t tail = ring->m_tail.load(std::memory_order_relaxed);
+    while((tail - ring->m_head.load(std::memory_order_acquire)) > (LogRing::c_size - slots))
+    {
+        m_wake.notify_one();
+        std::this_thread::yield();
+    }
 
-    switch(t)
+    // the writer waits for a missing sequence number, so
+    // nothing may block between taking it and publishing.
+    uint64_t seq = m_seq.fetch_add(1, std::memory_order_relaxed);
+    for(uint32_t i=0; i<slots; i++)
+    {
+        LogRecord &record = ring->m_records[(tail + i) & (LogRing::c_size-1)];
+        size_t chunk = std::min(length - i*slotText, slotText);
+        record.m_seq    = seq;
+        record.m_level  = level;
+        record.m_length = static_cast<uint16_t>(chunk);
+        record.m_slots  = static_cast<uint16_t>(slots);
+        memcpy(record.m_text, text + i*slotText, chunk);
+    }
+
+    // publish the whole message at once
+    ring->m_tail.store(tail + slots, std::memory_order_release);
+
+    if (m_idle.load(std::memory_order_acquire))
+    {
+        m_wake.notify_one();
+    }
+}
+
+void AsyncLogger::output(FILE *&lastStream, uint32_t level, const char *text, size_t length)
+{
+    FILE *sout = (level == LOG_ERROR) ? stderr : stdout;
+
+    // keep stdout and stderr in order when
+    // they go to the same place.
+    if ((lastStream != nullptr) && (lastStream != sout))
+    {
+        fflush(lastStream);
+    }
+    lastStream = sout;
+
+    switch(level)
     {
     case LOG_INFO:
-        fprintf(sout, "[INFO] ");
+        fputs("[INFO] ", sout);
         break;
     case LOG_DEBUG:
-        fprintf(sout, "[DBG ] ");
+        fputs("[DBG ] ", sout);
         break;
     case LOG_WARN:
-        fprintf(sout, "[WARN] ");
+        fputs("[WARN] ", sout);
         break;
     case LOG_ERROR:
-        sout = stderr;
-        fprintf(sout, "[ERR ] ");
+        fputs("[ERR ] ", sout);
         break;
     case LOG_VERBOSE:
-        fprintf(stdout, "[VERB] ");
+        fputs("[VERB] ", sout);
         break;
     default:
         break;
     }
 
-    //FIXME: change to C++ style
+    fwrite(text, 1, length, sout);
+}
+
+size_t AsyncLogger::drain()
+{
+    FILE *lastStream = nullptr;
+    size_t messages = 0;
+    while(true)
+    {
+        // merge the rings by sequence number
+        LogRing *oldest = nullptr;
+        uint64_t oldestSeq = 0;
+        uint32_t count = m_ringCount.load(std::memory_order_acquire);
+        for(uint32_t i=0; i<count; i++)
+        {
+            LogRing *ring = m_rings[i].load(std::memory_order_acquire);
+            uint32_t head = ring->m_head.load(std::memory_order_relaxed);
+            if (head == ring->m_tail.load(std::memory_order_acquire))
+            {
+                continue;
+            }
+
+            uint64_t seq = ring->m_records[head & (LogRing::c_size-1)].m_seq;
+            if ((oldest == nullptr) || (seq < oldestSeq))
+            {
+                oldest = ring;
+                oldestSeq = seq;
+            }
+        }
+
+        if (oldest == nullptr)
+        {
+            break;
+        }
+
+        // every sequence number is published, right after it
+        // is taken. A gap means another thread is still copying
+        // an earlier message into its ring, so wait for it.
+        if (oldestSeq != m_nextSeq)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint32_t head = oldest->m_head.load(std::memory_order_relaxed);
+        const LogRecord &first = oldest->m_records[head & (LogRing::c_size-1)];
+        uint32_t slots = first.m_slots;
+        for(uint32_t i=0; i<slots; i++)
+        {
+            const LogRecord &record = oldest->m_records[(head + i) & (LogRing::c_size-1)];
+            if (i == 0)
+            {
+                output(lastStream, record.m_level, record.m_text, record.m_length);
+            }
+            else
+            {
+                fwrite(record.m_text, 1, record.m_length, lastStream);
+            }
+        }
+        oldest->m_head.store(head + slots, std::memory_order_release);
+        m_nextSeq++;
+        messages++;
+    }
+
+    if (messages > 0)
+    {
+        fflush(stdout);
+        fflush(stderr);
+    }
+    return messages;
+}
+
+void AsyncLogger::run()
+{
+    while(true)
+    {
+        size_t messages = drain();
+        if (messages > 0)
+        {
+            m_written.fetch_add(messages, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_flushed.notify_all();
+            continue;
+        }
+
+        if (m_state.load(std::memory_order_acquire) == STATE_STOPPED)
+        {
+            break;
+        }
+
+        // a wake-up can be missed between draining and
+        // waiting; the time-out bounds the delay.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.store(true, std::memory_order_release);
+        m_wake.wait_for(lock, std::chrono::milliseconds(20));
+        m_idle.store(false, std::memory_order_release);
+    }
+}
+
+void AsyncLogger::flush()
+{
+    if (m_state.load(std::memory_order_acquire) != STATE_RUNNING)
+    {
+        return;
+    }
+
+    uint64_t target = m_seq.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(m_written.load(std::memory_order_acquire) < target)
+    {
+        m_wake.notify_one();
+        m_flushed.wait_for(lock, std::chrono::milliseconds(20));
+    }
+}
+
+void AsyncLogger::stop()
+{
+    if (m_state.load(std::memory_order_acquire) != STATE_RUNNING)
+    {
+        return;
+    }
+
+    flush();
+    m_state.store(STATE_STOPPED, std::memory_order_release);
+    m_wake.notify_one();
+    m_writer.join();
+}
+
+void setLogLevel(uint32_t level)
+{
+    gs_loglevel.store(level, std::memory_order_relaxed);
+}
+
+uint32_t getLogLevel()
+{
+    return gs_loglevel.load(std::memory_order_relaxed);
+}
+
+void flushLog()
+{
+    AsyncLogger::get().flush();
+}
+
+/** format a message behind the fields of the thread */
+static void formatMessage(std::string &message, const char *format, va_list args)
+{
+    message = gs_threadFields;
+    size_t prefix = message.size();
+
+    char buffer[512];
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(buffer, sizeof(buffer), format, copy);
+    va_end(copy);
+
+    if (length < 0)
+    {
+        return;
+    }
+
+    if (static_cast<size_t>(length) < sizeof(buffer))
+    {
+        message.append(buffer, length);
+        return;
+    }
+
+    message.resize(prefix + length + 1);
+    vsnprintf(&message[prefix], length + 1, format, args);
+    message.resize(prefix + length);
+}
+
+void writeLog(uint32_t t, const std::string &txt)
+{
+    if (gs_threadFields.empty())
+    {
+        AsyncLogger::get().write(t, txt.data(), txt.size());
+        return;
+    }
+
+    std::string message = gs_threadFields + txt;
+    AsyncLogger::get().write(t, message.data(), message.size());
+}
+
+void writeLog(uint32_t t, const char *format, ...)
+{
+    static thread_local std::string message;
+
     va_list argptr;
     va_start(argptr, format);
-    vfprintf(sout, format, argptr);
-    fflush(sout);
+    formatMessage(message, format, argptr);
     va_end(argptr);
+
+    AsyncLogger::get().write(t, message.data(), message.size());
+}
+
+LogField::LogField(const char *name, const std::string &value)
+    : m_prevLength(gs_threadFields.size())
+{
+    gs_threadFields += "[";
+    gs_threadFields += name;
+    gs_threadFields += "=";
+    gs_threadFields += value;
+    gs_threadFields += "] ";
+}
+
+LogField::~LogField()
+{
+    gs_threadFields.resize(m_prevLength);
 }
@@ -20,18 +20,76 @@
 #ifndef logging_h
 #define logging_h
 
+#include <stdint.h>
 #include <string>
 
 typedef enum {LOG_VERBOSE = 1, LOG_DEBUG = 2, LOG_INFO = 3, LOG_WARN = 4, 
     LOG_ERROR = 8, LOG_QUIET = 255} logtype_t;
 
-/** log something */
-void doLog(uint32_t t, const char *format, ...);
+/** lowest log level that is compiled in. Messages below
+    this level are removed by the compiler, including the 
+    evaluation of their arguments. */
+#ifndef PADRING_LOG_MIN_LEVEL
+#define PADRING_LOG_MIN_LEVEL LOG_VERBOSE
+#endif
+
+/** Messages are formatted by the calling thread and put in 
+    a lock-free buffer owned by that thread. A background 
+    thread writes them to stdout (stderr for errors) in the
+    order they were logged.
+*/
+
+/** write a message, without level filtering */
+void writeLog(uint32_t t, const char *format, ...);
+
+/** write a message, without level filtering */
+void writeLog(uint32_t t, const std::string &txt);
+
+/** get the current log level */
+uint32_t getLogLevel();
 
-/** log something */
-void doLog(uint32_t t, const std::string &txt);
+/** true if messages of a log level are shown. Use it to
+    skip work that only produces log messages. */
+inline bool isLogEnabled(uint32_t t)
+{
+    return (t >= PADRING_LOG_MIN_LEVEL) && (t >= getLogLevel());
+}
+
+/** log something, with a format and arguments or a string.
+    It is a macro so the level is checked before the
+    arguments are evaluated. */
+#define doLog(t, ...) \
+    do \
+    { \
+        if (isLogEnabled(t)) \
+        { \
+            writeLog((t), __VA_ARGS__); \
+        } \
+    } while(0)
 
 /** set the log level ... */
 void setLogLevel(uint32_t level);
 
+/** wait until all the messages logged so far have been
+    written. Call before writing to stdout directly. */
+void flushLog();
+
+/** A field added to every message the current thread logs
+    while the field exists, such as the configuration file
+    a batch worker is processing. Fields are written as
+    '[name=value]' in front of the message text.
+*/
+class LogField
+{
+public:
+    LogField(const char *name, const std::string &value);
+    virtual ~LogField();
+
+    LogField(const LogField &) = delete;
+    LogField& operator=(const LogField &) = delete;
+
+protected:
+    size_t m_prevLength;    ///< length of the thread's fields before this one
+};
+
 #endif
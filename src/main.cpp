@@ -31,16 +31,35 @@
 
 #include "cxxopts.h"
 #include "prlefreader.h"
-#include "configreader.h"
-#include "layout.h"
-#include "padringdb.h"
-#include "svgwriter.h"
-#include "defwriter.h"
-#include "verilogwriter.h"
-#include "csvwriter.h"
-#include "fillerhandler.h"
+#include "cellcollector.h"
 #include "debugutils.h"
-#include "gds2/gds2writer.h"
+#include "padringsession.h"
+#include "padringdaemon.h"
+#include "padringbatch.h"
+#include "stats.h"
+
+/** write the timers and counters if asked for on the command line */
+static void writeStats(const cxxopts::ParseResult &cmdresult)
+{
+    if (cmdresult.count("stats") > 0)
+    {
+        flushLog();
+        Stats::writeText(std::cout);
+        std::cout.flush();
+    }
+
+    if (cmdresult.count("stats-json") > 0)
+    {
+        std::string filename = cmdresult["stats-json"].as<std::string>();
+        std::ofstream os(filename, std::ofstream::out);
+        if (!os.is_open())
+        {
+            doLog(LOG_ERROR,"Cannot open statistics file %s for writing!\n", filename.c_str());
+            return;
+        }
+        Stats::writeJSON(os);
+    }
+}
 
 int main(int argc, char *argv[])
 {
@@ -63,6 +82,14 @@ int main(int argc, char *argv[])
         ("q,quiet", "produce no console output")
         ("v,verbose", "produce verbose output")
         ("filler", "set the filler cell prefix", cxxopts::value<std::vector<std::string>>())
+        ("j,jobs", "number of worker threads (default: one per core)", cxxopts::value<uint32_t>())
+        ("lefcache", "directory for precompiled LEF cell caches", cxxopts::value<std::string>())
+        ("full-lef", "parse all LEF macros, not only the ones used by the configuration")
+        ("daemon", "keep running and lay out configuration updates read from stdin")
+        ("socket", "keep running and lay out configuration updates read from a UNIX socket", cxxopts::value<std::string>())
+        ("batch", "lay out all the configurations listed in a manifest file", cxxopts::value<std::string>())
+        ("stats", "print the time spent in each phase and the counters at the end of the run")
+        ("stats-json", "write the time spent in each phase and the counters to a JSON file", cxxopts::value<std::string>())
         ("positional",
             "", cxxopts::value<std::vector<std::string>>());
 
@@ -70,8 +97,10 @@ int main(int argc, char *argv[])
 
     auto cmdresult = options.parse(argc, argv);
 
+    bool batch = (cmdresult.count("batch") > 0);
+
     if ((cmdresult.count("help")>0) || 
-        (cmdresult.count("positional")!=1))
+        ((cmdresult.count("positional")!=1) && (!batch)))
     {
         std::cout << options.help({"", "Group"}) << std::endl;
         exit(0);
@@ -95,415 +124,142 @@ int main(int argc, char *argv[])
 
     if (cmdresult.count("lef") < 1)
     {
+        flushLog();
         std::cout << "You must specify at least one LEF file containing the ASIC cells";
         exit(0);
     }
 
-    PadringDB padring;
-
-    double LEFDatabaseUnits = 0.0;
+    PRLEFReader lefreader;
 
-    // read the cells from the LEF files
-    // and save the most recent database units figure along the way..
-    auto &leffiles = cmdresult["lef"].as<std::vector<std::string> >();
-    for(auto leffile : leffiles)
+    uint32_t threads = 0;
+    if (cmdresult.count("jobs") > 0)
     {
-        std::ifstream lefstream(leffile, std::ifstream::in);
-        doLog(LOG_INFO, "Reading LEF %s\n", leffile.c_str());
-        padring.m_lefreader.parse(lefstream);
-        if (padring.m_lefreader.m_lefDatabaseUnits > 0.0)
-        {
-            LEFDatabaseUnits = padring.m_lefreader.m_lefDatabaseUnits;
-        }
+        threads = cmdresult["jobs"].as<uint32_t>();
     }
 
-    doLog(LOG_INFO,"%d cells read\n", padring.m_lefreader.m_cells.size());
+    bool daemon = (cmdresult.count("daemon") > 0) || (cmdresult.count("socket") > 0);
 
-    auto& v = cmdresult["positional"].as<std::vector<std::string> >();
-    std::string configFileName = v[0];
-
-    std::ifstream configStream(configFileName, std::ifstream::in);
-    if (!padring.parse(configStream))
+    PadringBatch padringBatch(lefreader);
+    std::vector<std::string> configFileNames;
+    if (batch)
     {
-        doLog(LOG_ERROR,"Cannot parse configuration file -- aborting\n");
-        exit(1);
-    }
-
-    // if an explicit filler cell prefix was not given,
-    // search the cell database for filler cells
-    FillerHandler fillerHandler;
-    fillerHandler.addFillers(&padring.m_lefreader, padring.m_fillers);
-
-    doLog(LOG_INFO, "Found %d filler cells\n", fillerHandler.getCellCount());
-
-    if (fillerHandler.getCellCount() == 0)
-    {
-        doLog(LOG_ERROR, "Cannot proceed without filler cells. Please use the --filler option to explicitly specify a filler cell prefix\n");
-        exit(1);
+        std::string manifestName = cmdresult["batch"].as<std::string>();
+        std::ifstream manifest(manifestName, std::ifstream::in);
+        if (!manifest.is_open())
+        {
+            doLog(LOG_ERROR,"Cannot open manifest file %s\n", manifestName.c_str());
+            exit(1);
+        }
+        if (!padringBatch.readManifest(manifest))
+        {
+            exit(1);
+        }
+        for(auto const &job : padringBatch.getJobs())
+        {
+            configFileNames.push_back(job.m_configFile);
+        }
     }
-
-    // check die size
-    if ((padring.m_dieWidth < 1.0e-6) || (padring.m_dieHeight < 1.0e-6))
+    else
     {
-        doLog(LOG_ERROR, "Die area was not specified! - aborting.\n");
-        exit(1);
+        configFileNames.push_back(cmdresult["positional"].as<std::vector<std::string> >()[0]);
     }
 
-    // generate report
-    doLog(LOG_INFO,"Die area        : %f x %f microns\n", padring.m_dieWidth, padring.m_dieHeight);
-    doLog(LOG_INFO,"Grid            : %f microns\n", padring.m_grid);
-    doLog(LOG_INFO,"Padring cells   : %d\n", padring.getPadCellCount());
-    doLog(LOG_INFO,"Smallest filler : %f microns\n", fillerHandler.getSmallestWidth());
-    
-    padring.doLayout();
-
-    // get corners
-    LayoutItem *topleft  = padring.m_north.getFirstCorner();
-    LayoutItem *topright = padring.m_north.getLastCorner();
-    LayoutItem *bottomleft  = padring.m_south.getFirstCorner();
-    LayoutItem *bottomright = padring.m_south.getLastCorner();
-
-    // write the padring to an SVG file
-    std::ofstream svgos;
-    if (cmdresult.count("svg") != 0)
+    // collect the cells used by the configurations first,
+    // so the LEF reader can skip all the other macros.
+    // the daemon needs all of them for later configurations.
+    if ((cmdresult.count("full-lef") == 0) && (!daemon))
     {
-        doLog(LOG_INFO,"Writing padring to SVG file: %s\n", cmdresult["svg"].as<std::string>().c_str());
-        svgos.open(cmdresult["svg"].as<std::string>(), std::ofstream::out);
-        if (!svgos.is_open())
+        CellCollector collector;
+        for(auto const &configFileName : configFileNames)
         {
-            doLog(LOG_ERROR, "Cannot open SVG file for writing!\n");
-            exit(1);
+            // a batch job that cannot be parsed fails on its own later
+            if ((!collector.parseFile(configFileName)) && (!batch))
+            {
+                doLog(LOG_ERROR,"Cannot parse configuration file -- aborting\n");
+                exit(1);
+            }
         }
+        lefreader.setMacroFilter(collector.m_cellNames);
     }
 
-    // write the padring to an DEF file
-    std::ofstream defos;
-    if (cmdresult.count("def") != 0)
+    if (cmdresult.count("lefcache") > 0)
     {
-        doLog(LOG_INFO,"Writing padring to DEF file: %s\n", cmdresult["def"].as<std::string>().c_str());
-        defos.open(cmdresult["def"].as<std::string>(), std::ofstream::out);
-        if (!defos.is_open())
-        {
-            doLog(LOG_ERROR, "Cannot open DEF file for writing!\n");
-            exit(1);
-        }
+        lefreader.setCacheDirectory(cmdresult["lefcache"].as<std::string>());
     }
 
-    // write the padring to an Verilog file
-    std::ofstream veros;
-    if (cmdresult.count("ver") != 0)
+    // read the cells from the LEF files in parallel.
+    // the reader keeps the most recent database units figure.
+    auto &leffiles = cmdresult["lef"].as<std::vector<std::string> >();
+    lefreader.parseFiles(leffiles, threads);
+
+    doLog(LOG_INFO,"%d cells read\n", lefreader.getCellCount());
+    if (lefreader.getSkippedMacroCount() > 0)
     {
-        doLog(LOG_INFO,"Writing padring to verilog file: %s\n", cmdresult["ver"].as<std::string>().c_str());
-        veros.open(cmdresult["ver"].as<std::string>(), std::ofstream::out);
-        if (!veros.is_open())
-        {
-            doLog(LOG_ERROR, "Cannot open verilog file for writing!\n");
-            exit(1);
-        }
+        doLog(LOG_INFO,"%d unused cells skipped\n", lefreader.getSkippedMacroCount());
     }
 
-    // write the padring to an Verilog file
-    std::ofstream csvos;
-    if (cmdresult.count("csv") != 0)
+    if (batch)
     {
-        doLog(LOG_INFO,"Writing padring to csv file: %s\n", cmdresult["csv"].as<std::string>().c_str());
-        csvos.open(cmdresult["csv"].as<std::string>(), std::ofstream::out);
-        if (!csvos.is_open())
-        {
-            doLog(LOG_ERROR, "Cannot open csv file for writing!\n");
-            exit(1);
-        }
+        // every configuration has its own padring database
+        // and outputs; the cell database is shared.
+        uint32_t failed = padringBatch.run(threads);
+        writeStats(cmdresult);
+        exit((failed == 0) ? 0 : 1);
     }
 
-    SVGWriter svg(svgos, padring.m_dieWidth, padring.m_dieHeight);
-    DEFWriter def(defos, padring.m_dieWidth, padring.m_dieHeight);
-    def.setDatabaseUnits(LEFDatabaseUnits);
-    def.setDesignName(padring.m_designName);
-    VerilogWriter ver(veros);
-    ver.setDesignName(padring.m_designName);
-    
-    CSVWriter csv(csvos);
-    csv.writePadring(&padring);
+    std::string configFileName = configFileNames.front();
 
-    // emit GDS2 and SVG
-    GDS2Writer *writer = nullptr;
-    
-    if (cmdresult.count("output")> 0)
+    outputFiles_t outputs;
+    if (cmdresult.count("svg") != 0) outputs.m_svg = cmdresult["svg"].as<std::string>();
+    if (cmdresult.count("def") != 0) outputs.m_def = cmdresult["def"].as<std::string>();
+    if (cmdresult.count("ver") != 0) outputs.m_verilog = cmdresult["ver"].as<std::string>();
+    if (cmdresult.count("csv") != 0) outputs.m_csv = cmdresult["csv"].as<std::string>();
+    if (cmdresult.count("output") != 0) outputs.m_gds2 = cmdresult["output"].as<std::string>();
+
+    PadringSession session(lefreader, threads);
+    session.setOutputs(outputs);
+    session.setIncremental(daemon);
+
+    if (!session.loadFile(configFileName))
     {
-        doLog(LOG_INFO,"Writing padring to GDS2 file: %s\n", cmdresult["output"].as<std::string>().c_str());
-        writer = GDS2Writer::open(cmdresult["output"].as<std::string>(),
-            padring.m_designName);
+        exit(1);
     }
-    
-    if (writer != nullptr) writer->writeCell(topleft);
-    if (writer != nullptr) writer->writeCell(topright);
-    if (writer != nullptr) writer->writeCell(bottomleft);
-    if (writer != nullptr) writer->writeCell(bottomright);
-
-    svg.writeCell(topleft);
-    svg.writeCell(topright);
-    svg.writeCell(bottomleft);
-    svg.writeCell(bottomright);
-
-    def.writeCell(topleft);
-    def.writeCell(topright);
-    def.writeCell(bottomleft);
-    def.writeCell(bottomright);
-
-    ver.writeCell(topleft);
-    ver.writeCell(topright);
-    ver.writeCell(bottomleft);
-    ver.writeCell(bottomright);
-    
-    int numfill = 0;
 
-    double north_y = padring.m_dieHeight;
-    for(auto item : padring.m_north)
+    if (!session.layout())
     {
-        if (item->m_ltype == LayoutItem::TYPE_CELL)
-        {
-            if (writer != nullptr) writer->writeCell(item);
-            svg.writeCell(item);
-            def.writeCell(item);
-            ver.writeCell(item);
-        }
-        else if (item->m_ltype == LayoutItem::TYPE_BOND)
-        {
-            if (writer != nullptr) writer->writeCell(item);
-            svg.writeCell(item);
-            def.writeCell(item);
-            ver.writeCell(item);
-        }
-        else if (item->m_ltype == LayoutItem::TYPE_FILLERDECL) {
-            // Re-load the fillers
-            fillerHandler.addFillers(&padring.m_lefreader, item->m_fillers);
-        }
-        else if ((item->m_ltype == LayoutItem::TYPE_FIXEDSPACE) || (item->m_ltype == LayoutItem::TYPE_FLEXSPACE))
-        {
-            // do fillers
-            double space = item->m_size;
-            double pos = item->m_x;
-            while(space > 0.0)
-            {
-                std::string cellName;
-                double width = fillerHandler.getFillerCell(space, cellName);
-                if (width > 0.0)
-                {
-                    LayoutItem filler(LayoutItem::TYPE_FILLER);
-                    filler.m_cellname = cellName;
-                    filler.m_instance = "FILLER_" + std::to_string(numfill);
-                    filler.m_x = pos;
-                    filler.m_y = north_y;
-                    filler.m_size = width;
-                    filler.m_location = "N";
-                    filler.m_lefinfo = padring.m_lefreader.getCellByName(cellName);
-                    if (writer != nullptr) writer->writeCell(&filler);
-                    svg.writeCell(&filler);
-                    def.writeCell(&filler);
-                    ver.writeCell(&filler);
-                    space -= width;
-                    if(space > 0.0 && space < padring.m_grid) {
-                      space = 0; // To avoid imprecision
-                    }
-                    pos += width;
-                    numfill++;
-                }
-                else
-                {
-                    doLog(LOG_ERROR, "(north) Cannot find filler cell that fits remaining width %g (%d)\n", space, item->m_ltype);
-                    exit(1);
-                }
-            }
-        }        
+        exit(1);
     }
 
-    double south_y = 0;
-    for(auto item : padring.m_south)
+    if (!session.write())
     {
-        if (item->m_ltype == LayoutItem::TYPE_CELL)
-        {
-            if (writer != nullptr) writer->writeCell(item);
-            svg.writeCell(item);  
-            def.writeCell(item);            
-            ver.writeCell(item);
-        }
-        else if (item->m_ltype == LayoutItem::TYPE_BOND)
-        {
-            if (writer != nullptr) writer->writeCell(item);
-            svg.writeCell(item);
-            def.writeCell(item);
-            ver.writeCell(item);
-        }
-        else if (item->m_ltype == LayoutItem::TYPE_FILLERDECL) {
-            // Re-load the fillers
-            fillerHandler.addFillers(&padring.m_lefreader, item->m_fillers);
-        }
-        else if ((item->m_ltype == LayoutItem::TYPE_FIXEDSPACE) || (item->m_ltype == LayoutItem::TYPE_FLEXSPACE))
-        {
-            // do fillers
-            double space = item->m_size;
-            double pos = item->m_x;
-            while(space > 0.0)
-            {
-                std::string cellName;
-                double width = fillerHandler.getFillerCell(space, cellName);
-                if (width > 0.0)
-                {
-                    LayoutItem filler(LayoutItem::TYPE_FILLER);
-                    filler.m_cellname = cellName;
-                    filler.m_instance = "FILLER_" + std::to_string(numfill);
-                    filler.m_x = pos;
-                    filler.m_y = south_y;
-                    filler.m_size = width;
-                    filler.m_location = "S";
-                    filler.m_lefinfo = padring.m_lefreader.getCellByName(cellName);
-                    if (writer != nullptr) writer->writeCell(&filler);
-                    svg.writeCell(&filler);
-                    def.writeCell(&filler);
-                    ver.writeCell(&filler);
-                    space -= width;
-                    if(space > 0.0 && space < padring.m_grid) {
-                      space = 0; // To avoid imprecision
-                    }
-                    pos += width;
-                    numfill++;
-                }
-                else
-                {
-                    doLog(LOG_ERROR, "(south) Cannot find filler cell that fits remaining width %g (%d)\n", space, item->m_ltype);
-                    exit(1);
-                }
-            }
-        }        
+        exit(1);
     }
 
-    double west_x = 0;
-    for(auto item : padring.m_west)
+    if (daemon)
     {
-        if (item->m_ltype == LayoutItem::TYPE_CELL)
-        {
-            if (writer != nullptr) writer->writeCell(item);
-            svg.writeCell(item);
-            def.writeCell(item);
-            ver.writeCell(item);
-        }
-        else if (item->m_ltype == LayoutItem::TYPE_BOND)
-        {
-            if (writer != nullptr) writer->writeCell(item);
-            svg.writeCell(item);
-            def.writeCell(item);
-            ver.writeCell(item);
-        }
-        else if (item->m_ltype == LayoutItem::TYPE_FILLERDECL) {
-            // Re-load the fillers
-            fillerHandler.addFillers(&padring.m_lefreader, item->m_fillers);
-        }
-        else if ((item->m_ltype == LayoutItem::TYPE_FIXEDSPACE) || (item->m_ltype == LayoutItem::TYPE_FLEXSPACE))
+        // keep the LEF database and the layout, and
+        // lay out updated configurations.
+        PadringDaemon server(session, configFileName);
+        if (cmdresult.count("socket") > 0)
         {
-            // do fillers
-            double space = item->m_size;
-            double pos = item->m_y;
-            while(space > 0.0)
+            if (!server.serveSocket(cmdresult["socket"].as<std::string>()))
             {
-                std::string cellName;
-                double width = fillerHandler.getFillerCell(space, cellName);
-                if (width > 0.0)
-                {
-                    LayoutItem filler(LayoutItem::TYPE_FILLER);
-                    filler.m_cellname = cellName;
-                    filler.m_instance = "FILLER_" + std::to_string(numfill);
-                    filler.m_x = west_x;
-                    filler.m_y = pos;
-                    filler.m_size = width;
-                    filler.m_location = "W";
-                    filler.m_lefinfo = padring.m_lefreader.getCellByName(cellName);
-                    if (writer != nullptr) writer->writeCell(&filler);
-                    svg.writeCell(&filler);
-                    def.writeCell(&filler);
-                    ver.writeCell(&filler);
-                    space -= width;
-                    if(space > 0.0 && space < padring.m_grid) {
-                      space = 0; // To avoid imprecision
-                    }
-                    pos += width;
-                    numfill++;
-                }
-                else
-                {
-                    doLog(LOG_ERROR, "(east) Cannot find filler cell that fits remaining width %g (%d)\n", space, item->m_ltype);
-                    exit(1);
-                }
+                exit(1);
             }
-        }        
-    }
-
-    double east_x = padring.m_dieWidth;
-    for(auto item : padring.m_east)
-    {
-        if (item->m_ltype == LayoutItem::TYPE_CELL)
-        {
-            if (writer != nullptr) writer->writeCell(item);
-            svg.writeCell(item);
-            def.writeCell(item);
-            ver.writeCell(item);
         }
-        else if (item->m_ltype == LayoutItem::TYPE_BOND)
+        else
         {
-            if (writer != nullptr) writer->writeCell(item);
-            svg.writeCell(item);
-            def.writeCell(item);
-            ver.writeCell(item);
-        }
-        else if (item->m_ltype == LayoutItem::TYPE_FILLERDECL) {
-            // Re-load the fillers
-            fillerHandler.addFillers(&padring.m_lefreader, item->m_fillers);
+            server.serve(std::cin, std::cout);
         }
-        else if ((item->m_ltype == LayoutItem::TYPE_FIXEDSPACE) || (item->m_ltype == LayoutItem::TYPE_FLEXSPACE))
-        {
-            // do fillers
-            double space = item->m_size;
-            double pos = item->m_y;
-            while(space > 0.0)
-            {
-                std::string cellName;
-                double width = fillerHandler.getFillerCell(space, cellName);
-                if (width > 0.0)
-                {
-                    LayoutItem filler(LayoutItem::TYPE_FILLER);
-                    filler.m_cellname = cellName;
-                    filler.m_instance = "FILLER_" + std::to_string(numfill);
-                    filler.m_x = east_x;
-                    filler.m_y = pos;
-                    filler.m_size = width;
-                    filler.m_location = "E";
-                    filler.m_lefinfo = padring.m_lefreader.getCellByName(cellName);
-                    if (writer != nullptr) writer->writeCell(&filler);
-                    svg.writeCell(&filler);
-                    def.writeCell(&filler);
-                    ver.writeCell(&filler);
-                    space -= width;
-                    if(space > 0.0 && space < padring.m_grid) {
-                      space = 0; // To avoid imprecision
-                    }
-                    pos += width;
-                    numfill++;
-                }
-                else
-                {
-                    doLog(LOG_ERROR, "(west) Cannot find filler cell that fits remaining width %g (%d)\n", space, item->m_ltype);
-                    exit(1);
-                }
-            }
-        }        
+        writeStats(cmdresult);
+        return 0;
     }
 
-    if (writer != nullptr) delete writer;
-
-    for(auto cell : padring.m_lefreader.m_cells)
+    for(auto cell : lefreader.m_cells)
     {
         DebugUtils::dumpToConsole(cell.second);
     }
 
+    writeStats(cmdresult);
     return 0;
 }
-
@@ -0,0 +1,110 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <fstream>
+#include "mappedfile.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+    if (m_mapped)
+    {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_data   = nullptr;
+    m_size   = 0;
+    m_mapped = false;
+}
+
+bool MappedFile::open(const std::string &filename)
+{
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // mmap cannot map empty files,
+    // so leave the view empty.
+    if (st.st_size == 0)
+    {
+        ::close(fd);
+        return true;
+    }
+
+    void *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (ptr != MAP_FAILED)
+    {
+        // the tokenizers walk the file front to back.
+        madvise(ptr, st.st_size, MADV_SEQUENTIAL);
+        m_data   = static_cast<const char*>(ptr);
+        m_size   = st.st_size;
+        m_mapped = true;
+        return true;
+    }
+#endif
+
+    // no mmap support: read the whole file instead.
+    std::ifstream is(filename, std::ifstream::in | std::ifstream::binary);
+    if (!is.good())
+    {
+        return false;
+    }
+
+    is.seekg(0, std::ios::end);
+    std::streamoff len = is.tellg();
+    is.seekg(0, std::ios::beg);
+    if (len < 0)
+    {
+        return false;
+    }
+
+    m_buffer.resize(static_cast<size_t>(len));
+    is.read(m_buffer.data(), len);
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+}
@@ -0,0 +1,67 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef mappedfile_h
+#define mappedfile_h
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/** read-only view of a file's contents.
+
+    On POSIX systems the file is memory-mapped, so the
+    readers can scan it without copying. On other systems
+    the contents are read into a buffer instead.
+*/
+class MappedFile
+{
+public:
+    MappedFile() : m_data(nullptr), m_size(0), m_mapped(false) {}
+    virtual ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+
+    /** map a file. returns false if the file cannot be opened. */
+    bool open(const std::string &filename);
+
+    /** unmap the file, if one is mapped. */
+    void close();
+
+    /** pointer to the first byte of the file */
+    const char* data() const
+    {
+        return m_data;
+    }
+
+    /** size of the file in bytes */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+protected:
+    const char          *m_data;    ///< start of file contents
+    size_t              m_size;     ///< size of file contents in bytes
+    bool                m_mapped;   ///< true if m_data points to a mapping
+    std::vector<char>   m_buffer;   ///< fallback storage when mmap is not available
+};
+
+#endif
@@ -0,0 +1,80 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef outputsink_h
+#define outputsink_h
+
+#include <stdint.h>
+#include <string>
+#include <fstream>
+#include <memory>
+#include <functional>
+
+#include "placement.h"
+
+/** An output of the padring generator, such as a GDS2 or
+    DEF file. Only the outputs requested by the user are
+    created; the placed cells are handed to each of them in
+    writing order, in batches of PlacedCell records.
+*/
+class OutputSink
+{
+public:
+    virtual ~OutputSink() {}
+
+    typedef std::function<void(const PlacedCell &cell)> cellVisitor_t;
+
+    /** calls the visitor for every placed cell, in writing order */
+    typedef std::function<void(const cellVisitor_t &visitor)> cellSource_t;
+
+    /** called before the first cell with the number of cells
+        that will be written and the database units per micron
+        of the cell coordinates */
+    virtual void onBegin(uint32_t cellCount, double databaseUnits) {}
+
+    /** called for each batch of placed cells */
+    virtual void onCells(const PlacedCell *cells, size_t count) {}
+
+    /** called after the last cell. Outputs that need to see the
+        cells more than once can walk them again with 'cells'. */
+    virtual void onFinish(const cellSource_t &cells) {}
+
+    /** called when the run is aborted before onFinish.
+        The output should write what it has so far. */
+    virtual void onAbort() {}
+
+protected:
+    /** open a file for writing.
+        returns nullptr if the file cannot be opened. */
+    static std::unique_ptr<std::ofstream> openFile(const std::string &filename)
+    {
+        std::unique_ptr<std::ofstream> os(new std::ofstream(filename, std::ofstream::out));
+        if (!os->is_open())
+        {
+            return nullptr;
+        }
+        return os;
+    }
+
+    /** stream owned by the output, closed after the
+        derived class has finished writing. */
+    std::unique_ptr<std::ostream> m_ownedStream;
+};
+
+#endif
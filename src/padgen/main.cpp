@@ -0,0 +1,117 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+/*
+    PADGEN -- generates synthetic pad libraries and padring
+    configurations for scale testing.
+
+    The same seed and parameters always produce the same 
+    files, on every platform.
+*/
+
+#include <iostream>
+#include <fstream>
+
+#include "../logging.h"
+#include "cxxopts.h"
+#include "padgenerator.h"
+
+int main(int argc, char *argv[])
+{
+    setLogLevel(LOG_INFO);
+
+    cxxopts::Options options("padgen","PADGEN - generates a synthetic LEF library and padring configuration");
+
+    padgenParams_t params;
+
+    options.add_options()
+        ("h,help", "Print help")
+        ("lef", "LEF output file", cxxopts::value<std::string>())
+        ("config", "padring configuration output file", cxxopts::value<std::string>())
+        ("q,quiet", "produce no console output")
+        ("seed", "random seed", cxxopts::value<uint64_t>())
+        ("macros", "number of pad macros", cxxopts::value<uint32_t>())
+        ("pins", "pins per pad macro", cxxopts::value<uint32_t>())
+        ("rects", "port rectangles per pin", cxxopts::value<uint32_t>())
+        ("obs", "obstruction rectangles per pad macro", cxxopts::value<uint32_t>())
+        ("pads", "pads per edge", cxxopts::value<uint32_t>())
+        ("space-ratio", "fraction of the pads followed by a SPACE", cxxopts::value<double>())
+        ("bond-ratio", "fraction of the pads with a BOND", cxxopts::value<double>())
+        ("flip-ratio", "fraction of the pads that are flipped", cxxopts::value<double>())
+        ("filler-switches", "FILLER statements per edge", cxxopts::value<uint32_t>())
+        ("slack", "die length left for fillers, relative to the pads", cxxopts::value<double>());
+
+    auto cmdresult = options.parse(argc, argv);
+
+    if ((cmdresult.count("help") > 0) || 
+        ((cmdresult.count("lef") == 0) && (cmdresult.count("config") == 0)))
+    {
+        std::cout << options.help({""}) << std::endl;
+        exit(0);
+    }
+
+    if (cmdresult.count("quiet") > 0)
+    {
+        setLogLevel(LOG_QUIET);
+    }
+
+    if (cmdresult.count("seed") > 0) params.m_seed = cmdresult["seed"].as<uint64_t>();
+    if (cmdresult.count("macros") > 0) params.m_macros = cmdresult["macros"].as<uint32_t>();
+    if (cmdresult.count("pins") > 0) params.m_pins = cmdresult["pins"].as<uint32_t>();
+    if (cmdresult.count("rects") > 0) params.m_rectsPerPin = cmdresult["rects"].as<uint32_t>();
+    if (cmdresult.count("obs") > 0) params.m_obsRects = cmdresult["obs"].as<uint32_t>();
+    if (cmdresult.count("pads") > 0) params.m_padsPerEdge = cmdresult["pads"].as<uint32_t>();
+    if (cmdresult.count("space-ratio") > 0) params.m_spaceRatio = cmdresult["space-ratio"].as<double>();
+    if (cmdresult.count("bond-ratio") > 0) params.m_bondRatio = cmdresult["bond-ratio"].as<double>();
+    if (cmdresult.count("flip-ratio") > 0) params.m_flipRatio = cmdresult["flip-ratio"].as<double>();
+    if (cmdresult.count("filler-switches") > 0) params.m_fillerSwitches = cmdresult["filler-switches"].as<uint32_t>();
+    if (cmdresult.count("slack") > 0) params.m_slack = cmdresult["slack"].as<double>();
+
+    PadGenerator generator(params);
+
+    if (cmdresult.count("lef") > 0)
+    {
+        std::string filename = cmdresult["lef"].as<std::string>();
+        std::ofstream os(filename, std::ofstream::out);
+        if (!os.is_open())
+        {
+            doLog(LOG_ERROR,"Cannot open LEF file %s for writing!\n", filename.c_str());
+            exit(1);
+        }
+        generator.writeLEF(os);
+        doLog(LOG_INFO,"Wrote %d pad macros to %s\n", params.m_macros, filename.c_str());
+    }
+
+    if (cmdresult.count("config") > 0)
+    {
+        std::string filename = cmdresult["config"].as<std::string>();
+        std::ofstream os(filename, std::ofstream::out);
+        if (!os.is_open())
+        {
+            doLog(LOG_ERROR,"Cannot open configuration file %s for writing!\n", filename.c_str());
+            exit(1);
+        }
+        generator.writeConfig(os);
+        doLog(LOG_INFO,"Wrote %llu instances on a %u x %u micron die to %s\n", 
+            static_cast<unsigned long long>(generator.getInstanceCount()),
+            generator.getDieWidth(), generator.getDieHeight(), filename.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,328 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <algorithm>
+#include "padgenerator.h"
+
+/** pad and corner height in microns */
+static const uint32_t gs_padHeight = 150;
+
+/** bond pad size in microns */
+static const uint32_t gs_bondSize = 60;
+
+/** filler widths in microns, for both filler groups */
+static const uint32_t gs_fillerWidths[] = {1, 2, 5, 10, 20, 50};
+
+/** names of the filler groups */
+static const char *gs_fillerGroups[2] = {"FILLA", "FILLB"};
+
+static const char *gs_edgeNames[4] = {"N", "S", "E", "W"};
+
+static const char *gs_pinDirections[3] = {"INPUT", "OUTPUT", "INOUT"};
+
+/** SplitMix64 random numbers: the same on every platform */
+class PadgenRandom
+{
+public:
+    explicit PadgenRandom(uint64_t seed) : m_state(seed) {}
+
+    uint64_t next()
+    {
+        uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /** number in [lo, hi] */
+    uint32_t range(uint32_t lo, uint32_t hi)
+    {
+        return lo + static_cast<uint32_t>(next() % (static_cast<uint64_t>(hi - lo) + 1));
+    }
+
+    /** true with the given probability */
+    bool chance(double probability)
+    {
+        return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0) < probability;
+    }
+
+protected:
+    uint64_t m_state;
+};
+
+/** write a coordinate in nanometers as microns */
+static void writeMicrons(std::ostream &os, uint64_t nm)
+{
+    static const char digits[] = "0123456789";
+    uint64_t frac = nm % 1000;
+    os << (nm / 1000) << '.' << digits[frac / 100] << digits[(frac / 10) % 10] << digits[frac % 10];
+}
+
+/** write a RECT statement, coordinates in nanometers */
+static void writeRect(std::ostream &os, const char *indent, uint64_t x1, uint64_t y1, uint64_t x2, uint64_t y2)
+{
+    os << indent << "RECT ";
+    writeMicrons(os, x1);
+    os << ' ';
+    writeMicrons(os, y1);
+    os << ' ';
+    writeMicrons(os, x2);
+    os << ' ';
+    writeMicrons(os, y2);
+    os << " ;\n";
+}
+
+/** a random rectangle inside a cell, in nanometers */
+static void writeRandomRect(std::ostream &os, const char *indent, PadgenRandom &rnd, uint32_t width, uint32_t height)
+{
+    uint64_t w  = static_cast<uint64_t>(width) * 1000;
+    uint64_t h  = static_cast<uint64_t>(height) * 1000;
+    uint64_t x1 = rnd.next() % (w - 500);
+    uint64_t y1 = rnd.next() % (h - 500);
+    uint64_t x2 = x1 + 500 + rnd.next() % std::min<uint64_t>(w - x1 - 499, 10000);
+    uint64_t y2 = y1 + 500 + rnd.next() % std::min<uint64_t>(h - y1 - 499, 10000);
+    writeRect(os, indent, x1, y1, x2, y2);
+}
+
+PadGenerator::PadGenerator(const padgenParams_t &params) 
+    : m_params(params), m_dieWidth(0), m_dieHeight(0), m_instances(4)
+{
+    m_params.m_macros = std::max<uint32_t>(m_params.m_macros, 1);
+
+    PadgenRandom rnd(m_params.m_seed);
+
+    // the library: every eighth macro is a power pad
+    for(uint32_t i=0; i<m_params.m_macros; i++)
+    {
+        macro_t macro;
+        macro.m_power = ((i % 8) == 7);
+        macro.m_name  = (macro.m_power ? "PWRPAD_" : "IOPAD_") + std::to_string(i);
+        macro.m_width = rnd.range(40, 100);
+        m_library.push_back(macro);
+    }
+
+    // the edges, with the length each of them needs
+    uint64_t lengths[4];
+    for(uint32_t edge=0; edge<4; edge++)
+    {
+        std::vector<statement_t> &statements = m_edges[edge];
+        uint64_t length = 0;
+        uint32_t switchEvery = m_params.m_padsPerEdge / (m_params.m_fillerSwitches + 1);
+        uint32_t group = 0;
+        for(uint32_t pad=0; pad<m_params.m_padsPerEdge; pad++)
+        {
+            if ((m_params.m_fillerSwitches > 0) && (pad > 0) && (switchEvery > 0) && 
+                ((pad % switchEvery) == 0) && (group < m_params.m_fillerSwitches))
+            {
+                group++;
+                statements.push_back({statement_t::FILLER, group & 1, 0, false});
+            }
+
+            uint32_t macro = rnd.range(0, m_params.m_macros - 1);
+            statements.push_back({statement_t::PAD, pad, macro, rnd.chance(m_params.m_flipRatio)});
+            length += m_library[macro].m_width;
+            m_instances++;
+
+            if (rnd.chance(m_params.m_bondRatio))
+            {
+                uint32_t offset = rnd.range(0, m_library[macro].m_width / 2);
+                statements.push_back({statement_t::BOND, pad, offset, rnd.chance(0.5)});
+                m_instances++;
+            }
+
+            if (rnd.chance(m_params.m_spaceRatio))
+            {
+                uint32_t space = rnd.range(0, 20);
+                statements.push_back({statement_t::SPACE, pad, space, false});
+                length += space;
+            }
+        }
+        lengths[edge] = length + 2*gs_padHeight + 
+            static_cast<uint64_t>(static_cast<double>(length) * std::max(m_params.m_slack, 0.0));
+    }
+
+    m_dieWidth  = static_cast<uint32_t>(std::max(lengths[0], lengths[1]));
+    m_dieHeight = static_cast<uint32_t>(std::max(lengths[2], lengths[3]));
+}
+
+void PadGenerator::writeMacro(std::ostream &os, size_t index) const
+{
+    const macro_t &macro = m_library[index];
+
+    // each macro has its own random numbers, so the
+    // geometry does not depend on the other parameters.
+    PadgenRandom rnd(m_params.m_seed ^ (0xA5A5A5A5ULL * (index + 1)));
+
+    os << "MACRO " << macro.m_name << "\n";
+    os << "    CLASS PAD " << (macro.m_power ? "POWER" : "INOUT") << " ;\n";
+    os << "    FOREIGN " << macro.m_name << " 0 0 ;\n";
+    os << "    ORIGIN 0.000 0.000 ;\n";
+    os << "    SIZE " << macro.m_width << ".000 BY " << gs_padHeight << ".000 ;\n";
+    os << "    SYMMETRY R90 ;\n";
+    os << "    SITE io_site ;\n";
+
+    for(uint32_t pin=0; pin<m_params.m_pins; pin++)
+    {
+        std::string pinName = (pin == 0) ? std::string("PAD") : ("P" + std::to_string(pin));
+        os << "    PIN " << pinName << "\n";
+        if (macro.m_power)
+        {
+            os << "        DIRECTION INOUT ;\n";
+            os << "        USE " << (((pin & 1) == 0) ? "POWER" : "GROUND") << " ;\n";
+        }
+        else
+        {
+            os << "        DIRECTION " << gs_pinDirections[(pin == 0) ? 2 : rnd.range(0, 2)] << " ;\n";
+            os << "        USE SIGNAL ;\n";
+        }
+        os << "        PORT\n";
+        os << "        LAYER MET" << (1 + (pin % 2)) << " ;\n";
+        for(uint32_t r=0; r<m_params.m_rectsPerPin; r++)
+        {
+            writeRandomRect(os, "            ", rnd, macro.m_width, gs_padHeight);
+        }
+        os << "        END\n";
+        os << "    END " << pinName << "\n";
+    }
+
+    if (m_params.m_obsRects > 0)
+    {
+        os << "    OBS\n";
+        os << "        LAYER MET1 ;\n";
+        for(uint32_t r=0; r<m_params.m_obsRects; r++)
+        {
+            writeRandomRect(os, "        ", rnd, macro.m_width, gs_padHeight);
+        }
+        os << "    END\n";
+    }
+
+    os << "END " << macro.m_name << "\n\n";
+}
+
+void PadGenerator::writeLEF(std::ostream &os) const
+{
+    os << "# synthetic pad library, seed " << m_params.m_seed << "\n\n";
+    os << "VERSION 5.7 ;\n";
+    os << "BUSBITCHARS \"[]\" ;\n";
+    os << "DIVIDERCHAR \"/\" ;\n\n";
+    os << "UNITS\n    DATABASE MICRONS 1000 ;\nEND UNITS\n\n";
+    os << "MANUFACTURINGGRID 0.001 ;\n\n";
+    os << "SITE io_site\n    SYMMETRY Y ;\n    CLASS PAD ;\n    SIZE 1.000 BY " << gs_padHeight << ".000 ;\nEND io_site\n\n";
+
+    for(size_t i=0; i<m_library.size(); i++)
+    {
+        writeMacro(os, i);
+    }
+
+    os << "MACRO CORNER\n";
+    os << "    CLASS PAD ;\n";
+    os << "    FOREIGN CORNER 0 0 ;\n";
+    os << "    ORIGIN 0.000 0.000 ;\n";
+    os << "    SIZE " << gs_padHeight << ".000 BY " << gs_padHeight << ".000 ;\n";
+    os << "    SYMMETRY R90 ;\n";
+    os << "END CORNER\n\n";
+
+    os << "MACRO BONDPAD\n";
+    os << "    CLASS COVER BUMP ;\n";
+    os << "    FOREIGN BONDPAD 0 0 ;\n";
+    os << "    ORIGIN 0.000 0.000 ;\n";
+    os << "    SIZE " << gs_bondSize << ".000 BY " << gs_bondSize << ".000 ;\n";
+    os << "    SYMMETRY R90 ;\n";
+    os << "    PIN PAD\n";
+    os << "        DIRECTION INOUT ;\n";
+    os << "        PORT\n";
+    os << "        LAYER MET2 ;\n";
+    writeRect(os, "            ", 5000, 5000, (gs_bondSize-5)*1000, (gs_bondSize-5)*1000);
+    os << "        END\n";
+    os << "    END PAD\n";
+    os << "END BONDPAD\n\n";
+
+    for(auto group : gs_fillerGroups)
+    {
+        for(auto width : gs_fillerWidths)
+        {
+            os << "MACRO " << group << width << "\n";
+            os << "    CLASS PAD SPACER ;\n";
+            os << "    FOREIGN " << group << width << " 0 0 ;\n";
+            os << "    ORIGIN 0.000 0.000 ;\n";
+            os << "    SIZE " << width << ".000 BY " << gs_padHeight << ".000 ;\n";
+            os << "    SYMMETRY R90 ;\n";
+            os << "    SITE io_site ;\n";
+            os << "END " << group << width << "\n\n";
+        }
+    }
+
+    os << "END LIBRARY\n";
+}
+
+void PadGenerator::writeConfig(std::ostream &os) const
+{
+    os << "# synthetic padring, seed " << m_params.m_seed << "\n\n";
+    os << "DESIGN padgen_" << m_params.m_seed << " ;\n";
+    os << "AREA " << m_dieWidth << " " << m_dieHeight << " ;\n";
+    os << "GRID 1 ;\n\n";
+
+    os << "CORNER CORNER_NE NE CORNER ;\n";
+    os << "CORNER CORNER_NW NW CORNER ;\n";
+    os << "CORNER CORNER_SE SE CORNER ;\n";
+    os << "CORNER CORNER_SW SW CORNER ;\n";
+
+    for(uint32_t edge=0; edge<4; edge++)
+    {
+        const char *name = gs_edgeNames[edge];
+        os << "\nLOC " << name << " ;\n";
+
+        // start every edge with the first filler group
+        if (m_params.m_fillerSwitches > 0)
+        {
+            os << "FILLER";
+            for(auto width : gs_fillerWidths)
+            {
+                os << " " << gs_fillerGroups[0] << width;
+            }
+            os << " ;\n";
+        }
+
+        for(auto const &statement : m_edges[edge])
+        {
+            switch(statement.m_type)
+            {
+            case statement_t::PAD:
+                os << "PAD P_" << name << "_" << statement.m_index << " " << name 
+                   << (statement.m_flipped ? " FLIP " : " ") << m_library[statement.m_value].m_name << " ;\n";
+                break;
+            case statement_t::BOND:
+                os << "BOND B_" << name << "_" << statement.m_index 
+                   << (statement.m_flipped ? " FLIP" : "") << " BONDPAD " << statement.m_value << " ;\n";
+                break;
+            case statement_t::SPACE:
+                os << "SPACE " << statement.m_value << " ;\n";
+                break;
+            case statement_t::FILLER:
+                os << "FILLER";
+                for(auto width : gs_fillerWidths)
+                {
+                    os << " " << gs_fillerGroups[statement.m_index] << width;
+                }
+                os << " ;\n";
+                break;
+            }
+        }
+    }
+}
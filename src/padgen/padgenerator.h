@@ -0,0 +1,109 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef padgenerator_h
+#define padgenerator_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <ostream>
+
+/** parameters of a synthetic padring workload */
+struct padgenParams_t
+{
+    padgenParams_t() : m_seed(1), 
+        m_macros(16), m_pins(8), m_rectsPerPin(2), m_obsRects(4),
+        m_padsPerEdge(100), m_spaceRatio(0.1), m_bondRatio(0.1),
+        m_flipRatio(0.25), m_fillerSwitches(0), m_slack(0.25) {}
+
+    uint64_t    m_seed;             ///< all output follows from the seed
+    uint32_t    m_macros;           ///< number of pad macros in the LEF
+    uint32_t    m_pins;             ///< pins per pad macro
+    uint32_t    m_rectsPerPin;      ///< port rectangles per pin
+    uint32_t    m_obsRects;         ///< obstruction rectangles per macro
+    uint32_t    m_padsPerEdge;      ///< pads on each edge of the configuration
+    double      m_spaceRatio;       ///< fraction of the pads followed by a SPACE
+    double      m_bondRatio;        ///< fraction of the pads with a BOND
+    double      m_flipRatio;        ///< fraction of the pads that are flipped
+    uint32_t    m_fillerSwitches;   ///< FILLER statements per edge
+    double      m_slack;            ///< die length left for fillers, relative to the pads
+};
+
+/** Generates a LEF library of pad, corner, bond and filler
+    cells and a padring configuration that uses it.
+
+    The output only depends on the parameters: the random
+    numbers come from a generator of our own, not from the
+    standard library distributions, whose results differ
+    between implementations. Sizes are whole microns, so
+    the spaces can always be filled.
+*/
+class PadGenerator
+{
+public:
+    explicit PadGenerator(const padgenParams_t &params);
+
+    /** write the LEF library */
+    void writeLEF(std::ostream &os) const;
+
+    /** write the padring configuration */
+    void writeConfig(std::ostream &os) const;
+
+    /** number of cell instances in the configuration,
+        without the fillers padring adds. */
+    uint64_t getInstanceCount() const
+    {
+        return m_instances;
+    }
+
+    /** die size in microns */
+    uint32_t getDieWidth() const { return m_dieWidth; }
+    uint32_t getDieHeight() const { return m_dieHeight; }
+
+protected:
+    /** a generated pad macro */
+    struct macro_t
+    {
+        std::string m_name;
+        uint32_t    m_width;    ///< in microns
+        bool        m_power;    ///< power pad
+    };
+
+    /** a statement on an edge of the configuration */
+    struct statement_t
+    {
+        enum type_t { PAD, BOND, SPACE, FILLER } m_type;
+        uint32_t    m_index;    ///< pad number, macro or filler group
+        uint32_t    m_value;    ///< macro index, space in microns or bond offset
+        bool        m_flipped;
+    };
+
+    /** write one pad macro with its pins and obstructions */
+    void writeMacro(std::ostream &os, size_t index) const;
+
+    padgenParams_t          m_params;
+    std::vector<macro_t>    m_library;
+    std::vector<statement_t> m_edges[4];   ///< N, S, E, W
+    uint32_t                m_dieWidth;
+    uint32_t                m_dieHeight;
+    uint64_t                m_instances;
+};
+
+#endif
@@ -0,0 +1,107 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <sstream>
+#include "logging.h"
+#include "padringsession.h"
+#include "padringapi.h"
+
+PadringContext::PadringContext() 
+    : m_ownedReader(new PRLEFReader()),
+      m_lefreader(*m_ownedReader),
+      m_threads(1)
+{
+}
+
+PadringContext::PadringContext(PRLEFReader &lefreader) 
+    : m_lefreader(lefreader),
+      m_threads(1)
+{
+}
+
+PadringContext::~PadringContext()
+{
+}
+
+void PadringContext::addLEF(const char *data, size_t len)
+{
+    m_lefreader.parse(data, len);
+}
+
+bool PadringContext::layout(const char *config, size_t len, uint32_t outputs, padringResult_t &result)
+{
+    result = padringResult_t();
+
+    std::ostringstream svg;
+    std::ostringstream def;
+    std::ostringstream verilog;
+    std::ostringstream csv;
+    std::ostringstream gds2(std::ios::out | std::ios::binary);
+
+    outputStreams_t streams;
+    if (outputs & OUTPUT_SVG)       streams.m_svg = &svg;
+    if (outputs & OUTPUT_DEF)       streams.m_def = &def;
+    if (outputs & OUTPUT_VERILOG)   streams.m_verilog = &verilog;
+    if (outputs & OUTPUT_CSV)       streams.m_csv = &csv;
+    if (outputs & OUTPUT_GDS2)      streams.m_gds2 = &gds2;
+
+    PadringSession session(m_lefreader, m_threads);
+    session.setOutputStreams(streams);
+
+    if (!session.load(config, len))
+    {
+        return false;
+    }
+
+    PadringDB *padring = session.getPadring();
+    result.m_designName = padring->m_designName;
+    result.m_dieWidth   = padring->m_dieWidth;
+    result.m_dieHeight  = padring->m_dieHeight;
+
+    bool complete = session.layout();
+
+    // the cells are converted to microns with the
+    // database units of the layout.
+    double databaseUnits = padring->getDatabaseUnits();
+    session.visitPlacedCells([&](const PlacedCell &cell)
+    {
+        padringCell_t placed;
+        placed.m_instance = std::string(cell.getInstanceName());
+        placed.m_cellname = std::string(cell.getCellName());
+        placed.m_ltype    = cell.m_ltype;
+        placed.m_orient   = cell.m_orient;
+        placed.m_x        = toMicrons(cell.m_x, databaseUnits);
+        placed.m_y        = toMicrons(cell.m_y, databaseUnits);
+        placed.m_width    = toMicrons(cell.m_width, databaseUnits);
+        placed.m_height   = toMicrons(cell.m_height, databaseUnits);
+        result.m_cells.push_back(placed);
+    });
+
+    if ((!complete) || (!session.write()))
+    {
+        return false;
+    }
+
+    result.m_svg     = svg.str();
+    result.m_def     = def.str();
+    result.m_verilog = verilog.str();
+    result.m_csv     = csv.str();
+    result.m_gds2    = gds2.str();
+    return true;
+}
@@ -0,0 +1,137 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef padringapi_h
+#define padringapi_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "prlefreader.h"
+#include "layout.h"
+#include "placement.h"
+
+/** outputs to produce, combined into a mask */
+enum outputMask_t
+{
+    OUTPUT_SVG      = 1,
+    OUTPUT_DEF      = 2,
+    OUTPUT_VERILOG  = 4,
+    OUTPUT_CSV      = 8,
+    OUTPUT_GDS2     = 16
+};
+
+/** a placed cell that does not refer to the LEF database */
+struct padringCell_t
+{
+    std::string m_instance;     ///< instance name, empty for fillers
+    std::string m_cellname;     ///< cell name
+    LayoutItem::LayoutItemType m_ltype; ///< type of the layout item
+    orient_t    m_orient;       ///< orientation of the cell
+    double      m_x;            ///< x-position of the lower-left corner in microns
+    double      m_y;            ///< y-position of the lower-left corner in microns
+    double      m_width;        ///< width of the unrotated cell in microns
+    double      m_height;       ///< height of the unrotated cell in microns
+};
+
+/** the placement and the outputs of a configuration */
+struct padringResult_t
+{
+    std::string m_designName;
+    double      m_dieWidth;     ///< die width in microns
+    double      m_dieHeight;    ///< die height in microns
+
+    /** placed cells in writing order */
+    std::vector<padringCell_t>  m_cells;
+
+    // the outputs asked for, empty otherwise
+    std::string m_svg;
+    std::string m_def;
+    std::string m_verilog;
+    std::string m_csv;
+    std::string m_gds2;
+};
+
+/** Lays out padring configurations held in memory and
+    returns the placements and the outputs in memory, for
+    programs that embed padring instead of running it.
+
+    The LEF database is loaded once and shared by all the
+    configurations. layout() may be called from several
+    threads at once, but not while LEF data is added.
+*/
+class PadringContext
+{
+public:
+    /** a context with its own, empty LEF database */
+    PadringContext();
+
+    /** a context that uses an already loaded LEF database,
+        which must stay valid while the context exists. */
+    explicit PadringContext(PRLEFReader &lefreader);
+
+    virtual ~PadringContext();
+
+    /** add the cells of a LEF file held in memory */
+    void addLEF(const char *data, size_t len);
+
+    void addLEF(const std::string &lef)
+    {
+        addLEF(lef.data(), lef.size());
+    }
+
+    /** number of worker threads for the edge placement,
+        0 for one per core. The default is 1. */
+    void setThreads(uint32_t threads)
+    {
+        m_threads = threads;
+    }
+
+    /** number of cells in the LEF database */
+    size_t getCellCount() const
+    {
+        return m_lefreader.getCellCount();
+    }
+
+    PRLEFReader& getLEFReader()
+    {
+        return m_lefreader;
+    }
+
+    /** lay out a configuration and produce the outputs in
+        'outputs', a mask of outputMask_t values.
+        returns false if the configuration is not valid or a
+        space cannot be filled. In the latter case, result
+        holds the cells placed so far and no outputs. */
+    bool layout(const char *config, size_t len, uint32_t outputs, padringResult_t &result);
+
+    bool layout(const std::string &config, uint32_t outputs, padringResult_t &result)
+    {
+        return layout(config.data(), config.size(), outputs, result);
+    }
+
+protected:
+    std::unique_ptr<PRLEFReader> m_ownedReader;
+    PRLEFReader     &m_lefreader;
+    uint32_t        m_threads;
+};
+
+#endif
@@ -0,0 +1,122 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <sstream>
+#include "logging.h"
+#include "parallel.h"
+#include "padringbatch.h"
+
+PadringBatch::PadringBatch(PRLEFReader &lefreader) : m_lefreader(lefreader)
+{
+}
+
+bool PadringBatch::readManifest(std::istream &manifest)
+{
+    std::string line;
+    uint32_t lineNum = 0;
+    while(std::getline(manifest, line))
+    {
+        lineNum++;
+
+        std::stringstream ss(line);
+        batchJob_t job;
+        if (!(ss >> job.m_configFile) || (job.m_configFile[0] == '#'))
+        {
+            continue;
+        }
+
+        std::string option;
+        while(ss >> option)
+        {
+            std::string *filename = nullptr;
+            if ((option == "-o") || (option == "--output"))
+            {
+                filename = &job.m_outputs.m_gds2;
+            }
+            else if (option == "--svg")
+            {
+                filename = &job.m_outputs.m_svg;
+            }
+            else if (option == "--def")
+            {
+                filename = &job.m_outputs.m_def;
+            }
+            else if (option == "--ver")
+            {
+                filename = &job.m_outputs.m_verilog;
+            }
+            else if (option == "--csv")
+            {
+                filename = &job.m_outputs.m_csv;
+            }
+            else
+            {
+                doLog(LOG_ERROR, "Manifest line %d: unknown option %s\n", lineNum, option.c_str());
+                return false;
+            }
+
+            if (!(ss >> *filename))
+            {
+                doLog(LOG_ERROR, "Manifest line %d: missing file name after %s\n", lineNum, option.c_str());
+                return false;
+            }
+        }
+
+        m_jobs.push_back(job);
+    }
+    return true;
+}
+
+bool PadringBatch::runJob(const batchJob_t &job)
+{
+    // tag the messages of this job, as they are
+    // interleaved with the ones of the other jobs.
+    LogField field("config", job.m_configFile);
+
+    // the jobs already run in parallel, so each
+    // session places its edges on its own thread.
+    PadringSession session(m_lefreader, 1);
+    session.setOutputs(job.m_outputs);
+
+    return session.loadFile(job.m_configFile) && session.layout() && session.write();
+}
+
+uint32_t PadringBatch::run(uint32_t threads)
+{
+    std::vector<char> succeeded(m_jobs.size(), 0);
+    parallelFor(m_jobs.size(), threads, [&](size_t index)
+    {
+        doLog(LOG_VERBOSE, "Processing %s\n", m_jobs[index].m_configFile.c_str());
+        succeeded[index] = runJob(m_jobs[index]) ? 1 : 0;
+    });
+
+    uint32_t failed = 0;
+    for(size_t i=0; i<m_jobs.size(); i++)
+    {
+        if (!succeeded[i])
+        {
+            doLog(LOG_ERROR, "Configuration %s failed\n", m_jobs[i].m_configFile.c_str());
+            failed++;
+        }
+    }
+
+    doLog(LOG_INFO, "%d of %d configurations done\n", 
+        static_cast<uint32_t>(m_jobs.size()) - failed, static_cast<uint32_t>(m_jobs.size()));
+    return failed;
+}
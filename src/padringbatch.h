@@ -0,0 +1,89 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef padringbatch_h
+#define padringbatch_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <istream>
+
+#include "prlefreader.h"
+#include "padringsession.h"
+
+/** a configuration file of a batch and its outputs */
+struct batchJob_t
+{
+    std::string     m_configFile;
+    outputFiles_t   m_outputs;
+};
+
+/** Lays out many padring configurations against one
+    LEF database. 
+
+    The jobs run on worker threads, each with its own
+    session, padring database and output files. The LEF
+    database is shared by all of them.
+
+    A manifest has one job per line: the configuration 
+    file, followed by output options as given on the 
+    command line, for example:
+
+        chip_a.config -o chip_a.gds --def chip_a.def
+        chip_b.config -o chip_b.gds --svg chip_b.svg
+
+    Empty lines and lines starting with '#' are skipped.
+*/
+class PadringBatch
+{
+public:
+    /** the LEF database must stay valid while the batch exists */
+    explicit PadringBatch(PRLEFReader &lefreader);
+
+    /** add the jobs of a manifest.
+        returns false if a line cannot be parsed. */
+    bool readManifest(std::istream &manifest);
+
+    /** add a job */
+    void addJob(const batchJob_t &job)
+    {
+        m_jobs.push_back(job);
+    }
+
+    /** the jobs in manifest order */
+    const std::vector<batchJob_t>& getJobs() const
+    {
+        return m_jobs;
+    }
+
+    /** run all the jobs using at most 'threads' worker
+        threads, 0 for one per core.
+        returns the number of jobs that failed. */
+    uint32_t run(uint32_t threads);
+
+protected:
+    /** lay out one configuration and write its outputs */
+    bool runJob(const batchJob_t &job);
+
+    PRLEFReader             &m_lefreader;
+    std::vector<batchJob_t> m_jobs;
+};
+
+#endif
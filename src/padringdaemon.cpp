@@ -0,0 +1,335 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <string.h>
+#include <ctype.h>
+#include <fstream>
+#include <sstream>
+#include "logging.h"
+#include "padringdaemon.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+/** strip trailing white space, such as the '\r' of 
+    clients that send CR LF line endings */
+static void trimRight(std::string &line)
+{
+    while((!line.empty()) && isspace(static_cast<unsigned char>(line.back())))
+    {
+        line.pop_back();
+    }
+}
+
+#ifndef _WIN32
+/** reads lines from a socket */
+class SocketLineReader
+{
+public:
+    explicit SocketLineReader(int fd) : m_fd(fd), m_pos(0) {}
+
+    /** returns false at the end of the connection */
+    bool readLine(std::string &line)
+    {
+        while(true)
+        {
+            size_t eol = m_buffer.find('\n', m_pos);
+            if (eol != std::string::npos)
+            {
+                line.assign(m_buffer, m_pos, eol - m_pos);
+                m_pos = eol + 1;
+                return true;
+            }
+
+            // keep the unfinished line only
+            m_buffer.erase(0, m_pos);
+            m_pos = 0;
+
+            char data[4096];
+            ssize_t bytes = read(m_fd, data, sizeof(data));
+            if (bytes <= 0)
+            {
+                if (m_buffer.empty())
+                {
+                    return false;
+                }
+                line.swap(m_buffer);
+                m_buffer.clear();
+                return true;
+            }
+            m_buffer.append(data, static_cast<size_t>(bytes));
+        }
+    }
+
+protected:
+    int         m_fd;
+    std::string m_buffer;
+    size_t      m_pos;      ///< start of the next line in m_buffer
+};
+
+/** write all of a reply to a socket */
+static bool sendAll(int fd, const std::string &data)
+{
+    size_t sent = 0;
+    while(sent < data.size())
+    {
+        ssize_t bytes = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (bytes <= 0)
+        {
+            return false;
+        }
+        sent += static_cast<size_t>(bytes);
+    }
+    return true;
+}
+#endif
+
+PadringDaemon::PadringDaemon(PadringSession &session, const std::string &configFile)
+    : m_session(session), m_configFile(configFile)
+{
+}
+
+std::string PadringDaemon::update(std::istream &config)
+{
+    if (!m_session.load(config))
+    {
+        return "ERROR configuration";
+    }
+
+    if (!m_session.layout())
+    {
+        return "ERROR layout";
+    }
+
+    if (!m_session.write())
+    {
+        return "ERROR output";
+    }
+
+    std::stringstream reply;
+    reply << "OK " << m_session.getPlacedEdgeCount() << " " << m_session.getWrittenOutputCount();
+    return reply.str();
+}
+
+bool PadringDaemon::handleRequest(const std::string &request, const lineSource_t &readLine, std::string &reply)
+{
+    std::stringstream ss(request);
+    std::string command;
+    ss >> command;
+
+    if (command == "QUIT")
+    {
+        reply = "OK";
+        return false;
+    }
+    else if ((command == "LOAD") || (command == "RELOAD"))
+    {
+        if (command == "LOAD")
+        {
+            std::string filename;
+            std::getline(ss >> std::ws, filename);
+            if (filename.empty())
+            {
+                reply = "ERROR missing file name";
+                return true;
+            }
+            m_configFile = filename;
+        }
+
+        std::ifstream config(m_configFile, std::ifstream::in);
+        if (!config.is_open())
+        {
+            reply = "ERROR cannot open " + m_configFile;
+            return true;
+        }
+        reply = update(config);
+    }
+    else if (command == "CONFIG")
+    {
+        std::stringstream config;
+        std::string line;
+        bool ended = false;
+        while(readLine(line))
+        {
+            trimRight(line);
+            if (line == "END")
+            {
+                ended = true;
+                break;
+            }
+            config << line << "\n";
+        }
+
+        if (!ended)
+        {
+            reply = "ERROR missing END";
+            return true;
+        }
+        reply = update(config);
+    }
+    else if (command.empty())
+    {
+        reply.clear();
+    }
+    else
+    {
+        reply = "ERROR unknown request " + command;
+    }
+    return true;
+}
+
+void PadringDaemon::serve(std::istream &in, std::ostream &out)
+{
+    lineSource_t readLine = [&](std::string &line)
+    {
+        return static_cast<bool>(std::getline(in, line));
+    };
+
+    std::string request;
+    std::string reply;
+    while(readLine(request))
+    {
+        trimRight(request);
+        bool more = handleRequest(request, readLine, reply);
+        if (!reply.empty())
+        {
+            // the log messages of the request go first
+            flushLog();
+            out << reply << std::endl;
+        }
+        if (!more)
+        {
+            break;
+        }
+    }
+}
+
+#ifdef _WIN32
+
+bool PadringDaemon::serveSocket(const std::string &path)
+{
+    doLog(LOG_ERROR, "UNIX domain sockets are not supported on this platform\n");
+    return false;
+}
+
+#else
+
+/** remove a socket left by an earlier daemon. Other files
+    are kept, so a mistyped path does not delete them.
+    returns false if the path exists but is not a socket. */
+static bool removeStaleSocket(const std::string &path)
+{
+    struct stat info;
+    if (lstat(path.c_str(), &info) != 0)
+    {
+        return (errno == ENOENT);
+    }
+
+    if (!S_ISSOCK(info.st_mode))
+    {
+        doLog(LOG_ERROR, "%s exists and is not a socket\n", path.c_str());
+        return false;
+    }
+    return (unlink(path.c_str()) == 0);
+}
+
+bool PadringDaemon::serveSocket(const std::string &path)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        doLog(LOG_ERROR, "Socket path %s is too long\n", path.c_str());
+        return false;
+    }
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (!removeStaleSocket(path))
+    {
+        doLog(LOG_ERROR, "Cannot use socket %s\n", path.c_str());
+        return false;
+    }
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0)
+    {
+        doLog(LOG_ERROR, "Cannot create socket %s\n", path.c_str());
+        return false;
+    }
+
+    if ((bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) ||
+        (listen(server, 4) != 0))
+    {
+        doLog(LOG_ERROR, "Cannot listen on socket %s\n", path.c_str());
+        close(server);
+        return false;
+    }
+
+    doLog(LOG_INFO, "Waiting for requests on %s\n", path.c_str());
+
+    bool more = true;
+    while(more)
+    {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0)
+        {
+            // a signal or a client that gave up;
+            // anything else will not go away.
+            if ((errno == EINTR) || (errno == ECONNABORTED))
+            {
+                continue;
+            }
+            doLog(LOG_ERROR, "Cannot accept clients on socket %s: %s\n", path.c_str(), strerror(errno));
+            close(server);
+            unlink(path.c_str());
+            return false;
+        }
+
+        SocketLineReader reader(client);
+        lineSource_t readLine = [&](std::string &line)
+        {
+            return reader.readLine(line);
+        };
+
+        std::string request;
+        std::string reply;
+        while(more && readLine(request))
+        {
+            trimRight(request);
+            more = handleRequest(request, readLine, reply);
+            if ((!reply.empty()) && (!sendAll(client, reply + "\n")))
+            {
+                break;
+            }
+        }
+        close(client);
+    }
+
+    close(server);
+    unlink(path.c_str());
+    return true;
+}
+
+#endif
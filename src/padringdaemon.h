@@ -0,0 +1,77 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef padringdaemon_h
+#define padringdaemon_h
+
+#include <string>
+#include <istream>
+#include <ostream>
+#include <functional>
+
+#include "padringsession.h"
+
+/** Keeps a padring session running and applies configuration
+    updates sent over stdin or a UNIX domain socket.
+
+    Requests are lines of text:
+        LOAD <file>     lay out a configuration file
+        RELOAD          lay out the last configuration file again
+        CONFIG          lay out the configuration on the following
+                        lines, up to a line holding END. The END
+                        of a REPEAT block keeps its ';' on the
+                        same line, so it does not end the request.
+        QUIT            stop the daemon
+
+    Each request is answered with one line, either 
+    'OK <placed edges> <written outputs>' or 'ERROR <reason>'.
+    Only the edges that changed are placed again and only the
+    outputs that change are written.
+*/
+class PadringDaemon
+{
+public:
+    PadringDaemon(PadringSession &session, const std::string &configFile);
+
+    /** serve requests from a stream until QUIT
+        or the end of the stream. */
+    void serve(std::istream &in, std::ostream &out);
+
+    /** serve requests from the clients of a UNIX domain 
+        socket, one client at a time, until QUIT. An existing
+        path is only replaced if it is a socket.
+        returns false if the socket cannot be created or
+        accepting clients fails, and on platforms without
+        UNIX domain sockets. */
+    bool serveSocket(const std::string &path);
+
+protected:
+    typedef std::function<bool(std::string &line)> lineSource_t;
+
+    /** handle one request. returns false on QUIT. */
+    bool handleRequest(const std::string &request, const lineSource_t &readLine, std::string &reply);
+
+    /** lay out a configuration and write the changed outputs */
+    std::string update(std::istream &config);
+
+    PadringSession  &m_session;
+    std::string     m_configFile;   ///< last configuration file
+};
+
+#endif
@@ -25,170 +25,245 @@
 #include "layout.h"
 #include "logging.h"
 
+/** The padring described by a configuration file. The cells
+    are taken from a LEF database that is owned by the caller,
+    so it can be shared by several padrings.
+*/
 class PadringDB : public ConfigReader
 {
 public:
 
-    PadringDB() : m_north(Layout::DIR_HORIZONTAL, Layout::SIDE_NORTH),
+    PadringDB(PRLEFReader &lefreader) : m_north(Layout::DIR_HORIZONTAL, Layout::SIDE_NORTH),
         m_south(Layout::DIR_HORIZONTAL, Layout::SIDE_SOUTH),
         m_east(Layout::DIR_VERTICAL, Layout::SIDE_EAST),
         m_west(Layout::DIR_VERTICAL, Layout::SIDE_WEST),
-        m_grid(1.0) 
+        m_dieHeight(0.0),
+        m_dieWidth(0.0),
+        m_grid(1.0),
+        m_databaseUnits(1000.0),
+        m_lastLocation(LOC_NONE),
+        m_lefreader(lefreader)
     {
-        m_south.setEdgePos(0.0);
-        m_west.setEdgePos(0.0);
+        m_south.setEdgePos(0);
+        m_west.setEdgePos(0);
         m_designName = "PADRING";
     }
 
+    /** set the number of database units per micron used for
+        the layout. Must be called before the configuration
+        is parsed. */
+    void setDatabaseUnits(double databaseUnits)
+    {
+        m_databaseUnits = databaseUnits;
+    }
+
+    double getDatabaseUnits() const
+    {
+        return m_databaseUnits;
+    }
+
+    /** convert microns to database units */
+    dbu_t toDBU(double microns) const
+    {
+        return ::toDBU(microns, m_databaseUnits);
+    }
+
+    /** the grid in database units, at least one unit */
+    dbu_t getGrid() const
+    {
+        dbu_t grid = toDBU(m_grid);
+        return (grid > 0) ? grid : 1;
+    }
+
     /** callback for a corner */
     virtual void onCorner(
-        const std::string &instance,
-        const std::string &location,
-        const std::string &cellname) override
+        const std::string_view &instance,
+        const std::string_view &location,
+        const std::string_view &cellname) override
     {
         PRLEFReader::LEFCellInfo_t *cell = m_lefreader.getCellByName(cellname);
         if (cell == nullptr)
         {
-            doLog(LOG_ERROR,"Cannot find cell %s in the LEF database\n", cellname.c_str());
+            doLog(LOG_ERROR,"Cannot find cell %s in the LEF database\n", std::string(cellname).c_str());
             return;
         }
 
-        LayoutItem *item_x = new LayoutItem(LayoutItem::TYPE_CORNER);
-        item_x->m_instance = instance;
-        item_x->m_cellname = cellname;
-        item_x->m_location = location;
-        item_x->m_size = cell->m_sx;
-        item_x->m_lefinfo = cell;
+        location_t loc = toLocation(location);
+        symbol_t instanceID = m_names.intern(instance);
+        symbol_t cellID     = internSymbol(cellname);
 
-        LayoutItem *item_y = new LayoutItem(LayoutItem::TYPE_CORNER);
-        item_y->m_instance = instance;
-        item_y->m_cellname = cellname;
-        item_y->m_location = location;
-        item_y->m_size = cell->m_sy;
-        item_y->m_lefinfo = cell;
+        LayoutItem item_x(LayoutItem::TYPE_CORNER);
+        item_x.m_instance = instanceID;
+        item_x.m_cellname = cellID;
+        item_x.m_location = loc;
+        item_x.m_size = toDBU(cell->m_sx);
+        item_x.m_lefinfo = cell;
+
+        LayoutItem item_y(LayoutItem::TYPE_CORNER);
+        item_y.m_instance = instanceID;
+        item_y.m_cellname = cellID;
+        item_y.m_location = loc;
+        item_y.m_size = toDBU(cell->m_sy);
+        item_y.m_lefinfo = cell;
 
         // Corner cells should be symmetrical
         // i.e. width = height.
-        if (location == "NE")
+        switch(loc)
         {
+        case LOC_NE:
             // ROT 180
             m_north.setLastCorner(item_x);
             m_east.setLastCorner(item_y);
-        }
-        else if (location == "NW")
-        {
+            break;
+        case LOC_NW:
             // ROT 90
             m_north.setFirstCorner(item_y);
             m_west.setLastCorner(item_x);
-        }
-        else if (location == "SE")
-        {
+            break;
+        case LOC_SE:
             // ROT 270
             m_south.setLastCorner(item_y);
             m_east.setFirstCorner(item_x);            
-        }
-        else if (location == "SW")
-        {
+            break;
+        case LOC_SW:
             // ROT 0
             m_south.setFirstCorner(item_x);
             m_west.setFirstCorner(item_y);
+            break;
+        default:
+            break;
         }
     }
 
     /** callback for a pad */
     virtual void onPad(
-        const std::string &instance,
-        const std::string &location,
-        const std::string &cellname,
+        const std::string_view &instance,
+        const std::string_view &location,
+        const std::string_view &cellname,
         bool flipped) override
     {
-        PRLEFReader::LEFCellInfo_t *cell = m_lefreader.getCellByName(cellname);
-        if (cell == nullptr)
+        location_t loc = toLocation(location);
+
+        LayoutItem item(LayoutItem::TYPE_CELL);
+        if (!createCellItem(cellname, loc, flipped, item))
         {
-            doLog(LOG_ERROR,"Cannot find cell %s in the LEF database\n", cellname.c_str());
             return;
         }
+        item.m_instance = m_names.intern(instance);
 
-        LayoutItem *item = new LayoutItem(LayoutItem::TYPE_CELL);
-        item->m_instance = instance;
-        item->m_cellname = cellname;
-        item->m_location = location;
-        item->m_size = cell->m_sx;
-        item->m_osize = cell->m_sy;
-        item->m_lefinfo = cell;
-        item->m_flipped = flipped;
-
-        // Corner cells should be symmetrical
-        // i.e. width = height.
-        if (location == "N")
+        Layout *edge = getEdge(loc);
+        if (edge != nullptr)
         {
-            m_north.addItem(item);
-        }
-        else if (location == "W")
-        {
-            m_west.addItem(item);
-        }
-        else if (location == "S")
-        {
-            m_south.addItem(item);
-        }
-        else if (location == "E")
-        {
-            m_east.addItem(item);
+            edge->addItem(item);
         }
         else
         {
-            doLog(LOG_ERROR, "Incorrect location on PAD %s\n", cellname.c_str());
+            doLog(LOG_ERROR, "Incorrect location on PAD %s\n", std::string(cellname).c_str());
         }
 
-        m_lastLocation = location;
+        m_lastLocation = loc;
     }
 
     /** callback for a bond */
     virtual void onBond(
-        const std::string &instance,
-        const std::string &cellname,
+        const std::string_view &instance,
+        const std::string_view &cellname,
         bool flipped,
         double gd) override
     {
-        PRLEFReader::LEFCellInfo_t *cell = m_lefreader.getCellByName(cellname);
-        if (cell == nullptr)
+        LayoutItem item(LayoutItem::TYPE_BOND);
+        if (!createCellItem(cellname, m_lastLocation, flipped, item))
         {
-            doLog(LOG_ERROR,"Cannot find cell %s in the LEF database\n", cellname.c_str());
             return;
         }
-        doLog(LOG_INFO,"Added a bond in loc %s cell %s inst %s\n", m_lastLocation.c_str(), instance.c_str(), cellname.c_str());
-
-        LayoutItem *item = new LayoutItem(LayoutItem::TYPE_BOND);
-        item->m_instance = instance;
-        item->m_cellname = cellname;
-        item->m_location = m_lastLocation;
-        item->m_size = cell->m_sx;
-        item->m_osize = cell->m_sy;
-        item->m_lefinfo = cell;
-        item->m_flipped = flipped;
-        item->m_offset = gd;
-
-        if (m_lastLocation == "N")
-        {
-            m_north.addItem(item);
-        }
-        else if (m_lastLocation == "W")
+        doLog(LOG_INFO,"Added a bond in loc %s cell %.*s inst %.*s\n", toString(m_lastLocation), 
+            static_cast<int>(instance.size()), instance.data(), static_cast<int>(cellname.size()), cellname.data());
+
+        item.m_instance = m_names.intern(instance);
+        item.m_offset = toDBU(gd);
+
+        Layout *edge = getEdge(m_lastLocation);
+        if (edge != nullptr)
         {
-            m_west.addItem(item);
+            edge->addItem(item);
         }
-        else if (m_lastLocation == "S")
+        else
         {
-            m_south.addItem(item);
+            doLog(LOG_ERROR, "Incorrect location on BOND %s\n", std::string(cellname).c_str());
         }
-        else if (m_lastLocation == "E")
+    }
+
+    /** callback for a range of pads, bonds and spaces. The cells
+        are looked up once, each repetition only adds the items 
+        with their own instance names. */
+    virtual void onRepeat(uint32_t count, const std::vector<configStatement_t> &statements) override
+    {
+        // the item and the edge of each statement,
+        // or a null edge if the statement is skipped.
+        std::vector<LayoutItem> items;
+        std::vector<Layout*> edges;
+        items.reserve(statements.size());
+        edges.reserve(statements.size());
+
+        location_t loc = m_lastLocation;
+        for(auto const &statement : statements)
         {
-            m_east.addItem(item);
+            switch(statement.m_type)
+            {
+            case configStatement_t::STMT_PAD:
+                loc = toLocation(statement.m_location);
+                items.emplace_back(LayoutItem::TYPE_CELL);
+                break;
+            case configStatement_t::STMT_BOND:
+                items.emplace_back(LayoutItem::TYPE_BOND);
+                items.back().m_offset = toDBU(statement.m_value);
+                break;
+            case configStatement_t::STMT_SPACE:
+                items.emplace_back(LayoutItem::TYPE_FIXEDSPACE);
+                items.back().m_size = toDBU(statement.m_value);
+                break;
+            }
+
+            Layout *edge = getEdge(loc);
+            if ((statement.m_type != configStatement_t::STMT_SPACE) &&
+                (!createCellItem(statement.m_cellname, loc, statement.m_flipped, items.back())))
+            {
+                edge = nullptr;
+            }
+            else if ((edge == nullptr) && (statement.m_type != configStatement_t::STMT_SPACE))
+            {
+                doLog(LOG_ERROR, "Incorrect location on %s %s\n", 
+                    (statement.m_type == configStatement_t::STMT_PAD) ? "PAD" : "BOND",
+                    std::string(statement.m_cellname).c_str());
+            }
+            edges.push_back(edge);
         }
-        else
+
+        std::string name;
+        for(uint32_t i=0; i<count; i++)
         {
-            doLog(LOG_ERROR, "Incorrect location on BOND %s\n", cellname.c_str());
+            for(size_t j=0; j<statements.size(); j++)
+            {
+                if (edges[j] == nullptr)
+                {
+                    continue;
+                }
+                if (statements[j].m_type != configStatement_t::STMT_SPACE)
+                {
+                    std::string_view instance = statements[j].m_instance.getName(i, name);
+                    if (statements[j].m_type == configStatement_t::STMT_BOND)
+                    {
+                        const std::string_view &cellname = statements[j].m_cellname;
+                        doLog(LOG_INFO,"Added a bond in loc %s cell %.*s inst %.*s\n", toString(items[j].m_location), 
+                            static_cast<int>(instance.size()), instance.data(), static_cast<int>(cellname.size()), cellname.data());
+                    }
+                    items[j].m_instance = m_names.intern(instance);
+                }
+                edges[j]->addItem(items[j]);
+            }
         }
+
+        m_lastLocation = loc;
     }
 
     /** callback for die area in microns */
@@ -197,13 +272,13 @@ public:
         m_dieWidth  = x;
         m_dieHeight = y;
         
-        m_north.setDieSize(x);
-        m_south.setDieSize(x);
-        m_east.setDieSize(y);
-        m_west.setDieSize(y);
+        m_north.setDieSize(toDBU(x));
+        m_south.setDieSize(toDBU(x));
+        m_east.setDieSize(toDBU(y));
+        m_west.setDieSize(toDBU(y));
 
-        m_north.setEdgePos(y);
-        m_east.setEdgePos(x);        
+        m_north.setEdgePos(toDBU(y));
+        m_east.setEdgePos(toDBU(x));        
     }
 
     /** callback for grid spacing in microns */
@@ -213,60 +288,38 @@ public:
     }
 
     /** callback for filler cell prefix string */
-    virtual void onFiller(const std::list<std::string> &fillers) override
+    virtual void onFiller(const std::vector<std::string_view> &fillers) override
     {
         m_fillers.clear();
         m_fillers.assign(fillers.begin(), fillers.end());
 
         // Besides of replacing the fillers, we also add the filler declaration to dynamically change fillers
-        LayoutItem *item = new LayoutItem(LayoutItem::TYPE_FILLERDECL);
-        item->m_fillers.assign(fillers.begin(), fillers.end());
-        item->m_size = 0;
-        if (m_lastLocation == "N")
-        {
-            m_north.addItem(item);
-        }
-        else if (m_lastLocation == "W")
-        {
-            m_west.addItem(item);
-        }
-        else if (m_lastLocation == "S")
-        {
-            m_south.addItem(item);
-        }
-        else if (m_lastLocation == "E")
+        LayoutItem item(LayoutItem::TYPE_FILLERDECL);
+        item.m_fillers.assign(fillers.begin(), fillers.end());
+        item.m_size = 0;
+        Layout *edge = getEdge(m_lastLocation);
+        if (edge != nullptr)
         {
-            m_east.addItem(item);
+            edge->addItem(item);
         }
     }
 
     /** callback for filler cell prefix string */
-    virtual void onLoc(const std::string &location) override
+    virtual void onLoc(const std::string_view &location) override
     {
-        m_lastLocation = location;
+        m_lastLocation = toLocation(location);
     }
 
     /** callback for space in microns */
     virtual void onSpace(double space) override
     {
-        LayoutItem *item = new LayoutItem(LayoutItem::TYPE_FIXEDSPACE);
-        item->m_size = space;
+        LayoutItem item(LayoutItem::TYPE_FIXEDSPACE);
+        item.m_size = toDBU(space);
 
-        if (m_lastLocation == "N")
+        Layout *edge = getEdge(m_lastLocation);
+        if (edge != nullptr)
         {
-            m_north.addItem(item);
-        }
-        else if (m_lastLocation == "W")
-        {
-            m_west.addItem(item);
-        }
-        else if (m_lastLocation == "S")
-        {
-            m_south.addItem(item);
-        }
-        else if (m_lastLocation == "E")
-        {
-            m_east.addItem(item);
+            edge->addItem(item);
         }
     }
 
@@ -276,21 +329,50 @@ public:
         //FIXME: offset not supported yet!
     }
 
-    virtual void onDesignName(const std::string &designName) override
+    virtual void onDesignName(const std::string_view &designName) override
     {
         m_designName = designName;
     }
 
-    void doLayout()
+    /** set up the item of a PAD or BOND cell, without its
+        instance name. returns false if the cell is not in
+        the LEF database. */
+    bool createCellItem(const std::string_view &cellname, location_t loc, bool flipped, LayoutItem &item)
     {
-        m_north.setGrid(m_grid);
-        m_south.setGrid(m_grid);
-        m_west.setGrid(m_grid);
-        m_east.setGrid(m_grid);
-        m_north.doLayout();
-        m_south.doLayout();
-        m_west.doLayout();
-        m_east.doLayout();
+        PRLEFReader::LEFCellInfo_t *cell = m_lefreader.getCellByName(cellname);
+        if (cell == nullptr)
+        {
+            doLog(LOG_ERROR,"Cannot find cell %s in the LEF database\n", std::string(cellname).c_str());
+            return false;
+        }
+
+        item.m_cellname = internSymbol(cellname);
+        item.m_location = loc;
+        item.m_size = toDBU(cell->m_sx);
+        item.m_osize = toDBU(cell->m_sy);
+        item.m_lefinfo = cell;
+        item.m_flipped = flipped;
+        return true;
+    }
+
+    /** the edge for a N, S, E or W location.
+        returns nullptr for corners and LOC_NONE.
+    */
+    Layout* getEdge(location_t location)
+    {
+        switch(location)
+        {
+        case LOC_N:
+            return &m_north;
+        case LOC_S:
+            return &m_south;
+        case LOC_E:
+            return &m_east;
+        case LOC_W:
+            return &m_west;
+        default:
+            return nullptr;
+        }
     }
 
     Layout m_north;
@@ -298,16 +380,22 @@ public:
     Layout m_east;
     Layout m_west;
 
-    double m_dieHeight;
-    double m_dieWidth;
-    double m_grid;
+    double m_dieHeight;     ///< die height in microns
+    double m_dieWidth;      ///< die width in microns
+    double m_grid;          ///< grid in microns
+    double m_databaseUnits; ///< database units per micron of the layout
 
     std::string m_designName;
 
     std::list<std::string> m_fillers;
-    std::string m_lastLocation;
+    location_t  m_lastLocation;
+
+    PRLEFReader &m_lefreader;   ///< LEF cell database
 
-    PRLEFReader m_lefreader;
+    /** instance names of this configuration. Cell names are
+        checked against the LEF database and go in the global
+        symbol table. */
+    SymbolTable m_names;
 };
 
 #endif
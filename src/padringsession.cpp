@@ -0,0 +1,616 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <algorithm>
+#include <iterator>
+#include <sys/stat.h>
+#include "logging.h"
+#include "mappedfile.h"
+#include "stats.h"
+#include "parallel.h"
+#include "outputsink.h"
+#include "placement.h"
+#include "svgwriter.h"
+#include "defwriter.h"
+#include "verilogwriter.h"
+#include "csvwriter.h"
+#include "gds2/gds2writer.h"
+#include "padringsession.h"
+
+/** edge names for the error messages, by location */
+static const char *gs_edgeNames[LOC_COUNT] = 
+{
+    "north", "south", "east", "west", "", "", "", "", ""
+};
+
+/** locations of the edges, in writing order */
+static const location_t gs_edgeLocations[4] = {LOC_N, LOC_S, LOC_W, LOC_E};
+
+/** FNV-1a hash, used to find out what changed between
+    two configurations. */
+class Fingerprint
+{
+public:
+    explicit Fingerprint(uint64_t seed = 14695981039346656037ULL) : m_hash(seed) {}
+
+    void add(const void *data, size_t bytes)
+    {
+        const uint8_t *ptr = static_cast<const uint8_t*>(data);
+        for(size_t i=0; i<bytes; i++)
+        {
+            m_hash ^= ptr[i];
+            m_hash *= 1099511628211ULL;
+        }
+    }
+
+    void add(const std::string_view &str)
+    {
+        add(str.data(), str.size());
+        addValue(str.size());
+    }
+
+    template<class T> void addValue(const T &v)
+    {
+        add(&v, sizeof(v));
+    }
+
+    uint64_t get() const
+    {
+        return m_hash;
+    }
+
+protected:
+    uint64_t m_hash;
+};
+
+/** add the configuration of a layout item to a fingerprint */
+static void addItem(Fingerprint &fp, const LayoutItem &item)
+{
+    fp.addValue(static_cast<uint32_t>(item.m_ltype));
+    // instance IDs are only unique within a configuration
+    fp.add(item.getInstanceName());
+    fp.addValue(item.m_cellname);
+    fp.addValue(static_cast<uint32_t>(item.m_location));
+    fp.addValue(item.m_size);
+    fp.addValue(item.m_osize);
+    fp.addValue(item.m_offset);
+    fp.addValue(item.m_flipped);
+    fp.addValue(item.m_lefinfo);
+    for(auto const &filler : item.m_fillers)
+    {
+        fp.add(filler);
+    }
+    fp.addValue(item.m_fillers.size());
+}
+
+/** times an output and counts the size of its file or stream */
+class TimedSink : public OutputSink
+{
+public:
+    TimedSink(OutputSink *sink, statTimer_t timer, statCounter_t bytes, const std::string &filename, std::ostream *stream)
+        : m_sink(sink), m_timer(timer), m_bytes(bytes), m_filename(filename), m_stream(stream),
+          m_start((stream != nullptr) ? stream->tellp() : std::streampos(-1)),
+          m_elapsed(std::chrono::steady_clock::duration::zero()) {}
+
+    virtual ~TimedSink()
+    {
+        // the outputs complete their files when deleted
+        auto start = std::chrono::steady_clock::now();
+        delete m_sink;
+        m_elapsed += std::chrono::steady_clock::now() - start;
+        Stats::addTime(m_timer, std::chrono::duration_cast<std::chrono::nanoseconds>(m_elapsed).count());
+
+        if (m_stream != nullptr)
+        {
+            std::streampos end = m_stream->tellp();
+            if ((m_start != std::streampos(-1)) && (end != std::streampos(-1)))
+            {
+                Stats::count(m_bytes, static_cast<uint64_t>(end - m_start));
+            }
+            return;
+        }
+
+        struct stat info;
+        if (stat(m_filename.c_str(), &info) == 0)
+        {
+            Stats::count(m_bytes, static_cast<uint64_t>(info.st_size));
+        }
+    }
+
+    virtual void onBegin(uint32_t cellCount, double databaseUnits) override
+    {
+        auto start = std::chrono::steady_clock::now();
+        m_sink->onBegin(cellCount, databaseUnits);
+        m_elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    virtual void onCells(const PlacedCell *cells, size_t count) override
+    {
+        auto start = std::chrono::steady_clock::now();
+        m_sink->onCells(cells, count);
+        m_elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    virtual void onFinish(const cellSource_t &cells) override
+    {
+        auto start = std::chrono::steady_clock::now();
+        m_sink->onFinish(cells);
+        m_elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    virtual void onAbort() override
+    {
+        m_sink->onAbort();
+    }
+
+protected:
+    OutputSink      *m_sink;
+    statTimer_t     m_timer;
+    statCounter_t   m_bytes;
+    std::string     m_filename;
+    std::ostream    *m_stream;      ///< stream written instead of the file, or nullptr
+    std::streampos  m_start;        ///< position of the stream at the start
+    std::chrono::steady_clock::duration m_elapsed;  ///< time spent in the output
+};
+
+/** true if an output is wanted. Logs the file it is written to. */
+static bool wantOutput(const char *kind, const std::string &filename, std::ostream *stream)
+{
+    if (stream != nullptr)
+    {
+        return true;
+    }
+    if (filename.empty())
+    {
+        return false;
+    }
+    doLog(LOG_INFO,"Writing padring to %s file: %s\n", kind, filename.c_str());
+    return true;
+}
+
+PadringSession::PadringSession(PRLEFReader &lefreader, uint32_t threads)
+    : m_lefreader(lefreader),
+      m_threads(threads),
+      m_incremental(false),
+      m_fillerFingerprint(0),
+      m_outputsValid(false),
+      m_layoutFingerprint(0),
+      m_netlistFingerprint(0),
+      m_placedEdges(0),
+      m_writtenOutputs(0)
+{
+    // the layout is done in the LEF database units,
+    // or in nanometers if the LEF files do not specify them.
+    m_databaseUnits = (m_lefreader.m_lefDatabaseUnits > 1e-12) ? m_lefreader.m_lefDatabaseUnits : 1000.0;
+
+    for(auto &fp : m_edgeFingerprints)
+    {
+        fp = 0;
+    }
+}
+
+PadringSession::~PadringSession()
+{
+}
+
+void PadringSession::setOutputs(const outputFiles_t &outputs)
+{
+    m_outputs = outputs;
+    m_outputsValid = false;
+}
+
+void PadringSession::setOutputStreams(const outputStreams_t &streams)
+{
+    m_streams = streams;
+    m_outputsValid = false;
+}
+
+bool PadringSession::load(std::istream &config)
+{
+    if (!config.good())
+    {
+        doLog(LOG_ERROR,"Cannot read configuration -- aborting\n");
+        return false;
+    }
+
+    std::string contents((std::istreambuf_iterator<char>(config)),
+        std::istreambuf_iterator<char>());
+
+    return load(contents.data(), contents.size());
+}
+
+bool PadringSession::loadFile(const std::string &filename)
+{
+    MappedFile config;
+    if (!config.open(filename))
+    {
+        doLog(LOG_ERROR,"Cannot open configuration file %s\n", filename.c_str());
+        return false;
+    }
+
+    return load(config.data(), config.size());
+}
+
+bool PadringSession::load(const char *data, size_t len)
+{
+    std::unique_ptr<PadringDB> padring(new PadringDB(m_lefreader));
+    padring->setDatabaseUnits(m_databaseUnits);
+    if (!padring->parse(data, len))
+    {
+        doLog(LOG_ERROR,"Cannot parse configuration file -- aborting\n");
+        return false;
+    }
+
+    // if an explicit filler cell prefix was not given,
+    // search the cell database for filler cells. The filler
+    // cells of the previous configuration are kept if they
+    // are the same, so their decomposition tables are too.
+    Fingerprint fp;
+    for(auto const &filler : padring->m_fillers)
+    {
+        fp.add(filler);
+    }
+    fp.addValue(padring->getGrid());
+
+    std::unique_ptr<FillerHandler> newFillers;
+    FillerHandler *fillers = m_fillers.get();
+    if ((fillers == nullptr) || (m_fillerFingerprint != fp.get()))
+    {
+        newFillers.reset(new FillerHandler(m_databaseUnits));
+        newFillers->addFillers(&m_lefreader, padring->m_fillers);
+        fillers = newFillers.get();
+    }
+
+    doLog(LOG_INFO, "Found %d filler cells\n", fillers->getCellCount());
+
+    if (fillers->getCellCount() == 0)
+    {
+        doLog(LOG_ERROR, "Cannot proceed without filler cells. Please use the --filler option to explicitly specify a filler cell prefix\n");
+        return false;
+    }
+
+    // check die size
+    if ((padring->m_dieWidth < 1.0e-6) || (padring->m_dieHeight < 1.0e-6))
+    {
+        doLog(LOG_ERROR, "Die area was not specified! - aborting.\n");
+        return false;
+    }
+
+    // generate report
+    doLog(LOG_INFO,"Die area        : %f x %f microns\n", padring->m_dieWidth, padring->m_dieHeight);
+    doLog(LOG_INFO,"Grid            : %f microns\n", padring->m_grid);
+    doLog(LOG_INFO,"Padring cells   : %d\n", padring->getPadCellCount());
+    doLog(LOG_INFO,"Smallest filler : %f microns\n", toMicrons(fillers->getSmallestWidth(), m_databaseUnits));
+
+    m_padring = std::move(padring);
+    if (newFillers)
+    {
+        m_fillers = std::move(newFillers);
+        m_fillerFingerprint = fp.get();
+    }
+    return true;
+}
+
+uint64_t PadringSession::getEdgeFingerprint(Layout *edge, dbu_t edgePos, uint64_t &fillerState) const
+{
+    Fingerprint fp(fillerState);
+    fp.addValue(edgePos);
+    fp.addValue(m_padring->getGrid());
+    fp.addValue(edge->getDieSize());
+
+    const LayoutItem *corners[2] = {edge->getFirstCorner(), edge->getLastCorner()};
+    for(auto corner : corners)
+    {
+        fp.addValue(corner != nullptr);
+        if (corner != nullptr)
+        {
+            addItem(fp, *corner);
+        }
+    }
+
+    // filler declarations also change the
+    // filler cells of the following edges.
+    Fingerprint fillerFp(fillerState);
+    for(auto item : *edge)
+    {
+        addItem(fp, *item);
+        if (item->m_ltype == LayoutItem::TYPE_FILLERDECL)
+        {
+            addItem(fillerFp, *item);
+        }
+    }
+    fillerState = fillerFp.get();
+
+    return fp.get();
+}
+
+bool PadringSession::layout()
+{
+    m_placedEdges = 0;
+    if (!m_padring)
+    {
+        return false;
+    }
+
+    PadringDB &padring = *m_padring;
+    dbu_t grid = padring.getGrid();
+    Layout *edges[4] = {&padring.m_north, &padring.m_south, &padring.m_west, &padring.m_east};
+    dbu_t edgePositions[4] = {padring.toDBU(padring.m_dieHeight), 0, 0, padring.toDBU(padring.m_dieWidth)};
+
+    // compute the filler decomposition table once for 
+    // all the edges and configurations.
+    {
+        ScopedTimer timer(STAT_FILLERS);
+        m_fillers->setGrid(grid);
+        m_fillers->prepare(std::max(padring.toDBU(padring.m_dieWidth), padring.toDBU(padring.m_dieHeight)));
+    }
+
+    // lay out the edges and fill the spaces with filler cells.
+    // filler declarations carry over to the next edge, so the
+    // filler cells are collected up front, in writing order.
+    // Edges that did not change keep their placement.
+    FillerHandler current(*m_fillers);
+    uint64_t fillerState = m_fillerFingerprint;
+    std::vector<size_t> changed;
+    for(size_t i=0; i<4; i++)
+    {
+        uint64_t fp = getEdgeFingerprint(edges[i], edgePositions[i], fillerState);
+        if (m_incremental && m_placers[i] && m_placers[i]->isComplete() && (m_edgeFingerprints[i] == fp))
+        {
+            m_placers[i]->setEdge(edges[i]);
+        }
+        else
+        {
+            m_placers[i].reset(new EdgePlacer(edges[i], gs_edgeLocations[i], edgePositions[i], grid));
+            changed.push_back(i);
+        }
+        m_edgeFingerprints[i] = fp;
+        m_placers[i]->prepareFillers(current, &m_lefreader);
+    }
+
+    // the edges are independent, so they are placed concurrently.
+    parallelFor(changed.size(), m_threads, [&](size_t index)
+    {
+        m_placers[changed[index]]->place();
+    });
+    m_placedEdges = static_cast<uint32_t>(changed.size());
+
+    for(auto const &placer : m_placers)
+    {
+        if (!placer->isComplete())
+        {
+            doLog(LOG_ERROR, "(%s) Cannot find filler cell that fits remaining width %g (%d)\n", 
+                gs_edgeNames[placer->getLocation()], toMicrons(placer->getUnfilledWidth(), m_databaseUnits), 
+                placer->getUnfilledType());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void PadringSession::visitPlacedItems(const std::function<void(const LayoutItem *item)> &visit) const
+{
+    // the corners first and then the edges in order.
+    const LayoutItem *corners[4] = 
+    {
+        m_placers[0]->getFirstCorner(), m_placers[0]->getLastCorner(),
+        m_placers[1]->getFirstCorner(), m_placers[1]->getLastCorner()
+    };
+
+    for(auto corner : corners)
+    {
+        if (corner != nullptr) visit(corner);
+    }
+    for(auto const &placer : m_placers)
+    {
+        for(auto const &item : placer->getItems())
+        {
+            visit(&item);
+        }
+    }
+}
+
+void PadringSession::visitPlacedCells(const std::function<void(const PlacedCell &cell)> &visit) const
+{
+    if (!m_placers[0])
+    {
+        return;
+    }
+
+    visitPlacedItems([&](const LayoutItem *item)
+    {
+        PlacedCell cell;
+        if (PlacementStream::resolve(item, m_databaseUnits, cell))
+        {
+            visit(cell);
+        }
+    });
+}
+
+bool PadringSession::write()
+{
+    m_writtenOutputs = 0;
+    if ((!m_padring) || (!m_placers[0]))
+    {
+        return false;
+    }
+
+    PadringDB &padring = *m_padring;
+
+    // find out which outputs change: the netlist and the
+    // pad list only depend on the cells, not on their positions.
+    bool layoutChanged  = true;
+    bool netlistChanged = true;
+    if (m_incremental)
+    {
+        Fingerprint layoutFp;
+        Fingerprint netlistFp;
+        layoutFp.add(padring.m_designName);
+        layoutFp.addValue(padring.m_dieWidth);
+        layoutFp.addValue(padring.m_dieHeight);
+        netlistFp.add(padring.m_designName);
+        visitPlacedItems([&](const LayoutItem *item)
+        {
+            PlacedCell cell;
+            if (PlacementStream::resolve(item, m_databaseUnits, cell))
+            {
+                netlistFp.addValue(cell.m_cellname);
+                netlistFp.add(cell.getInstanceName());
+                netlistFp.addValue(static_cast<uint32_t>(cell.m_ltype));
+                layoutFp.addValue(cell.m_cellname);
+                layoutFp.add(cell.getInstanceName());
+                layoutFp.addValue(static_cast<uint32_t>(cell.m_ltype));
+                layoutFp.addValue(static_cast<uint32_t>(cell.m_orient));
+                layoutFp.addValue(cell.m_flipped);
+                layoutFp.addValue(cell.m_x);
+                layoutFp.addValue(cell.m_y);
+            }
+        });
+
+        if (m_outputsValid)
+        {
+            layoutChanged  = (layoutFp.get() != m_layoutFingerprint);
+            netlistChanged = (netlistFp.get() != m_netlistFingerprint);
+        }
+        m_layoutFingerprint  = layoutFp.get();
+        m_netlistFingerprint = netlistFp.get();
+    }
+
+    // create the requested outputs that change
+    m_outputsValid = false;
+    std::vector<OutputSink*> sinks;
+    auto failed = [&](const char *message)
+    {
+        doLog(LOG_ERROR, message);
+        for(auto sink : sinks)
+        {
+            delete sink;
+        }
+        return false;
+    };
+
+    if (layoutChanged && wantOutput("SVG", m_outputs.m_svg, m_streams.m_svg))
+    {
+        SVGWriter *svg = (m_streams.m_svg != nullptr) ? 
+            new SVGWriter(*m_streams.m_svg, padring.m_dieWidth, padring.m_dieHeight) :
+            SVGWriter::open(m_outputs.m_svg, padring.m_dieWidth, padring.m_dieHeight);
+        if (svg == nullptr)
+        {
+            return failed("Cannot open SVG file for writing!\n");
+        }
+        sinks.push_back(new TimedSink(svg, STAT_WRITE_SVG, STAT_SVG_BYTES, m_outputs.m_svg, m_streams.m_svg));
+    }
+
+    if (layoutChanged && wantOutput("DEF", m_outputs.m_def, m_streams.m_def))
+    {
+        DEFWriter *def = (m_streams.m_def != nullptr) ?
+            new DEFWriter(*m_streams.m_def, padring.toDBU(padring.m_dieWidth), padring.toDBU(padring.m_dieHeight)) :
+            DEFWriter::open(m_outputs.m_def, padring.toDBU(padring.m_dieWidth), padring.toDBU(padring.m_dieHeight));
+        if (def == nullptr)
+        {
+            return failed("Cannot open DEF file for writing!\n");
+        }
+        def->setDatabaseUnits(m_lefreader.m_lefDatabaseUnits);
+        def->setDesignName(padring.m_designName);
+        sinks.push_back(new TimedSink(def, STAT_WRITE_DEF, STAT_DEF_BYTES, m_outputs.m_def, m_streams.m_def));
+    }
+
+    if (netlistChanged && wantOutput("verilog", m_outputs.m_verilog, m_streams.m_verilog))
+    {
+        VerilogWriter *ver = (m_streams.m_verilog != nullptr) ?
+            new VerilogWriter(*m_streams.m_verilog) :
+            VerilogWriter::open(m_outputs.m_verilog);
+        if (ver == nullptr)
+        {
+            return failed("Cannot open verilog file for writing!\n");
+        }
+        ver->setDesignName(padring.m_designName);
+        sinks.push_back(new TimedSink(ver, STAT_WRITE_VERILOG, STAT_VERILOG_BYTES, m_outputs.m_verilog, m_streams.m_verilog));
+    }
+
+    if (netlistChanged && wantOutput("csv", m_outputs.m_csv, m_streams.m_csv))
+    {
+        CSVWriter *csv = (m_streams.m_csv != nullptr) ?
+            new CSVWriter(*m_streams.m_csv, &padring) :
+            CSVWriter::open(m_outputs.m_csv, &padring);
+        if (csv == nullptr)
+        {
+            return failed("Cannot open csv file for writing!\n");
+        }
+        sinks.push_back(new TimedSink(csv, STAT_WRITE_CSV, STAT_CSV_BYTES, m_outputs.m_csv, m_streams.m_csv));
+    }
+
+    if (layoutChanged && wantOutput("GDS2", m_outputs.m_gds2, m_streams.m_gds2))
+    {
+        GDS2Writer *writer = (m_streams.m_gds2 != nullptr) ?
+            new GDS2Writer(*m_streams.m_gds2, padring.m_designName) :
+            GDS2Writer::open(m_outputs.m_gds2, padring.m_designName);
+        if (writer == nullptr)
+        {
+            return failed("Cannot open GDS2 file for writing!\n");
+        }
+        sinks.push_back(new TimedSink(writer, STAT_WRITE_GDS2, STAT_GDS2_BYTES, m_outputs.m_gds2, m_streams.m_gds2));
+    }
+
+    uint32_t cellCount = 0;
+    visitPlacedItems([&](const LayoutItem *item)
+    {
+        cellCount++;
+    });
+
+    for(auto sink : sinks)
+    {
+        sink->onBegin(cellCount, m_databaseUnits);
+    }
+
+    // resolve every cell once and hand the
+    // records to all the outputs in batches.
+    {
+        PlacementStream stream(m_databaseUnits, sinks);
+        visitPlacedItems([&](const LayoutItem *item)
+        {
+            stream.push(item);
+        });
+    }
+
+    // outputs that walk the cells again get 
+    // them resolved on the fly.
+    auto placedCells = [&](const OutputSink::cellVisitor_t &visit)
+    {
+        visitPlacedItems([&](const LayoutItem *item)
+        {
+            PlacedCell cell;
+            if (PlacementStream::resolve(item, m_databaseUnits, cell))
+            {
+                visit(cell);
+            }
+        });
+    };
+
+    for(auto sink : sinks)
+    {
+        sink->onFinish(placedCells);
+        delete sink;
+    }
+
+    m_writtenOutputs = static_cast<uint32_t>(sinks.size());
+    m_outputsValid = true;
+    return true;
+}
@@ -0,0 +1,167 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef padringsession_h
+#define padringsession_h
+
+#include <stdint.h>
+#include <string>
+#include <memory>
+#include <istream>
+#include <ostream>
+#include <functional>
+
+#include "prlefreader.h"
+#include "padringdb.h"
+#include "fillerhandler.h"
+#include "edgeplacer.h"
+#include "placement.h"
+
+/** output file names, empty if the output is not wanted */
+struct outputFiles_t
+{
+    std::string m_svg;
+    std::string m_def;
+    std::string m_verilog;
+    std::string m_csv;
+    std::string m_gds2;
+};
+
+/** output streams, nullptr if the output is not wanted.
+    An output with a stream is written to it instead of
+    to its file, for callers that keep the outputs in memory. */
+struct outputStreams_t
+{
+    std::ostream *m_svg     = nullptr;
+    std::ostream *m_def     = nullptr;
+    std::ostream *m_verilog = nullptr;
+    std::ostream *m_csv     = nullptr;
+    std::ostream *m_gds2    = nullptr;
+};
+
+/** Lays out padring configurations against a LEF database
+    and writes the outputs.
+
+    In incremental mode the session keeps the placement of
+    each edge. When a new configuration is loaded, only the
+    edges that changed are placed again and only the outputs
+    whose contents change are written.
+*/
+class PadringSession
+{
+public:
+    /** the LEF database must stay valid while the session
+        exists. threads is the number of worker threads for
+        the edge placement, 0 for one per core. */
+    PadringSession(PRLEFReader &lefreader, uint32_t threads);
+
+    virtual ~PadringSession();
+
+    /** set the outputs to write. All of them are written
+        by the next call to write(). */
+    void setOutputs(const outputFiles_t &outputs);
+
+    /** set the output streams. They must stay valid until
+        the last call to write(). */
+    void setOutputStreams(const outputStreams_t &streams);
+
+    /** keep the placement and output state for the next
+        configuration. */
+    void setIncremental(bool incremental)
+    {
+        m_incremental = incremental;
+    }
+
+    /** read a configuration. On failure, the previously 
+        loaded configuration is kept.
+        returns false if the configuration is not valid. */
+    bool load(std::istream &config);
+
+    /** read a configuration held in memory */
+    bool load(const char *data, size_t len);
+
+    /** read a configuration file by memory-mapping it */
+    bool loadFile(const std::string &filename);
+
+    /** lay out the edges of the loaded configuration and 
+        fill the spaces with filler cells.
+        returns false if a space cannot be filled. */
+    bool layout();
+
+    /** write the requested outputs.
+        returns false if an output cannot be opened. */
+    bool write();
+
+    /** visit the cells placed by the last layout() in
+        writing order. If the layout failed, the cells of
+        the edges are the ones placed so far. */
+    void visitPlacedCells(const std::function<void(const PlacedCell &cell)> &visit) const;
+
+    /** the loaded padring, or nullptr */
+    PadringDB* getPadring()
+    {
+        return m_padring.get();
+    }
+
+    /** number of edges placed by the last layout() */
+    uint32_t getPlacedEdgeCount() const
+    {
+        return m_placedEdges;
+    }
+
+    /** number of outputs written by the last write() */
+    uint32_t getWrittenOutputCount() const
+    {
+        return m_writtenOutputs;
+    }
+
+protected:
+    /** fingerprint of everything the placement of an edge
+        depends on. fillerState holds the filler declarations 
+        of the previous edges and is updated with the ones
+        of this edge. */
+    uint64_t getEdgeFingerprint(Layout *edge, dbu_t edgePos, uint64_t &fillerState) const;
+
+    /** visit the placed cells in writing order */
+    void visitPlacedItems(const std::function<void(const LayoutItem *item)> &visit) const;
+
+    PRLEFReader         &m_lefreader;
+    uint32_t            m_threads;
+    bool                m_incremental;
+    double              m_databaseUnits;    ///< database units per micron
+
+    std::unique_ptr<PadringDB>  m_padring;  ///< loaded configuration
+
+    std::unique_ptr<FillerHandler>  m_fillers;  ///< filler cells at the start of the padring
+    uint64_t            m_fillerFingerprint;    ///< filler cell names and grid of m_fillers
+
+    std::unique_ptr<EdgePlacer> m_placers[4];   ///< N, S, W, E, in writing order
+    uint64_t            m_edgeFingerprints[4];
+
+    outputFiles_t       m_outputs;
+    outputStreams_t     m_streams;
+    bool                m_outputsValid;         ///< the outputs hold the fingerprinted contents
+    uint64_t            m_layoutFingerprint;    ///< placed cells and positions
+    uint64_t            m_netlistFingerprint;   ///< placed cells without positions
+
+    uint32_t            m_placedEdges;
+    uint32_t            m_writtenOutputs;
+};
+
+#endif
@@ -0,0 +1,93 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef parallel_h
+#define parallel_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+
+/** return the number of worker threads to use when
+    the user did not ask for a specific number.
+*/
+inline uint32_t getDefaultThreadCount()
+{
+    uint32_t threads = std::thread::hardware_concurrency();
+    return (threads == 0) ? 1 : threads;
+}
+
+/** call func(index) for every index in [0, count) using
+    at most 'threads' worker threads. Indices are handed out
+    in increasing order; the function returns when all of
+    them have been processed.
+
+    With one thread, or a single item, everything runs on
+    the calling thread.
+*/
+inline void parallelFor(size_t count, uint32_t threads, const std::function<void(size_t)> &func)
+{
+    if (threads == 0)
+    {
+        threads = getDefaultThreadCount();
+    }
+
+    if (threads > count)
+    {
+        threads = static_cast<uint32_t>(count);
+    }
+
+    if (threads <= 1)
+    {
+        for(size_t i=0; i<count; i++)
+        {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        size_t index;
+        while((index = next.fetch_add(1)) < count)
+        {
+            func(index);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(uint32_t i=1; i<threads; i++)
+    {
+        pool.emplace_back(worker);
+    }
+
+    // the calling thread does its share of the work too.
+    worker();
+
+    for(auto &t : pool)
+    {
+        t.join();
+    }
+}
+
+#endif
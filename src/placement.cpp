@@ -0,0 +1,169 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include "logging.h"
+#include "outputsink.h"
+#include "placement.h"
+
+/** number of records handed to the outputs at a time */
+static const size_t gs_batchSize = 4096;
+
+static const char *gs_orientNames[ORIENT_COUNT] =
+{
+    "N", "S", "E", "W", "FN", "FS", "FE", "FW"
+};
+
+const char* toString(orient_t orient)
+{
+    return gs_orientNames[orient];
+}
+
+/** the cell dimensions to add to the lower-left corner
+    of a placed cell to get the cell origin. */
+struct originOffset_t
+{
+    bool m_xAddWidth;
+    bool m_xAddHeight;
+    bool m_yAddWidth;
+    bool m_yAddHeight;
+};
+
+/** origin offsets by orientation */
+static const originOffset_t gs_originOffsets[ORIENT_COUNT] =
+{
+    /* N  */ {false, false, false, false},
+    /* S  */ {true,  false, false, true },
+    /* E  */ {false, false, true,  false},
+    /* W  */ {false, true,  false, false},
+    /* FN */ {true,  false, false, false},
+    /* FS */ {false, false, false, true },
+    /* FE */ {false, true,  true,  false},
+    /* FW */ {false, false, false, false}
+};
+
+void PlacedCell::getOriginOffset(orient_t orient, dbu_t &dx, dbu_t &dy) const
+{
+    const originOffset_t &offset = gs_originOffsets[orient];
+    dx = (offset.m_xAddWidth  ? m_width  : 0) + (offset.m_xAddHeight ? m_height : 0);
+    dy = (offset.m_yAddWidth  ? m_width  : 0) + (offset.m_yAddHeight ? m_height : 0);
+}
+
+/** placement of a cell for a location: the cell dimensions
+    to subtract from the layout position to get the lower-left
+    corner and the orientation of unflipped and flipped cells. */
+struct locationPlacement_t
+{
+    bool     m_xSubHeight;
+    bool     m_ySubWidth;
+    bool     m_ySubHeight;
+    orient_t m_orient[2];
+};
+
+/** placements by location. Corner cells cannot be flipped. */
+static const locationPlacement_t gs_locationPlacements[LOC_COUNT] =
+{
+    /* N  */ {false, false, true,  {ORIENT_S, ORIENT_FS}},
+    /* S  */ {false, false, false, {ORIENT_N, ORIENT_FN}},
+    /* E  */ {true,  false, false, {ORIENT_W, ORIENT_FE}},
+    /* W  */ {false, false, false, {ORIENT_E, ORIENT_FW}},
+    /* NE */ {false, false, true,  {ORIENT_S, ORIENT_S}},
+    /* NW */ {false, true,  false, {ORIENT_E, ORIENT_E}},
+    /* SE */ {false, false, false, {ORIENT_W, ORIENT_W}},
+    /* SW */ {false, false, false, {ORIENT_N, ORIENT_N}},
+    /* -- */ {false, false, false, {ORIENT_N, ORIENT_N}}
+};
+
+bool PlacementStream::resolve(const LayoutItem *item, double databaseUnits, PlacedCell &cell)
+{
+    if ((item == nullptr) || (item->m_lefinfo == nullptr) || (item->m_location == LOC_NONE))
+    {
+        return false;
+    }
+
+    cell.m_cellname = item->m_cellname;
+    cell.m_instance = item->m_instance;
+    cell.m_lefinfo  = item->m_lefinfo;
+    cell.m_ltype    = item->m_ltype;
+    cell.m_flipped  = item->m_flipped;
+    cell.m_width    = toDBU(item->m_lefinfo->m_sx, databaseUnits);
+    cell.m_height   = toDBU(item->m_lefinfo->m_sy, databaseUnits);
+
+    const locationPlacement_t &placement = gs_locationPlacements[item->m_location];
+    cell.m_orient = placement.m_orient[item->m_flipped ? 1 : 0];
+    cell.m_x = item->m_x;
+    cell.m_y = item->m_y;
+    if (placement.m_xSubHeight)
+    {
+        cell.m_x -= cell.m_height;
+    }
+    if (placement.m_ySubWidth)
+    {
+        cell.m_y -= cell.m_width;
+    }
+    if (placement.m_ySubHeight)
+    {
+        cell.m_y -= cell.m_height;
+    }
+    return true;
+}
+
+PlacementStream::PlacementStream(double databaseUnits, const std::vector<OutputSink*> &sinks)
+    : m_databaseUnits(databaseUnits),
+      m_sinks(sinks)
+{
+    m_batch.reserve(gs_batchSize);
+}
+
+PlacementStream::~PlacementStream()
+{
+    flush();
+}
+
+void PlacementStream::push(const LayoutItem *item)
+{
+    PlacedCell cell;
+    if (!resolve(item, m_databaseUnits, cell))
+    {
+        if (item != nullptr)
+        {
+            doLog(LOG_WARN, "Cannot place cell %s\n", std::string(item->getCellName()).c_str());
+        }
+        return;
+    }
+
+    m_batch.push_back(cell);
+    if (m_batch.size() >= gs_batchSize)
+    {
+        flush();
+    }
+}
+
+void PlacementStream::flush()
+{
+    if (m_batch.empty())
+    {
+        return;
+    }
+
+    for(auto sink : m_sinks)
+    {
+        sink->onCells(m_batch.data(), m_batch.size());
+    }
+    m_batch.clear();
+}
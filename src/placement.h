@@ -0,0 +1,125 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef placement_h
+#define placement_h
+
+#include <stdint.h>
+#include <vector>
+
+#include "layout.h"
+
+class OutputSink;
+
+/** orientation of a placed cell, named as in DEF.
+    The flipped orientations are mirrored before rotation. */
+enum orient_t
+{
+    ORIENT_N,       ///< no rotation
+    ORIENT_S,       ///< rotated by 180 degrees
+    ORIENT_E,       ///< rotated by 270 degrees
+    ORIENT_W,       ///< rotated by 90 degrees
+    ORIENT_FN,      ///< mirrored around the y axis
+    ORIENT_FS,      ///< mirrored around the x axis
+    ORIENT_FE,      ///< mirrored around the x axis, rotated by 270 degrees
+    ORIENT_FW,      ///< mirrored around the x axis, rotated by 90 degrees
+    ORIENT_COUNT    ///< number of orientations, for lookup tables
+};
+
+/** DEF name of an orientation */
+const char* toString(orient_t orient);
+
+/** A cell on the padring, placed in integer database units.
+    Each layout item is resolved into a PlacedCell once and
+    all outputs work from the same record.
+*/
+struct PlacedCell
+{
+    symbol_t    m_cellname;     ///< cell name
+    symbol_t    m_instance;     ///< instance name, empty for fillers
+    const PRLEFReader::LEFCellInfo_t *m_lefinfo;    ///< LEF info of the cell
+    LayoutItem::LayoutItemType m_ltype;             ///< type of the layout item
+    orient_t    m_orient;       ///< orientation of the cell
+    bool        m_flipped;      ///< FLIP was given for the cell
+    dbu_t       m_x;            ///< x-position of the lower-left corner of the placed cell
+    dbu_t       m_y;            ///< y-position of the lower-left corner of the placed cell
+    dbu_t       m_width;        ///< width of the unrotated cell
+    dbu_t       m_height;       ///< height of the unrotated cell
+
+    /** cell name, zero-terminated */
+    std::string_view getCellName() const
+    {
+        return symbolName(m_cellname);
+    }
+
+    /** instance name, zero-terminated */
+    std::string_view getInstanceName() const
+    {
+        return symbolName(m_instance);
+    }
+
+    /** offset of the cell origin from the lower-left
+        corner of the placed cell */
+    void getOriginOffset(dbu_t &dx, dbu_t &dy) const
+    {
+        getOriginOffset(m_orient, dx, dy);
+    }
+
+    /** offset of the cell origin from the lower-left corner
+        of the cell when placed in another orientation */
+    void getOriginOffset(orient_t orient, dbu_t &dx, dbu_t &dy) const;
+};
+
+/** Resolves the placed layout items into PlacedCell records
+    and hands them to the outputs in batches.
+*/
+class PlacementStream
+{
+public:
+    /** databaseUnits is the number of database units per micron
+        of the layout */
+    PlacementStream(double databaseUnits, const std::vector<OutputSink*> &sinks);
+
+    /** flushes the pending records */
+    ~PlacementStream();
+
+    /** resolve a placed layout item into a record. The item
+        position is in database units already, databaseUnits
+        is used to convert the LEF cell size.
+        returns false if the item cannot be placed. */
+    static bool resolve(const LayoutItem *item, double databaseUnits, PlacedCell &cell);
+
+    /** add a placed layout item to the stream */
+    void push(const LayoutItem *item);
+
+    /** hand the pending records to the outputs */
+    void flush();
+
+    double getDatabaseUnits() const
+    {
+        return m_databaseUnits;
+    }
+
+protected:
+    double                      m_databaseUnits;    ///< database units per micron
+    std::vector<OutputSink*>    m_sinks;            ///< outputs
+    std::vector<PlacedCell>     m_batch;            ///< records not yet handed out
+};
+
+#endif
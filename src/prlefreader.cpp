@@ -18,20 +18,37 @@
     
 */
 
+#include <memory>
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
 #include "prlefreader.h"
+#include "lefcache.h"
+#include "parallel.h"
 #include "logging.h"
+#include "stats.h"
 
-PRLEFReader::PRLEFReader() : m_parseCell(nullptr)
+PRLEFReader::PRLEFReader() : m_parseCell(nullptr), m_parsePinIndex(0)
 {
     m_lefDatabaseUnits = 0.0f;
 }
 
+PRLEFReader::~PRLEFReader()
+{
+    for(auto cache : m_caches)
+    {
+        delete cache;
+    }
+}
+
 void PRLEFReader::onMacro(const std::string &macroName)
 {
+    Stats::count(STAT_LEF_MACROS);
+
     // perform integrity checks on the previous cell
     if (m_parseCell != nullptr)
     {
-        doIntegrityChecks();
+        finishCell();
     }
 
     // note: unordered_map::insert will only insert the element
@@ -42,27 +59,368 @@ void PRLEFReader::onMacro(const std::string &macroName)
     auto iter = m_cells.find(macroName);
     if (iter != m_cells.end())
     {
-        doLog(LOG_WARN,"Cell %s already in database - replaced\n", macroName.c_str());
+        doLog(LOG_WARN,"Cell %s already in database - replaced\n", std::string(macroName).c_str());
         m_parseCell = iter->second;
+        m_parsePins.assign(m_parseCell->m_pins.begin(), m_parseCell->m_pins.end());
     }
     else
     {
-        m_parseCell = new LEFCellInfo_t();
-        m_parseCell->m_name = macroName;
-        m_cells.insert(std::make_pair(macroName, m_parseCell));
+        m_parseCell = createCell(macroName);
+        m_cells.insert(std::make_pair(m_parseCell->m_name, m_parseCell));
 
         doLog(LOG_VERBOSE,"Added LEF cell %s\n", macroName.c_str());
     }
 }
 
-PRLEFReader::LEFCellInfo_t *PRLEFReader::getCellByName(const std::string &macroName) const
+void PRLEFReader::onEndParse()
 {
-    auto iter = m_cells.find(macroName);
-    if (iter == m_cells.end())
+    // the last macro in a file has no successor
+    // to trigger its integrity checks.
+    if (m_parseCell != nullptr)
+    {
+        finishCell();
+    }
+    m_parseCell = nullptr;
+}
+
+void PRLEFReader::finishCell()
+{
+    doIntegrityChecks();
+
+    // the number of pins is only known now, so they
+    // are collected in m_parsePins and copied once.
+    setCellPins(m_parseCell, m_parsePins);
+    m_parsePins.clear();
+    m_parsePinIndex = 0;
+}
+
+PRLEFReader::LEFCellInfo_t *PRLEFReader::createCell(const std::string_view &name)
+{
+    LEFCellInfo_t *cell = m_arena.create<LEFCellInfo_t>();
+    cell->m_name = intern(name);
+    return cell;
+}
+
+void PRLEFReader::setCellPins(LEFCellInfo_t *cell, const std::vector<LEFPinInfo_t> &pins)
+{
+    LEFPinInfo_t *cellPins = m_arena.createArray<LEFPinInfo_t>(pins.size());
+    std::copy(pins.begin(), pins.end(), cellPins);
+    cell->m_pins = ArenaArray<const LEFPinInfo_t>(cellPins, pins.size());
+}
+
+std::string_view PRLEFReader::intern(const std::string_view &str)
+{
+    auto iter = m_names.find(str);
+    if (iter != m_names.end())
+    {
+        return *iter;
+    }
+
+    std::string_view name = m_arena.copyString(str);
+    m_names.insert(name);
+    return name;
+}
+
+bool PRLEFReader::isMacroWanted(const std::string_view &macroName,
+    const std::string_view &className)
+{
+    // filler cells are found by class, so keep them all.
+    if (className.find("SPACER") != std::string_view::npos)
+    {
+        return true;
+    }
+    return m_macroFilter.find(macroName) != m_macroFilter.end();
+}
+
+void PRLEFReader::setMacroFilter(const std::unordered_set<std::string> &cellNames)
+{
+    m_macroFilter.clear();
+    for(auto const &name : cellNames)
+    {
+        m_macroFilter.insert(intern(name));
+    }
+    setMacroSkipping(true);
+}
+
+void PRLEFReader::setMacroFilter(const std::unordered_set<std::string_view> &cellNames)
+{
+    m_macroFilter.clear();
+    for(auto const &name : cellNames)
+    {
+        m_macroFilter.insert(intern(name));
+    }
+    setMacroSkipping(true);
+}
+
+bool PRLEFReader::parseFiles(const std::vector<std::string> &filenames, uint32_t threads)
+{
+    if (!m_cacheDir.empty())
+    {
+        if (parseFilesCached(filenames, threads))
+        {
+            return true;
+        }
+        doLog(LOG_WARN, "LEF cache not usable - reading LEF files directly\n");
+    }
+
+    // each file gets its own reader so the workers
+    // don't share any state.
+    std::vector<std::unique_ptr<PRLEFReader> > shards;
+    std::vector<char> ok(filenames.size(), 0);
+
+    for(auto const &filename : filenames)
+    {
+        doLog(LOG_INFO, "Reading LEF %s\n", filename.c_str());
+        shards.emplace_back(new PRLEFReader());
+        if (m_skipMacros)
+        {
+            shards.back()->setMacroFilter(m_macroFilter);
+        }
+    }
+
+    parallelFor(filenames.size(), threads, [&](size_t index)
+    {
+        ok[index] = shards[index]->parseFile(filenames[index]) ? 1 : 0;
+    });
+
+    // merge in command line order so later
+    // files override earlier ones.
+    bool result = true;
+    for(size_t i=0; i<shards.size(); i++)
+    {
+        if (!ok[i])
+        {
+            result = false;
+        }
+        merge(*shards[i]);
+    }
+
+    return result;
+}
+
+void PRLEFReader::merge(PRLEFReader &other)
+{
+    // the cells stay where they are,
+    // we just take over the memory.
+    m_arena.adopt(other.m_arena);
+    for(auto const &name : other.m_names)
+    {
+        m_names.insert(name);
+    }
+    other.m_names.clear();
+
+    // nothing to replace: take over the whole database.
+    if (m_cells.empty())
+    {
+        m_cells.swap(other.m_cells);
+    }
+
+    for(auto const &cell : other.m_cells)
+    {
+        auto iter = m_cells.find(cell.first);
+        if (iter != m_cells.end())
+        {
+            doLog(LOG_WARN,"Cell %s already in database - replaced\n", std::string(cell.first).c_str());
+            iter->second = cell.second;
+        }
+        else
+        {
+            m_cells.insert(cell);
+        }
+    }
+    other.m_cells.clear();
+
+    m_skippedMacros += other.m_skippedMacros;
+    other.m_skippedMacros = 0;
+
+    if (other.m_lefDatabaseUnits > 0.0)
+    {
+        m_lefDatabaseUnits = other.m_lefDatabaseUnits;
+    }
+}
+
+bool PRLEFReader::parseFilesCached(const std::vector<std::string> &filenames, uint32_t threads)
+{
+    std::vector<std::unique_ptr<LEFCache> > caches(filenames.size());
+
+    for(auto const &filename : filenames)
+    {
+        doLog(LOG_INFO, "Reading LEF %s\n", filename.c_str());
+    }
+
+    parallelFor(filenames.size(), threads, [&](size_t index)
+    {
+        LEFCache::Key key;
+        if (!LEFCache::computeKey(filenames[index], key))
+        {
+            doLog(LOG_ERROR, "Cannot read LEF file %s\n", filenames[index].c_str());
+            return;
+        }
+
+        std::string cacheFilename = LEFCache::getCacheFilename(m_cacheDir, key);
+        std::unique_ptr<LEFCache> cache(new LEFCache());
+        if (cache->open(cacheFilename, key))
+        {
+            doLog(LOG_VERBOSE, "Using LEF cache %s\n", cacheFilename.c_str());
+            caches[index] = std::move(cache);
+            return;
+        }
+
+        // missing or stale: parse the LEF file and rebuild the cache
+        PRLEFReader reader;
+        if (!reader.parseFile(filenames[index]))
+        {
+            return;
+        }
+
+        if (!LEFCache::write(cacheFilename, key, reader) || !cache->open(cacheFilename, key))
+        {
+            return;
+        }
+
+        doLog(LOG_VERBOSE, "Created LEF cache %s\n", cacheFilename.c_str());
+        caches[index] = std::move(cache);
+    });
+
+    for(auto const &cache : caches)
+    {
+        if (!cache)
+        {
+            return false;
+        }
+    }
+
+    for(auto &cache : caches)
+    {
+        if (cache->getDatabaseUnits() > 0.0)
+        {
+            m_lefDatabaseUnits = cache->getDatabaseUnits();
+        }
+        m_caches.push_back(cache.release());
+    }
+
+    return true;
+}
+
+size_t PRLEFReader::getCellCount() const
+{
+    if (m_caches.empty())
+    {
+        return m_cells.size();
+    }
+
+    if (m_caches.size() == 1)
+    {
+        return m_caches.front()->getCellCount();
+    }
+
+    // cells can be defined in more than one file
+    std::unordered_set<std::string_view> names;
+    for(auto cache : m_caches)
+    {
+        for(uint32_t i=0; i<cache->getCellCount(); i++)
+        {
+            names.insert(cache->getCellName(i));
+        }
+    }
+    return names.size();
+}
+
+PRLEFReader::LEFCellInfo_t *PRLEFReader::getCellByName(const std::string_view &macroName)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_cellMutex);
+        auto iter = m_cells.find(macroName);
+        if (iter != m_cells.end())
+        {
+            return iter->second;
+        }
+    }
+
+    if (m_caches.empty())
     {
         return nullptr;
     }
-    return iter->second;
+
+    // loading adds to the arena and the cell map.
+    // another thread may have loaded the cell meanwhile.
+    std::unique_lock<std::shared_mutex> lock(m_cellMutex);
+    auto iter = m_cells.find(macroName);
+    if (iter != m_cells.end())
+    {
+        return iter->second;
+    }
+
+    // search the caches, last file first, as later
+    // files override cells in earlier ones.
+    for(size_t i=m_caches.size(); i>0; i--)
+    {
+        int32_t cellIndex = m_caches[i-1]->findCell(macroName);
+        if (cellIndex < 0)
+        {
+            continue;
+        }
+
+        for(size_t j=0; j<(i-1); j++)
+        {
+            if (m_caches[j]->findCell(macroName) >= 0)
+            {
+                doLog(LOG_WARN,"Cell %s already in database - replaced\n", std::string(macroName).c_str());
+                break;
+            }
+        }
+
+        LEFCellInfo_t *cell = m_caches[i-1]->loadCell(cellIndex, *this);
+        m_cells.insert(std::make_pair(cell->m_name, cell));
+        return cell;
+    }
+
+    return nullptr;
+}
+
+void PRLEFReader::getFillerCells(std::vector<LEFCellInfo_t*> &fillers)
+{
+    fillers.clear();
+
+    if (m_caches.empty())
+    {
+        std::shared_lock<std::shared_mutex> lock(m_cellMutex);
+        for(auto const &cell : m_cells)
+        {
+            if (cell.second->m_isFiller)
+            {
+                fillers.push_back(cell.second);
+            }
+        }
+        return;
+    }
+
+    // only load the cells flagged as filler in the caches.
+    // a filler may be overridden by a non-filler cell in a
+    // later file, so check the cell that is actually used.
+    std::unordered_set<std::string_view> seen;
+    for(auto cache : m_caches)
+    {
+        for(uint32_t i=0; i<cache->getCellCount(); i++)
+        {
+            if (!cache->isFiller(i))
+            {
+                continue;
+            }
+
+            std::string_view name = cache->getCellName(i);
+            if (!seen.insert(name).second)
+            {
+                continue;
+            }
+
+            LEFCellInfo_t *cell = getCellByName(name);
+            if ((cell != nullptr) && cell->m_isFiller)
+            {
+                fillers.push_back(cell);
+            }
+        }
+    }
 }
 
 void PRLEFReader::onSize(double sx, double sy)
@@ -85,7 +443,7 @@ void PRLEFReader::onForeign(const std::string &foreignName, double ox, double oy
         return;
     }
 
-    m_parseCell->m_foreign = foreignName;
+    m_parseCell->m_foreign = intern(foreignName);
 }
 
 void PRLEFReader::onSymmetry(const std::string &symmetry)
@@ -96,7 +454,7 @@ void PRLEFReader::onSymmetry(const std::string &symmetry)
         return;
     }
 
-    m_parseCell->m_symmetry = symmetry;
+    m_parseCell->m_symmetry = intern(symmetry);
 }
 
 void PRLEFReader::doIntegrityChecks()
@@ -122,7 +480,7 @@ void PRLEFReader::doIntegrityChecks()
     if ((m_parseCell->m_sx == 0.0) || (m_parseCell->m_sy == 0.0))
     {
         doLog(LOG_ERROR,"PRLEFReader: cell %s has zero width or height\n",
-            m_parseCell->m_name.c_str());
+            m_parseCell->m_name.data());
     }
 }
 
@@ -145,52 +503,52 @@ void PRLEFReader::onDatabaseUnitsMicrons(double unitsPerMicron)
 }
 
 void PRLEFReader::onPin(const std::string &pinName) {
-    auto iter = m_parseCell->m_pins.find(pinName);
-    if (iter != m_parseCell->m_pins.end())
+    for(size_t i=0; i<m_parsePins.size(); i++)
     {
-        doLog(LOG_WARN,"Pin %s already in database - replaced\n", pinName.c_str());
-        m_parsePin = iter->second;
+        if (m_parsePins[i].m_name == pinName)
+        {
+            doLog(LOG_WARN,"Pin %s already in database - replaced\n", pinName.c_str());
+            m_parsePinIndex = i;
+            return;
+        }
     }
-    else
-    {
-        m_parsePin = new LEFPinInfo_t();
-        m_parseCell->m_name = pinName;
-        m_parseCell->m_pins.insert(std::make_pair(pinName, m_parsePin));
 
-        doLog(LOG_VERBOSE,"Added LEF pin %s\n", pinName.c_str());
-    }
+    m_parsePins.emplace_back();
+    m_parsePins.back().m_name = intern(pinName);
+    m_parsePinIndex = m_parsePins.size()-1;
+
+    doLog(LOG_VERBOSE,"Added LEF pin %s\n", pinName.c_str());
 }
 
 void PRLEFReader::onPinDirection(const std::string &direction) {
     if (direction.find("INPUT") != std::string::npos){
-        m_parsePin->m_dir = 0;
+        getParsePin().m_dir = 0;
     }
     else if (direction.find("OUTPUT") != std::string::npos){
-        m_parsePin->m_dir = 1;
+        getParsePin().m_dir = 1;
     }
     else{
-        m_parsePin->m_dir = 2;
+        getParsePin().m_dir = 2;
     }
 }
 
 void PRLEFReader::onPinUse(const std::string &use) {
     if (use.find("SIGNAL") != std::string::npos){
-        m_parsePin->m_use = 0;
+        getParsePin().m_use = 0;
     }
     else if (use.find("POWER") != std::string::npos){
-        m_parsePin->m_use = 1;
+        getParsePin().m_use = 1;
     }
     else if (use.find("GROUND") != std::string::npos){
-        m_parsePin->m_use = 2;
+        getParsePin().m_use = 2;
     }
     else{
-        m_parsePin->m_use = 0;
+        getParsePin().m_use = 0;
     }
 }
 
 void PRLEFReader::onPinLayerClass(const std::string &className) {
     if (className.find("CORE") != std::string::npos){
-        m_parsePin->m_class = 1;
+        getParsePin().m_class = 1;
     }
 }
-
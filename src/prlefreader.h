@@ -22,15 +22,28 @@
 #define prlefreader_h
 
 #include <string>
+#include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+#include <shared_mutex>
 
 #include "lef/lefreader.h"
+#include "arena.h"
 
-/** LEF Reader + cell database */
+class LEFCache;
+
+/** LEF Reader + cell database
+
+    Once the LEF files have been parsed, the cell database
+    can be shared by several threads: getCellByName and 
+    getFillerCells may be called concurrently.
+*/
 class PRLEFReader : public LEFReader
 {
 public:
     PRLEFReader();
+    virtual ~PRLEFReader();
 
     /** callback for each LEF macro */
     virtual void onMacro(const std::string &macroName) override;
@@ -63,39 +76,134 @@ public:
     /** callback for PIN PORT CLASS use */
     virtual void onPinLayerClass(const std::string &className) override;
 
+    /** callback when done parsing */
+    virtual void onEndParse() override;
+
+    /** decide whether to parse a macro when a filter is set */
+    virtual bool isMacroWanted(const std::string_view &macroName,
+        const std::string_view &className) override;
+
+    /** only parse the named macros and filler (SPACER) macros.
+        All other macro bodies are skipped.
+    */
+    void setMacroFilter(const std::unordered_set<std::string> &cellNames);
+
+    /** the same, for names held elsewhere. */
+    void setMacroFilter(const std::unordered_set<std::string_view> &cellNames);
+
     void doIntegrityChecks();
+
+    /** parse a number of LEF files concurrently, each into its
+        own cell database, and merge the results in file order.
+        Cells defined in more than one file are replaced by the
+        last definition, as if the files were read one by one.
+
+        threads = 0 uses one thread per available core.
+        returns false if one or more files could not be read.
+    */
+    bool parseFiles(const std::vector<std::string> &filenames, uint32_t threads = 0);
+
+    /** move all cells from another reader into this one.
+        Existing cells are replaced with a warning.
+    */
+    void merge(PRLEFReader &other);
+
+    /** enable the precompiled cell cache. parseFiles will
+        use the cache files in this directory, creating or
+        refreshing them when a LEF file has changed.
+        Cells are then only loaded when they are looked up.
+    */
+    void setCacheDirectory(const std::string &cacheDir)
+    {
+        m_cacheDir = cacheDir;
+    }
+
+    /** number of cells in the database, including
+        cells that have not been loaded from the cache yet.
+    */
+    size_t getCellCount() const;
     
     class LEFPinInfo_t
     {
     public:
         LEFPinInfo_t() : m_dir(0), m_class(0), m_use(0) {}
 
+        std::string_view m_name;    ///< pin name
         int             m_dir;      ///< direction (0: in, 1: out, 2:inout)
         int             m_class;    ///< class (0: none, 1: core)
         int             m_use;      ///< usage (0: signal, 1: power, 2: ground)
     };
 
+    /** cell information. Cells, their pins and all the
+        names live in the reader's arena; the names are
+        interned and zero terminated.
+    */
     class LEFCellInfo_t
     {
     public:
-        LEFCellInfo_t() : m_sx(0.0), m_sy(0.0) {}
+        LEFCellInfo_t() : m_sx(0.0), m_sy(0.0), m_isFiller(false) {}
 
-        std::string     m_name;     ///< LEF cell name
-        std::string     m_foreign;  ///< foreign name
+        std::string_view m_name;     ///< LEF cell name
+        std::string_view m_foreign;  ///< foreign name
         double          m_sx;       ///< size in microns
         double          m_sy;       ///< size in microns
-        std::string     m_symmetry; ///< symmetry string taken from LEF.
+        std::string_view m_symmetry; ///< symmetry string taken from LEF.
         bool            m_isFiller; ///< whenever this cell is a filler.
-        std::unordered_map<std::string, LEFPinInfo_t*> m_pins;       
+        ArenaArray<const LEFPinInfo_t> m_pins;  ///< pins in LEF order
     };
 
-    LEFCellInfo_t *getCellByName(const std::string &name) const;
+    /** find a cell, loading it from the cache if needed.
+        returns nullptr if the cell does not exist.
+        Thread-safe after parsing.
+    */
+    LEFCellInfo_t *getCellByName(const std::string_view &name);
+
+    /** get all the filler cells in the database */
+    void getFillerCells(std::vector<LEFCellInfo_t*> &fillers);
+
+    /** create an empty cell in the arena.
+        The cell is not added to the database.
+    */
+    LEFCellInfo_t *createCell(const std::string_view &name);
+
+    /** copy pins into the arena and assign them to a cell */
+    void setCellPins(LEFCellInfo_t *cell, const std::vector<LEFPinInfo_t> &pins);
+
+    /** return the interned copy of a string */
+    std::string_view intern(const std::string_view &str);
+
     LEFCellInfo_t *m_parseCell;   ///< current cell being parsed
-    LEFPinInfo_t  *m_parsePin;   ///< current pin being parsed
     
-    std::unordered_map<std::string, LEFCellInfo_t*> m_cells;
+    std::unordered_map<std::string_view, LEFCellInfo_t*> m_cells;
 
     double m_lefDatabaseUnits;      ///< database units in microns
+
+protected:
+    /** open or build a cache for every file.
+        returns false if one of the caches is not usable.
+    */
+    bool parseFilesCached(const std::vector<std::string> &filenames, uint32_t threads);
+
+    /** check the cell being parsed and store its pins */
+    void finishCell();
+
+    /** pin currently being parsed */
+    LEFPinInfo_t& getParsePin()
+    {
+        return m_parsePins[m_parsePinIndex];
+    }
+
+    Arena                           m_arena;    ///< storage for cells, pins and names
+    std::unordered_set<std::string_view> m_names; ///< interned names
+
+    std::vector<LEFPinInfo_t>       m_parsePins;        ///< pins of the cell being parsed
+    size_t                          m_parsePinIndex;    ///< pin being parsed
+
+    std::unordered_set<std::string_view> m_macroFilter; ///< interned names of the macros to parse when skipping is enabled
+    std::string             m_cacheDir; ///< cache directory, empty when disabled
+    std::vector<LEFCache*>  m_caches;   ///< caches in file order
+
+    std::shared_mutex       m_cellMutex;    ///< guards loading cells from the caches
 };
 
 #endif
@@ -0,0 +1,133 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <atomic>
+#include <iomanip>
+#include "stats.h"
+
+/** calls and accumulated time of a phase */
+struct statTimerValue_t
+{
+    std::atomic<uint64_t> m_calls;
+    std::atomic<uint64_t> m_nanoseconds;
+};
+
+static statTimerValue_t      gs_timers[STAT_TIMER_COUNT];
+static std::atomic<uint64_t> gs_counters[STAT_COUNTER_COUNT];
+
+/** names of the timers, as written to the outputs */
+static const char *gs_timerNames[STAT_TIMER_COUNT] =
+{
+    "lef_parse",
+    "config_parse",
+    "layout",
+    "fillers",
+    "write_svg",
+    "write_def",
+    "write_verilog",
+    "write_csv",
+    "write_gds2"
+};
+
+/** names of the counters, as written to the outputs */
+static const char *gs_counterNames[STAT_COUNTER_COUNT] =
+{
+    "lef_bytes",
+    "lef_macros",
+    "lef_cached_cells",
+    "config_lines",
+    "items_placed",
+    "fillers_emitted",
+    "svg_bytes",
+    "def_bytes",
+    "verilog_bytes",
+    "csv_bytes",
+    "gds2_bytes"
+};
+
+void Stats::addTime(statTimer_t timer, uint64_t nanoseconds)
+{
+    gs_timers[timer].m_calls.fetch_add(1, std::memory_order_relaxed);
+    gs_timers[timer].m_nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void Stats::count(statCounter_t counter, uint64_t value)
+{
+    gs_counters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+static double toMilliseconds(uint64_t nanoseconds)
+{
+    return static_cast<double>(nanoseconds) / 1.0e6;
+}
+
+void Stats::writeText(std::ostream &os)
+{
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+
+    os << "Statistics:\n";
+    os << "  " << std::left << std::setw(20) << "phase" << std::right 
+       << std::setw(10) << "calls" << std::setw(14) << "time (ms)" << "\n";
+    for(uint32_t i=0; i<STAT_TIMER_COUNT; i++)
+    {
+        os << "  " << std::left << std::setw(20) << gs_timerNames[i] << std::right
+           << std::setw(10) << gs_timers[i].m_calls.load(std::memory_order_relaxed)
+           << std::setw(14) << std::fixed << std::setprecision(3) 
+           << toMilliseconds(gs_timers[i].m_nanoseconds.load(std::memory_order_relaxed)) << "\n";
+    }
+
+    os << "  " << std::left << std::setw(20) << "counter" << std::right 
+       << std::setw(24) << "value" << "\n";
+    for(uint32_t i=0; i<STAT_COUNTER_COUNT; i++)
+    {
+        os << "  " << std::left << std::setw(20) << gs_counterNames[i] << std::right
+           << std::setw(24) << gs_counters[i].load(std::memory_order_relaxed) << "\n";
+    }
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void Stats::writeJSON(std::ostream &os)
+{
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+
+    os << "{\n  \"timers\": {\n";
+    for(uint32_t i=0; i<STAT_TIMER_COUNT; i++)
+    {
+        os << "    \"" << gs_timerNames[i] << "\": { \"calls\": " 
+           << gs_timers[i].m_calls.load(std::memory_order_relaxed)
+           << ", \"ms\": " << std::fixed << std::setprecision(3) 
+           << toMilliseconds(gs_timers[i].m_nanoseconds.load(std::memory_order_relaxed)) << " }"
+           << ((i+1 < STAT_TIMER_COUNT) ? ",\n" : "\n");
+    }
+    os << "  },\n  \"counters\": {\n";
+    for(uint32_t i=0; i<STAT_COUNTER_COUNT; i++)
+    {
+        os << "    \"" << gs_counterNames[i] << "\": " 
+           << gs_counters[i].load(std::memory_order_relaxed)
+           << ((i+1 < STAT_COUNTER_COUNT) ? ",\n" : "\n");
+    }
+    os << "  }\n}\n";
+
+    os.flags(flags);
+    os.precision(precision);
+}
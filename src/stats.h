@@ -0,0 +1,104 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef stats_h
+#define stats_h
+
+#include <stdint.h>
+#include <chrono>
+#include <ostream>
+
+/** timed phases of a run */
+enum statTimer_t
+{
+    STAT_LEF_PARSE,         ///< parsing LEF files
+    STAT_CONFIG_PARSE,      ///< parsing configuration files
+    STAT_LAYOUT,            ///< laying out the edges
+    STAT_FILLERS,           ///< filling the spaces with filler cells
+    STAT_WRITE_SVG,
+    STAT_WRITE_DEF,
+    STAT_WRITE_VERILOG,
+    STAT_WRITE_CSV,
+    STAT_WRITE_GDS2,
+    STAT_TIMER_COUNT
+};
+
+/** counted quantities of a run */
+enum statCounter_t
+{
+    STAT_LEF_BYTES,         ///< LEF text parsed
+    STAT_LEF_MACROS,        ///< LEF macros parsed
+    STAT_LEF_CACHED_CELLS,  ///< cells loaded from the LEF cache
+    STAT_CONFIG_LINES,      ///< configuration lines parsed
+    STAT_ITEMS_PLACED,      ///< pads and bond pads placed
+    STAT_FILLERS_EMITTED,   ///< filler cells placed
+    STAT_SVG_BYTES,
+    STAT_DEF_BYTES,
+    STAT_VERILOG_BYTES,
+    STAT_CSV_BYTES,
+    STAT_GDS2_BYTES,
+    STAT_COUNTER_COUNT
+};
+
+/** Process-wide timers and counters.
+
+    Updating them is a relaxed atomic add, so they are
+    always collected and can be updated from any thread.
+    Phases that run on several threads at once add up
+    the time of each thread.
+*/
+class Stats
+{
+public:
+    /** add the duration of one call of a phase */
+    static void addTime(statTimer_t timer, uint64_t nanoseconds);
+
+    /** add to a counter */
+    static void count(statCounter_t counter, uint64_t value = 1);
+
+    /** write a table of the timers and counters */
+    static void writeText(std::ostream &os);
+
+    /** write the timers and counters as a JSON object */
+    static void writeJSON(std::ostream &os);
+};
+
+/** adds the time between its construction and
+    destruction to a phase timer. */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(statTimer_t timer) 
+        : m_timer(timer), m_start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer()
+    {
+        auto duration = std::chrono::steady_clock::now() - m_start;
+        Stats::addTime(m_timer, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer& operator=(const ScopedTimer &) = delete;
+
+protected:
+    statTimer_t m_timer;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef strutils_h
+#define strutils_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <string_view>
+
+// <charconv> arrived in GCC 8, older standard
+// libraries use the C library conversions instead.
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#define PADRING_HAVE_CHARCONV 1
+#endif
+#endif
+
+/** convert a number token to a double without allocating.
+    returns false if the token is not a complete, valid number.
+*/
+inline bool stringToDouble(const std::string_view &str, double &value)
+{
+#if defined(PADRING_HAVE_CHARCONV) && defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L)
+    auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+    return (result.ec == std::errc()) && (result.ptr == str.data() + str.size());
+#else
+    // from_chars for floating point is not available
+    // on older standard libraries, so fall back to strtod
+    // on a zero-terminated copy.
+    char buffer[64];
+    if (str.empty() || (str.size() >= sizeof(buffer)))
+    {
+        return false;
+    }
+    memcpy(buffer, str.data(), str.size());
+    buffer[str.size()] = 0;
+
+    char *endptr = nullptr;
+    value = strtod(buffer, &endptr);
+    return (endptr == buffer + str.size());
+#endif
+}
+
+/** convert a whole number token to an int64_t without allocating.
+    returns false if the token is not a complete, valid number.
+*/
+inline bool stringToInt64(const std::string_view &str, int64_t &value)
+{
+#ifdef PADRING_HAVE_CHARCONV
+    auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+    return (result.ec == std::errc()) && (result.ptr == str.data() + str.size());
+#else
+    // strtoll also takes leading white space and '+',
+    // which from_chars does not.
+    char buffer[32];
+    if (str.empty() || (str.size() >= sizeof(buffer)) ||
+        ((str[0] != '-') && ((str[0] < '0') || (str[0] > '9'))))
+    {
+        return false;
+    }
+    memcpy(buffer, str.data(), str.size());
+    buffer[str.size()] = 0;
+
+    char *endptr = nullptr;
+    errno = 0;
+    long long result = strtoll(buffer, &endptr, 10);
+    if ((errno != 0) || (endptr != buffer + str.size()))
+    {
+        return false;
+    }
+    value = static_cast<int64_t>(result);
+    return true;
+#endif
+}
+
+/** write a whole number into a buffer of at least 24 characters,
+    without a terminating zero. returns the number of characters.
+*/
+inline size_t int64ToString(int64_t value, char *buffer)
+{
+#ifdef PADRING_HAVE_CHARCONV
+    auto result = std::to_chars(buffer, buffer + 24, value);
+    return static_cast<size_t>(result.ptr - buffer);
+#else
+    char text[32];
+    int length = snprintf(text, sizeof(text), "%lld", static_cast<long long>(value));
+    memcpy(buffer, text, length);
+    return static_cast<size_t>(length);
+#endif
+}
+
+#endif
@@ -27,11 +27,25 @@
 SVGWriter::SVGWriter(std::ostream &os, uint32_t width, uint32_t height)
     : m_svg(os),
       m_width(width),
-      m_height(height)
+      m_height(height),
+      m_databaseUnits(1000.0)
 {
     writeHeader();
 }
 
+SVGWriter* SVGWriter::open(const std::string &filename, uint32_t width, uint32_t height)
+{
+    std::unique_ptr<std::ofstream> os = openFile(filename);
+    if (!os)
+    {
+        return nullptr;
+    }
+
+    SVGWriter *writer = new SVGWriter(*os, width, height);
+    writer->m_ownedStream = std::move(os);
+    return writer;
+}
+
 SVGWriter::~SVGWriter()
 {
     m_svg.flush();    
@@ -55,64 +69,43 @@ std::complex<double> SVGWriter::toSVGCoordinates(std::complex<double> &p) const
     return std::complex<double>(p.real(), m_height - p.imag());
 }
 
-void SVGWriter::writeCell(const LayoutItem *item)
+/** drawing of a cell for an orientation: the rotation and
+    the orientation that gives the reference point. Flipped
+    cells are drawn unflipped, with a mirrored orientation mark. */
+struct orientation_t
 {
-    if (item == nullptr)
-    {
-        return;
-    }
-
-    double rot = 0.0;
-    double x = item->m_x;
-    double y = item->m_y;
+    double   m_rot;
+    orient_t m_unflipped;
+};
 
-    // regular cells have N,S,E,W,
-    // corner cells have NE,NW,SE,SW
-    if (item->m_location == "N")
-    {
-        // North orientation, rotation = 180 degrees
-        x += item->m_lefinfo->m_sx;
-        rot = 180.0;
-    }
-    else if (item->m_location == "S")
-    {
-        // South orientation, rotation = 0 degrees
-        //y += item->m_lefinfo->m_sy;
-    }
-    else if (item->m_location == "E")
-    {
-        // East orientation
-        rot = 90.0;
-    }
-    else if (item->m_location == "W")
-    {
-        // West 
-        y += item->m_lefinfo->m_sx;
-        rot = 270.0;
-    }
+/** orientations by cell orientation */
+static const orientation_t gs_orientations[ORIENT_COUNT] =
+{
+    /* N  */ {0.0,   ORIENT_N},
+    /* S  */ {180.0, ORIENT_S},
+    /* E  */ {270.0, ORIENT_E},
+    /* W  */ {90.0,  ORIENT_W},
+    /* FN */ {0.0,   ORIENT_N},
+    /* FS */ {180.0, ORIENT_S},
+    /* FE */ {90.0,  ORIENT_W},
+    /* FW */ {270.0, ORIENT_E}
+};
+
+void SVGWriter::writeCell(const PlacedCell &cell)
+{
+    const orientation_t &orient = gs_orientations[cell.m_orient];
+    double rot = orient.m_rot;
 
-    // do corners
-    if (item->m_location == "NW")
-    {
-        // North West orientation, rotation = 270 degrees
-        rot = 270.0;
-    }
-    else if (item->m_location == "SE")
-    {
-        // South East orientation, rotation = 90 degrees
-        x += item->m_lefinfo->m_sy;
-        rot = 90.0;
-    }
-    else if (item->m_location == "NE")
-    {
-        x += item->m_lefinfo->m_sx;
-        rot = 180.0;
-    }
+    // reference point in microns
+    dbu_t dx, dy;
+    cell.getOriginOffset(orient.m_unflipped, dx, dy);
+    double x = static_cast<double>(cell.m_x + dx) / m_databaseUnits;
+    double y = static_cast<double>(cell.m_y + dy) / m_databaseUnits;
 
     std::complex<double> ll = {0.0,0.0};
-    std::complex<double> ul = {0.0,item->m_lefinfo->m_sy};
-    std::complex<double> ur = {item->m_lefinfo->m_sx,item->m_lefinfo->m_sy};
-    std::complex<double> lr = {item->m_lefinfo->m_sx,0.0};
+    std::complex<double> ul = {0.0,cell.m_lefinfo->m_sy};
+    std::complex<double> ur = {cell.m_lefinfo->m_sx,cell.m_lefinfo->m_sy};
+    std::complex<double> lr = {cell.m_lefinfo->m_sx,0.0};
 
     std::complex<double> rr = {cos(3.1415927*rot/180.0), sin(3.1415927*rot/180.0)};
 
@@ -151,11 +144,11 @@ void SVGWriter::writeCell(const LayoutItem *item)
 
     //m_svg << "<rect x=\"" << x << "\" y=\"" << m_height-y << "\" ";
     //m_svg << "width=\"" << sx << "\" height=\"" << sy << "\" ";
-    if (item->m_ltype == LayoutItem::TYPE_FILLER)
+    if (cell.m_ltype == LayoutItem::TYPE_FILLER)
     {
         m_svg << "style=\"fill:#BFE1F3;stroke:#179AA9;stroke-width:0.25\" />\n";
     }
-    else if (item->m_ltype == LayoutItem::TYPE_BOND)
+    else if (cell.m_ltype == LayoutItem::TYPE_BOND)
     {
         m_svg << "style=\"fill:#66fc03;stroke:#000000;stroke-width:0.75\" />\n";
     }
@@ -166,14 +159,14 @@ void SVGWriter::writeCell(const LayoutItem *item)
 
     // show cell orientation
     {
-        double sw = item->m_lefinfo->m_sx * 0.2;
+        double sw = cell.m_lefinfo->m_sx * 0.2;
         std::complex<double> p1 = {sw,0};
         std::complex<double> p2 = {0.0,sw};
         
-        if (item->m_flipped)
+        if (cell.m_flipped)
         {
-            p1 = {item->m_lefinfo->m_sx - sw,0};
-            p2 = {item->m_lefinfo->m_sx, sw};
+            p1 = {cell.m_lefinfo->m_sx - sw,0};
+            p2 = {cell.m_lefinfo->m_sx, sw};
         }
 
         p1 *= rr;
@@ -191,19 +184,15 @@ void SVGWriter::writeCell(const LayoutItem *item)
         m_svg << "style=\"stroke:#F25844;stroke-width:0.75\" />\n";
     }
 
-    if (item->m_ltype == LayoutItem::TYPE_CORNER)
+    if (cell.m_ltype == LayoutItem::TYPE_CORNER)
     {
         m_svg << "<circle cx=\"" << ll.real() << "\" cy=\"" << ll.imag() <<  "\" r=\"" << 5.0 << "\" style=\"fill:#000000\" />\n";
     }
 
     std::complex<double> center = (ll + ur) / 2.0;
-    if (item->m_ltype != LayoutItem::TYPE_FILLER)
+    if (cell.m_ltype != LayoutItem::TYPE_FILLER)
     {
-        m_svg << "<text text-anchor=\"middle\" x=\"" << center.real() << "\" y=\"" << center.imag() << "\" font-size=\"2em\">" << item->m_cellname << "</text>\n";
-<<<<<<< HEAD
-        m_svg << "<text text-anchor=\"middle\" x=\"" << center.real() << "\" y=\"" << center.imag()+30 << "\" font-size=\"2em\">" << item->m_instance << "</text>\n";
-=======
-        m_svg << "<text text-anchor=\"middle\" x=\"" << center.real() << "\" y=\"" << center.imag()+20 << "\" font-size=\"2em\">" << item->m_instance << "</text>\n";
->>>>>>> 5a94695d01bec3fdd5f419581f490a519e30f98e
+        m_svg << "<text text-anchor=\"middle\" x=\"" << center.real() << "\" y=\"" << center.imag() << "\" font-size=\"2em\">" << cell.getCellName() << "</text>\n";
+        m_svg << "<text text-anchor=\"middle\" x=\"" << center.real() << "\" y=\"" << center.imag()+30 << "\" font-size=\"2em\">" << cell.getInstanceName() << "</text>\n";
     }
 }
@@ -26,15 +26,33 @@
 #include <string>
 
 #include "layout.h"
+#include "outputsink.h"
 
 /** a very minimal SVG writer */
-class SVGWriter
+class SVGWriter : public OutputSink
 {
 public:
     SVGWriter(std::ostream &os, uint32_t width, uint32_t height);
     virtual ~SVGWriter();
 
-    void writeCell(const LayoutItem *item);
+    /** create a writer for a file.
+        returns nullptr if the file cannot be opened. */
+    static SVGWriter* open(const std::string &filename, uint32_t width, uint32_t height);
+
+    void writeCell(const PlacedCell &cell);
+
+    virtual void onBegin(uint32_t cellCount, double databaseUnits) override
+    {
+        m_databaseUnits = databaseUnits;
+    }
+
+    virtual void onCells(const PlacedCell *cells, size_t count) override
+    {
+        for(size_t i=0; i<count; i++)
+        {
+            writeCell(cells[i]);
+        }
+    }
 
 protected:
     std::complex<double> toSVGCoordinates(std::complex<double> &p) const;
@@ -45,6 +63,7 @@ protected:
     std::ostream &m_svg;
     uint32_t m_width;
     uint32_t m_height;
+    double   m_databaseUnits;   ///< database units per micron of the cells
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#include <stdexcept>
+#include <functional>
+#include "symboltable.h"
+
+/** initial number of slots of the name lookup, a power of two */
+static const size_t gs_initialLookupSize = 1024;
+
+std::atomic<SymbolTable*> SymbolTable::s_tables[SymbolTable::c_maxTables];
+
+SymbolTable::SymbolTable() : m_table(c_maxTables), m_count(0)
+{
+    // table 0 belongs to the global table, which also
+    // holds the names of tables that find no free slot.
+    global();
+    for(uint32_t i=1; i<c_maxTables; i++)
+    {
+        SymbolTable *expected = nullptr;
+        if (s_tables[i].compare_exchange_strong(expected, this, std::memory_order_acq_rel))
+        {
+            m_table = i;
+            break;
+        }
+    }
+    init();
+}
+
+SymbolTable::SymbolTable(uint32_t table) : m_table(table), m_count(0)
+{
+    s_tables[table].store(this, std::memory_order_release);
+    init();
+}
+
+SymbolTable::~SymbolTable()
+{
+    if ((m_table != 0) && (m_table < c_maxTables))
+    {
+        s_tables[m_table].store(nullptr, std::memory_order_release);
+    }
+}
+
+void SymbolTable::init()
+{
+    for(uint32_t i=0; i<c_maxChunks; i++)
+    {
+        m_chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    // index 0 of every table is the empty name,
+    // which is always returned as SYMBOL_EMPTY.
+    std::string_view *chunk = m_arena.createArray<std::string_view>(c_chunkSize);
+    chunk[0] = m_arena.copyString("");
+    m_chunks[0].store(chunk, std::memory_order_release);
+    m_count.store(1, std::memory_order_release);
+
+    m_lookup.assign(gs_initialLookupSize, 0);
+}
+
+void SymbolTable::growLookup()
+{
+    std::vector<uint32_t> lookup(m_lookup.size() * 2, 0);
+    const size_t mask = lookup.size() - 1;
+    const uint32_t count = m_count.load(std::memory_order_relaxed);
+    for(uint32_t index=1; index<count; index++)
+    {
+        size_t slot = std::hash<std::string_view>()(getName(index)) & mask;
+        while(lookup[slot] != 0)
+        {
+            slot = (slot + 1) & mask;
+        }
+        lookup[slot] = index;
+    }
+    m_lookup.swap(lookup);
+}
+
+symbol_t SymbolTable::intern(const std::string_view &name)
+{
+    if (name.empty())
+    {
+        return SYMBOL_EMPTY;
+    }
+    if (m_table >= c_maxTables)
+    {
+        return global().intern(name);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    symbol_t tableBits = m_table << c_indexBits;
+    const size_t mask = m_lookup.size() - 1;
+    size_t slot = std::hash<std::string_view>()(name) & mask;
+    while(m_lookup[slot] != 0)
+    {
+        if (getName(m_lookup[slot]) == name)
+        {
+            return tableBits | m_lookup[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t index = m_count.load(std::memory_order_relaxed);
+    uint32_t chunkIndex = index >> c_chunkBits;
+    if (chunkIndex >= c_maxChunks)
+    {
+        throw std::length_error("SymbolTable: too many symbols");
+    }
+
+    std::string_view *chunk = m_chunks[chunkIndex].load(std::memory_order_relaxed);
+    if (chunk == nullptr)
+    {
+        chunk = m_arena.createArray<std::string_view>(c_chunkSize);
+        m_chunks[chunkIndex].store(chunk, std::memory_order_release);
+    }
+
+    std::string_view stored = m_arena.copyString(name);
+    chunk[index & (c_chunkSize-1)] = stored;
+
+    // publish the new entry
+    m_count.store(index + 1, std::memory_order_release);
+
+    // keep the lookup at most half full
+    m_lookup[slot] = index;
+    if (static_cast<size_t>(index + 1) * 2 > m_lookup.size())
+    {
+        growLookup();
+    }
+    return tableBits | index;
+}
+
+SymbolTable& SymbolTable::global()
+{
+    static SymbolTable table(0);
+    return table;
+}
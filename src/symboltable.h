@@ -0,0 +1,139 @@
+/*
+    PADRING -- a padring generator for ASICs.
+
+    Copyright (c) 2019, Niels Moseley <niels@symbioticeda.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+    
+*/
+
+#ifndef symboltable_h
+#define symboltable_h
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "arena.h"
+
+/** compact ID of an interned name */
+typedef uint32_t symbol_t;
+
+/** Interns names into compact IDs.
+
+    Looking up the name of a symbol is lock-free and can be
+    done from any thread. Interning takes a lock. Names are
+    stored zero-terminated and live as long as the table.
+
+    All tables share one ID space: the top bits of an ID
+    select the table, so symbolName() finds the name of a
+    symbol of any table. The global table holds the names
+    that live as long as the program, such as LEF cell names.
+    Names that belong to one configuration go in a table
+    owned by it, so they are freed with the configuration.
+*/
+class SymbolTable
+{
+public:
+    /** create a table with its own IDs. If all c_maxTables
+        tables are in use, it adds to the global table instead. */
+    SymbolTable();
+    virtual ~SymbolTable();
+
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable& operator=(const SymbolTable &) = delete;
+
+    /** the empty name always has ID 0 */
+    static const symbol_t SYMBOL_EMPTY = 0;
+
+    /** return the ID of a name, adding it if needed */
+    symbol_t intern(const std::string_view &name);
+
+    /** return the name of a symbol of this table */
+    std::string_view getName(symbol_t id) const
+    {
+        uint32_t index = id & c_indexMask;
+        const std::string_view *chunk = m_chunks[index >> c_chunkBits].load(std::memory_order_acquire);
+        return chunk[index & (c_chunkSize-1)];
+    }
+
+    /** return the name of a symbol of any table. The
+        table must not be destroyed while this runs. */
+    static std::string_view lookup(symbol_t id)
+    {
+        return s_tables[id >> c_indexBits].load(std::memory_order_acquire)->getName(id);
+    }
+
+    /** number of symbols, including the empty name */
+    uint32_t size() const
+    {
+        return m_count.load(std::memory_order_acquire);
+    }
+
+    /** the program-wide symbol table */
+    static SymbolTable& global();
+
+    /** the most tables that can exist at the same time */
+    static const uint32_t c_maxTables = 256;
+
+protected:
+    /** the global table, which has the IDs of table 0 */
+    explicit SymbolTable(uint32_t table);
+
+    /** add the empty name and make the table findable */
+    void init();
+
+    /** double the size of m_lookup */
+    void growLookup();
+
+    static const uint32_t c_indexBits = 24;     ///< bits of an ID that index a table
+    static const symbol_t c_indexMask = (1u << c_indexBits) - 1;
+    static const uint32_t c_chunkBits = 12;
+    static const uint32_t c_chunkSize = 1 << c_chunkBits;
+    static const uint32_t c_maxChunks = 1 << (c_indexBits - c_chunkBits);
+    static_assert(c_maxTables == (1ull << (32 - c_indexBits)), "table and index bits must fill a symbol_t");
+
+    /** the tables by the top bits of their IDs */
+    static std::atomic<SymbolTable*> s_tables[c_maxTables];
+
+    uint32_t    m_table;    ///< index in s_tables, c_maxTables if full
+    std::mutex  m_mutex;    ///< protects interning
+    Arena       m_arena;    ///< storage for names and chunks
+
+    /** open addressing hash of the indices of the names, 0 is
+        a free slot. Unlike a node-based map it does not allocate 
+        per name, which matters for a table per configuration. */
+    std::vector<uint32_t> m_lookup;
+
+    /** names by ID, in fixed-size chunks so
+        existing entries never move. */
+    std::atomic<std::string_view*> m_chunks[c_maxChunks];
+    std::atomic<uint32_t>          m_count;
+};
+
+/** intern a name in the global symbol table */
+inline symbol_t internSymbol(const std::string_view &name)
+{
+    return SymbolTable::global().intern(name);
+}
+
+/** name of a symbol of any symbol table.
+    The name is zero-terminated. */
+inline std::string_view symbolName(symbol_t id)
+{
+    return SymbolTable::lookup(id);
+}
+
+#endif
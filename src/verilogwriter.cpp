@@ -27,14 +27,30 @@
 #include "verilogwriter.h"
 
 VerilogWriter::VerilogWriter(std::ostream &os)
-    : m_def(os), m_firstever(true)
+    : m_def(os), m_firstever(true), m_written(false), m_fillerCount(0)
 {
 }
 
+VerilogWriter* VerilogWriter::open(const std::string &filename)
+{
+    std::unique_ptr<std::ofstream> os = openFile(filename);
+    if (!os)
+    {
+        return nullptr;
+    }
+
+    VerilogWriter *writer = new VerilogWriter(*os);
+    writer->m_ownedStream = std::move(os);
+    return writer;
+}
+
 VerilogWriter::~VerilogWriter()
 {
-    m_def.flush();    
-    writeToFile();
+    if (!m_written)
+    {
+        m_def.flush();    
+        writeToFile();
+    }
 }
 
 void VerilogWriter::writeToFile()
@@ -64,41 +80,118 @@ void VerilogWriter::writeToFile()
     m_def << "endmodule\n";
 }
 
-void VerilogWriter::writeCell(const LayoutItem *item)
+void VerilogWriter::writeNetlist(const cellSource_t &cells)
+{
+    assert(!m_designName.empty());
+
+    m_written = true;
+
+    // write one section of the module by
+    // visiting all the cells.
+    auto writeAll = [&](section_t section)
+    {
+        m_fillerCount = 0;
+        cells([&](const PlacedCell &cell)
+        {
+            writeSection(m_def, section, cell, getInstanceName(cell));
+        });
+    };
+
+    m_def << "`timescale 1ps/1ps\n";
+    m_def << "module " << m_designName << " (\n";
+
+    m_firstever = true;
+    writeAll(SECTION_PORTS);
+    
+    m_def << ");\n\n";
+    
+    m_def << "// Direction phase \n";
+    writeAll(SECTION_DIRECTIONS);
+    
+    m_def << "\n";
+
+    m_def << "// Variable phase \n";
+    writeAll(SECTION_WIRES);
+    
+    m_def << "\n";
+
+    m_def << "// Instantiation phase \n";
+    writeAll(SECTION_INSTANCES);
+
+    m_def << "endmodule\n";
+    m_def.flush();
+}
+
+std::string VerilogWriter::getInstanceName(const PlacedCell &cell)
+{
+    if (cell.m_ltype == LayoutItem::TYPE_FILLER)
+    {
+        return "FILLER_" + std::to_string(m_fillerCount++);
+    }
+    return std::string(cell.getInstanceName());
+}
+
+void VerilogWriter::writeCell(const PlacedCell &cell)
+{
+    std::string instance = getInstanceName(cell);
+
+    writeSection(m_ss_header, SECTION_PORTS, cell, instance);
+    writeSection(m_ss_dirs, SECTION_DIRECTIONS, cell, instance);
+    writeSection(m_ss_vars, SECTION_WIRES, cell, instance);
+    writeSection(m_ss_body, SECTION_INSTANCES, cell, instance);
+}
+
+void VerilogWriter::writeSection(std::ostream &os, section_t section, 
+    const PlacedCell &cell, const std::string &instance)
 {
     // First, do the instantiation
-    m_ss_body << "  " << item->m_cellname << " " << item->m_instance << "(";
+    if (section == SECTION_INSTANCES)
+    {
+        os << "  " << cell.getCellName() << " " << instance << "(";
+    }
     
     // First, get all the pins, and write header and vars
     bool first = true;
-    for(auto it: item->m_lefinfo->m_pins) {
+    for(auto const &pin: cell.m_lefinfo->m_pins) {
         // Avoid all non-signal
-        if(it.second->m_use != 0) continue;
+        if(pin.m_use != 0) continue;
         
         // The var name
-        std::string varName = item->m_instance + "_" + it.first;
-        
-        // Put it in the dirs
-        m_ss_dirs << "  ";
-        if(it.second->m_dir == 0) m_ss_dirs << "input ";
-        if(it.second->m_dir == 1) m_ss_dirs << "output ";
-        if(it.second->m_dir == 2) m_ss_dirs << "inout ";
-        m_ss_dirs << varName << ";\n";
-        
-        // Put it in the vars
-        m_ss_vars << "  wire " << varName << ";\n";
+        std::string varName = instance + "_";
+        varName += pin.m_name;
         
-        // Put it in the header
-        if(!m_firstever) m_ss_header << ",\n";
-        m_ss_header << "  " << varName;
-        m_firstever = false;
-        
-        // Put it in the body
-        if(!first) m_ss_body << ", ";
-        m_ss_body << "." << it.first << "(" << varName << ")";
-        first = false;
+        switch(section)
+        {
+        case SECTION_DIRECTIONS:
+            // Put it in the dirs
+            os << "  ";
+            if(pin.m_dir == 0) os << "input ";
+            if(pin.m_dir == 1) os << "output ";
+            if(pin.m_dir == 2) os << "inout ";
+            os << varName << ";\n";
+            break;
+        case SECTION_WIRES:
+            // Put it in the vars
+            os << "  wire " << varName << ";\n";
+            break;
+        case SECTION_PORTS:
+            // Put it in the header
+            if(!m_firstever) os << ",\n";
+            os << "  " << varName;
+            m_firstever = false;
+            break;
+        case SECTION_INSTANCES:
+            // Put it in the body
+            if(!first) os << ", ";
+            os << "." << pin.m_name << "(" << varName << ")";
+            first = false;
+            break;
+        }
     }
     
     // Close the current instantiation
-    m_ss_body << ");\n";
+    if (section == SECTION_INSTANCES)
+    {
+        os << ");\n";
+    }
 }
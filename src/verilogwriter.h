@@ -28,21 +28,59 @@
 #include <sstream>
 
 #include "layout.h"
+#include "outputsink.h"
 
 /** a very minimal SVG writer */
-class VerilogWriter
+class VerilogWriter : public OutputSink
 {
 public:
     VerilogWriter(std::ostream &os);
     virtual ~VerilogWriter();
 
-    void writeCell(const LayoutItem *item);
+    /** create a writer for a file.
+        returns nullptr if the file cannot be opened. */
+    static VerilogWriter* open(const std::string &filename);
+
+    /** add a cell to the netlist. The netlist is kept
+        in memory and written when the writer is destroyed. */
+    void writeCell(const PlacedCell &cell);
+
     void setDesignName(const std::string &designName)
     {
         m_designName = designName;
     }
 
+    /** write the netlist of all cells straight to the output.
+        The cells are visited once for each section of the
+        module (ports, directions, wires and instances), so
+        nothing is kept in memory. Do not use together with
+        writeCell.
+    */
+    void writeNetlist(const cellSource_t &cells);
+
+    /** the netlist is written when all cells are known */
+    virtual void onFinish(const cellSource_t &cells) override
+    {
+        writeNetlist(cells);
+    }
+
 protected:
+    enum section_t
+    {
+        SECTION_PORTS,
+        SECTION_DIRECTIONS,
+        SECTION_WIRES,
+        SECTION_INSTANCES
+    };
+
+    /** get the instance name of a cell. Fillers are not named
+        in the layout, they are numbered in the order they are 
+        written. */
+    std::string getInstanceName(const PlacedCell &cell);
+
+    /** write the part of a module section that belongs to a cell */
+    void writeSection(std::ostream &os, section_t section, 
+        const PlacedCell &cell, const std::string &instance);
 
     void writeToFile();
 
@@ -53,6 +91,8 @@ protected:
     std::string         m_designName;
     std::ostream        &m_def;
     bool                m_firstever;
+    bool                m_written;      ///< netlist has been written by writeNetlist
+    uint32_t            m_fillerCount;  ///< number of filler cells written
 };
 
 #endif
@@ -8,6 +8,11 @@ tests = [["noarea.config", "iocells.lef", 1],
          ["syntax.config", "iocells.lef", 1],
          ["threecorners.config", "iocells.lef", 0],
          ["fillerexit.config", "iocells_nofiller1.lef", 1],
+         ["fillergap.config", "iocells_nofiller1.lef", 0],
+         ["fillercap.config", "iocells.lef", 0],
+         ["range.config", "iocells.lef", 0],
+         ["rangeerror.config", "iocells.lef", 1],
+         ["rangelimit.config", "iocells.lef", 1],
          ["nonsquarecorners.config", "nonsquarecorners.lef", 0]
 ]
 
@@ -24,5 +29,18 @@ for test in tests:
         failed = failed + 1
         print(test[0] + (' '*spaces) + "*** FAIL ***")
 
+# a REPEAT block sent to the daemon: its 'END;' must not
+# end the CONFIG request.
+with open("range.config") as f:
+    request = "CONFIG\n" + f.read() + "END\nQUIT\n"
+daemon = subprocess.run(["../build/padring", "--daemon", "--svg", "padring.svg", "--lef", "iocells.lef", "threecorners.config"],
+    input=request, stdout=subprocess.PIPE, stderr=FNULL, universal_newlines=True)
+replies = [line for line in daemon.stdout.splitlines() if line.startswith("OK") or line.startswith("ERROR")]
+if (len(replies) == 2) and replies[0].startswith("OK ") and (replies[1] == "OK"):
+    print("daemon range.config" + (' '*11) + "OK!")
+else:
+    failed = failed + 1
+    print("daemon range.config" + (' '*11) + "*** FAIL ***")
+
 print("\nFailed tests: " + str(failed))
 